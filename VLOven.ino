@@ -17,10 +17,11 @@
 */
 #include <arduino.h>
 #include <TextConsole.h>
-#include <EEPROM.h>
 #include <avr/pgmspace.h>
 #include <SoftReset.h>
 #include "utils.h"
+#include "VLOvenCommands.h"
+#include "VLOvenEEPROM.h"
 #include "VLOvenShield.h"
 #include "VLOvenController.h"
 
@@ -65,10 +66,8 @@
  * -# [Arduino PID  Library] (https://github.com/br3ttb/Arduino-PID-Library.git)
  * by <b>[Brett Beauregard](www.brettbeauregard.com)</b>.
  * -# [GPIOKey Library] (https://github.com/VLorz/GPIOKey.git) by Victor Lorenzo (EDesignsForge).
- * -# [GPIOToggler Library] (https://github.com/VLorz/GPIOToggler.git) by Victor Lorenzo (EDesignsForge).
  * -# [TextConsole Library] (https://github.com/VLorz/TextConsole.git) by Victor Lorenzo (EDesignsForge).
- * -# [GPIOLed Library] (https://github.com/VLorz/GPIOLed.git) by Victor Lorenzo (EDesignsForge). This library
- * was used just for convenience as its functionality is only a subset from the GPIOToggler's library functionality.
+ * -# [GPIOLed Library] (https://github.com/VLorz/GPIOLed.git) by Victor Lorenzo (EDesignsForge).
  * -# [RunningAverage library for Arduino] (https://github.com/RobTillaart/Arduino/tree/master/libraries/RunningAverage) by Rob Tillaart.
  * -# [SoftReset software reset library for Arduino] (https://github.com/WickedDevice/SoftReset.git) by WickedDevice.
  * 
@@ -88,6 +87,10 @@
  * -# 4 x keys keyboard.
  * -# 2 x red color indicator leds.
  * -# 1 x 70A, 230V SSR with input control voltage ranging from 5V to 30V.
+ * -# Optional mains zero-cross detector, see #PIN_ZEROCROSS.
+ * -# Optional additional heater elements and convection fan, see #HEATER_CHANNELS and #PIN_FAN.
+ * -# Optional MAX31855 or MAX6675 SPI thermocouple converters replacing the analog amplifier, see #TC_CHANNEL_TYPES.
+ * -# Optional cold junction sensor for thermocouple amplifiers without cold junction compensation, see #TC_COLD_JUNCTION_PIN.
  *  
  *  All definitions for the hardware abstraction layer (<b>HAL</b>) can be found 
  *  in file VLOvenShield.h
@@ -113,9 +116,27 @@
 
 #define PROFILE_NAME_LENGTH       (20)            /*!< \brief Number of chars for storing profile names. */
 #define EEPROM_SIGNATURE_LENGTH   (9)             /*!< \brief Number of chars for storing the EEPROM signature. */
+#define EEPROM_LAYOUT_VERSION     (6)             /*!< \brief EEPROM data layout version, increased on every incompatible layout change. */
+
+#define PROFILE_EDIT_REQUESTS     (5)             /*!< \brief EEPROM write requests queued by a profile edit. */
+
+#define BATCH_QUEUE_LENGTH        (4)             /*!< \brief Number of jobs the batch queue holds. */
+#define BATCH_LOAD_TEMPERATURE    (50.0)          /*!< \brief Default temperature in degrees C the oven must cool below before the next batch run starts. */
+
+#define TEXT_START_SAFETYFAULT    "Safety fault"  /*!< \brief Error reason when a profile can't start because of a latched safety fault. */
+#define TEXT_START_NOTEMP         "No reading"    /*!< \brief Error reason when a profile can't start without a temperature reading. */
+
+#define BENCHMARK_CALLS           (100)           /*!< \brief Default number of calls timed per function by the benchmark command. */
+#define BENCHMARK_MAX_CALLS       (1000)          /*!< \brief Highest number of calls timed per function by the benchmark command. */
+#define BENCHMARK_CHUNK_CALLS     (10)            /*!< \brief Number of calls timed back to back, the controller cycle runs between chunks. */
 
 #define EEPROM_SIGNATURE_OFFSET   0               /*!< \brief EEPROM location of the EEPROM signature. */
 #define EEPROM_APPDATA_OFFSET     (EEPROM_SIGNATURE_OFFSET + sizeof(EEPROMSignature_t)) /*!< \brief EEPROM location for the application non-volatile data. */
+#define EEPROM_END                (E2END + 1)     /*!< \brief EEPROM size. */
+#define EEPROM_ENERGY_OFFSET      (EEPROM_END - VLOvenEnergy::getStorageSize()) /*!< \brief EEPROM location of the heater lifetime counters, at the very end. */
+#define EEPROM_HISTORY_OFFSET     (EEPROM_ENERGY_OFFSET - VLOvenHistory::getStorageSize()) /*!< \brief EEPROM location of the run history, below the lifetime counters. */
+#define EEPROM_SETTINGS_OFFSET    (EEPROM_HISTORY_OFFSET - VLOvenSettings::getStorageSize()) /*!< \brief EEPROM location of the controller settings, below the run history. */
+#define EEPROM_PROFILES_END       EEPROM_SETTINGS_OFFSET /*!< \brief End of the EEPROM space for temperature control profiles. */
 
 
 /*!
@@ -125,6 +146,7 @@
 typedef struct 
 {
   char Signature[ EEPROM_SIGNATURE_LENGTH ];      /*!< \brief EEPROM data signature. */
+  uint8_t Version;                                /*!< \brief EEPROM data layout version, see #EEPROM_LAYOUT_VERSION. */
 } EEPROMSignature_t;
 
 
@@ -137,6 +159,7 @@ typedef struct
 {
   char Name[ PROFILE_NAME_LENGTH ];               /*!< \brief Meaningful name for the temperature control profile. */
   int PhasesCount;                                /*!< \brief Number of phases conforming the temperature control profile. */
+  VLOvenQualityLimits_t Limits;                   /*!< \brief Quality limits every run of the profile is checked against. */
 } ProfileHeader_t;
 
 
@@ -165,12 +188,39 @@ typedef struct
 } ProfileInfo_t;
 
 
+/*!
+ * \brief Profile edit in progress.
+ * Deleting, replacing or appending a profile moves the profiles following it and writes the new one through
+ * the EEPROM write queue. The profiles list ends at the edited profile until the edit completes.
+ */
+typedef struct
+{
+  bool Active;                                    /*!< \brief An edit is in progress. */
+  int Index;                                      /*!< \brief Index of the edited profile. */
+  uint8_t First;                                  /*!< \brief Byte written at the profile location once everything else is in place. */
+  const ProfileInfo_t* lpProfile;                 /*!< \brief Profile written, \c NULL when deleting. */
+} ProfileEdit_t;
+
+
+/*!
+ * \brief Batch job definition.
+ * This structure holds a queued request for running one temperature control profile a number of times.
+ */
+typedef struct
+{
+  int ProfileIndex;                               /*!< \brief Index of the profile to run. */
+  unsigned int Runs;                              /*!< \brief Number of runs requested. */
+  unsigned int Done;                              /*!< \brief Number of runs completed so far. */
+} BatchJob_t;
+
+
 /*!
  * \brief Default EEPROM signature used for this application.
  */
 static const EEPROMSignature_t DefaultSignature =
 {
-  Signature : { 'V', 'L', 'R', 'e', 'f', 'l', 'o', 'w', '\0' }
+  Signature : { 'V', 'L', 'R', 'e', 'f', 'l', 'o', 'w', '\0' },
+  Version :   EEPROM_LAYOUT_VERSION
 };
 
 
@@ -179,6 +229,13 @@ void CmdReadInput( TextConsole* lpSilly );      /*!< Forward Declaration: Handle
 void CmdProfiles( TextConsole* lpSilly );       /*!< Forward Declaration: Handler for 'p' interpreter command. */
 void CmdEEPROM( TextConsole* lpSilly );         /*!< Forward Declaration: Handler for 'e' interpreter command. */
 void CmdReset( TextConsole* lpSilly );          /*!< Forward Declaration: Handler for 'rst' interpreter command. */
+void CmdSafety( TextConsole* lpSilly );         /*!< Forward Declaration: Handler for 's' interpreter command. */
+void CmdSimulator( TextConsole* lpSilly );      /*!< Forward Declaration: Handler for 'sim' interpreter command. */
+void CmdQueue( TextConsole* lpSilly );          /*!< Forward Declaration: Handler for 'q' interpreter command. */
+void CmdHistory( TextConsole* lpSilly );        /*!< Forward Declaration: Handler for 'h' interpreter command. */
+void CmdSettings( TextConsole* lpSilly );       /*!< Forward Declaration: Handler for 'c' interpreter command. */
+void CmdBenchmark( TextConsole* lpSilly );      /*!< Forward Declaration: Handler for 'bm' interpreter command. */
+bool ActivateProfile( int ProfileIndex );       /*!< Forward Declaration: Loads and selects a temperature control profile. */
 
 
 /*! 
@@ -191,6 +248,12 @@ static const struct ConsoleCommandEntry  CommandEntries[] =
   { "p",        CmdProfiles },
   { "e",        CmdEEPROM },
   { "rst",      CmdReset },
+  { "s",        CmdSafety },
+  { "sim",      CmdSimulator },
+  { "q",        CmdQueue },
+  { "h",        CmdHistory },
+  { "c",        CmdSettings },
+  { "bm",       CmdBenchmark },
   { NULL,       NULL }
 };
 
@@ -205,13 +268,6 @@ static const struct ConsoleCommandEntry  CommandEntries[] =
   "    this help" TEXTCONSOLE_EOLN
   
 
-/*! \brief Default KP parameter (proportional gain) for the PID controller */
-#define PID_KP  300
-/*! \brief Default KI parameter (integral gain) for the PID controller */
-#define PID_KI  0.05
-/*! \brief Default KD parameter (derivative gain) for the PID controller */
-#define PID_KD  250
-
 /*! \brief Phases list definition for acting as a reflow oven. 
  * Values provided here configure the oven controller for
  * going through the different phases required for reflow soldering.
@@ -313,7 +369,8 @@ static const ProfileHeader_t OVENCONTROLLER_PROFILEHEADER =
 
 static const ProfileHeader_t PBFREEREFLOWCONTROLLER_PROFILEHEADER PROGMEM = {
   Name :          { 'P', 'b', 'F', 'r', 'e', 'e', ' ', '-', ' ', 'R', 'e', 'f', 'l', 'o', 'w', '\0' },
-  PhasesCount :   sizeof(PBFREEREFLOWCONTROLLER_PHASES) / sizeof(PBFREEREFLOWCONTROLLER_PHASES[0])
+  PhasesCount :   sizeof(PBFREEREFLOWCONTROLLER_PHASES) / sizeof(PBFREEREFLOWCONTROLLER_PHASES[0]),
+  Limits :        { PeakMin : 235, PeakMax : 255, TALMin : 30, TALMax : 90, HeatingRateMax : 30, CoolingRateMax : 60, SettlingTimeMax : 0 }
 };
 
 
@@ -333,13 +390,57 @@ VLOvenShield      m_Shield;
 VLOvenController  m_Controller( m_Shield, m_Console );
 
 /*! \brief Current temperature control profile selector. 
- * This variable holds an index into the temperature control profiles list, it points to the currently selected temperature control profile. */
-unsigned int        m_CurrentProfileIndex;
+ * This variable holds an index into the temperature control profiles list, it points to the currently selected temperature control profile,
+ * \c -1 when there is none. */
+int                 m_CurrentProfileIndex;
 
 /*! \brief Current temperature profile control parameters.
  * This variable holds currently active profile definition parameters. */
 ProfileInfo_t       m_ActiveProfile;
 
+/*! \brief Profile being uploaded from the console.
+ * Staged in SRAM until committed to EEPROM, #ProfileInfo_t::lpPhases is \c NULL while no upload is in progress. */
+ProfileInfo_t       m_Upload;
+
+/*! \brief Number of phases allocated for #m_Upload. */
+uint8_t             m_UploadCount;
+
+/*! \brief Phases of #m_Upload received so far, one bit per phase. */
+uint16_t            m_UploadReceived;
+
+/*! \brief Profile edit in progress, see #StartProfileEdit(). */
+ProfileEdit_t       m_Edit;
+
+/*! \brief Run history store.
+ * Keeps the records of the last runs in EEPROM. */
+VLOvenHistory       m_History;
+
+/*! \brief Controller settings store.
+ * Keeps the tunable controller settings in EEPROM. */
+VLOvenSettings      m_Settings;
+
+/*! \brief Batch jobs queue.
+ * Jobs run in order, the job at index \c 0 is the current one. */
+BatchJob_t          m_BatchJobs[ BATCH_QUEUE_LENGTH ];
+
+/*! \brief Number of jobs in #m_BatchJobs. */
+uint8_t             m_BatchCount = 0;
+
+/*! \brief Temperature the oven must cool below before the next batch run starts. */
+float               m_BatchLoadTemp = BATCH_LOAD_TEMPERATURE;
+
+/*! \brief The running process was started from the batch queue. */
+bool                m_BatchRunning = false;
+
+/*! \brief Time the oven became available for the next batch run. */
+unsigned long       m_BatchIdleTime;
+
+/*! \brief Time the oven waited before the running batch run started, in \b ms. */
+unsigned long       m_BatchWaitTime;
+
+/*! \brief Start time of the current batch job. */
+unsigned long       m_BatchJobStartTime;
+
 
 /*!
  * \brief Function used when requiring user confirmation.
@@ -414,8 +515,8 @@ int GetProfilesCount()
   int Offset = EEPROM_APPDATA_OFFSET;
   ProfileHeader_t Header;
 
-  while (Offset < (EEPROM.length() - sizeof(Header))) {
-    EEPROM.get( Offset, Header );
+  while (Offset < (EEPROM_PROFILES_END - sizeof(Header))) {
+    VLOvenEEPROM::get( Offset, Header );
 
     if (Header.Name[0] == 0)
       break;
@@ -461,50 +562,29 @@ bool AllocProfilePhases( ProfileInfo_t& ProfileInfo )
  * \brief Function used for checking the EEPROM memory signature.
  * \return Returns \c TRUE on successful completion, \c FALSE otherwise.
  * \remarks The EEPROM signature is stored by function #EEPROMFormat() on first program run or
- * by remote text console commands.
+ * by remote text console commands. EEPROM data written with a different layout version is rejected.
 */
 bool EEPROMCheckSignature()
 {
   EEPROMSignature_t Signature;
 
-  EEPROM.get( EEPROM_SIGNATURE_OFFSET, Signature );
+  VLOvenEEPROM::get( EEPROM_SIGNATURE_OFFSET, Signature );
 
-  return (strcmp( Signature.Signature, DefaultSignature.Signature ) == 0);
+  return (strcmp( Signature.Signature, DefaultSignature.Signature ) == 0) && (Signature.Version == DefaultSignature.Version);
 }
 
 
 /*! 
  * \brief Function used for formatting the EEPROM memory.
+ * \param KeepCounters When \c true the heater lifetime counters and the run history are preserved.
  * \remarks This function MUST be used with CAUTION. This function ERASES ALL THE EEPROM memory.
- * 
+ * The writes are queued, the EEPROM write queue must be empty. The signature goes last, a reset before the
+ * data is cleared leaves the EEPROM unformatted.
 */
-void EEPROMFormat()
-{
-  EEPROM.put( EEPROM_SIGNATURE_OFFSET, DefaultSignature );
-
-  for (int i = EEPROM_APPDATA_OFFSET ; i < EEPROM.length() ; i++) {
-    EEPROM.write( i, 0 );
-  }
-}
-
-
-/*! 
- * \brief Function used for copying data from SRAM to EEPROM memory.
- * \param lpSrc Buffer address of source data.
- * \param EEOffset EEPROM location (offset) for target data location in EEPROM.
- * \param Count Number of bytes to copy.
- * \remarks This function MUST be used with CAUTION, any prior data at target location WILL BE LOST.
- * 
-  */
-void CopyToEEPROM( uint8_t* lpSrc, int& EEOffset, int Count )
+void EEPROMFormat( bool KeepCounters = false )
 {
-  while (Count)
-  {
-    EEPROM.write( EEOffset, *lpSrc );
-    EEOffset++;
-    lpSrc++;
-    Count--;
-  }
+  VLOvenEEPROM::fill( EEPROM_APPDATA_OFFSET, 0, (KeepCounters ? EEPROM_PROFILES_END : EEPROM_END) - EEPROM_APPDATA_OFFSET );
+  VLOvenEEPROM::write( EEPROM_SIGNATURE_OFFSET, &DefaultSignature, sizeof(DefaultSignature) );
 }
 
 
@@ -518,8 +598,8 @@ int FindFreeEEPROMStart()
   ProfileHeader_t Header;
   int Offset = EEPROM_APPDATA_OFFSET;
 
-  while (Offset < (EEPROM.length() - sizeof(Header))) {
-    EEPROM.get( Offset, Header );
+  while (Offset < (EEPROM_PROFILES_END - sizeof(Header))) {
+    VLOvenEEPROM::get( Offset, Header );
 
     if (Header.Name[0] == 0)
       return Offset;
@@ -532,29 +612,6 @@ int FindFreeEEPROMStart()
 }
 
 
-/*! 
- * \brief Function used for appending a new temperature control profile at the end of the 
- * application data EEPROM.
- * \param lpProfile Reference to a variable containting a valid profile data structure.
- * \return Resturns \c TRUE on success, \c FALSE otherwise.
- */
-bool EEPROMAppendProfile( ProfileInfo_t* lpProfile )
-{
-  int Offset;
-
-  Offset = FindFreeEEPROMStart();
-  if (Offset <= 0)
-    return false;
-  
-  // >HEADER:
-  EEPROM.put( Offset, lpProfile->Header );
-  Offset += sizeof(lpProfile->Header);
-
-  // >PHASES:
-  CopyToEEPROM( (uint8_t*)lpProfile->lpPhases, Offset, lpProfile->Header.PhasesCount * sizeof(lpProfile->lpPhases[0]) );
-}
-
-
 /*! 
  * \brief Function used for copying data from program FLASH to SRAM.
  * \param dest Target buffer address in SRAM.
@@ -572,31 +629,42 @@ void copyPS( char* dest, const char* src, int count )
 }
 
 
+/*! 
+ * \brief Function used for queueing the write of a default profile straight from program FLASH.
+ * \param Offset EEPROM location of the profile, updated to the location following it.
+ * \param lpHeader Profile header in program FLASH.
+ * \param lpPhases Profile phases in program FLASH.
+ * \param lpCallback Function to call once the profile is written, if any.
+ * \remarks The first name byte goes last, as in #StartProfileEdit().
+  */
+void EEPROMWriteDefaultProfile( int& Offset, const ProfileHeader_t* lpHeader, const VLOvenControllerPhase_t* lpPhases,
+  VLOvenEEPROMCallback_t lpCallback = NULL )
+{
+  ProfileHeader_t Header;
+
+  copyPS( (char*)&Header, (const char*)lpHeader, sizeof(Header) );
+  VLOvenEEPROM::write_P( Offset + sizeof(Header), lpPhases, Header.PhasesCount * sizeof(lpPhases[0]) );
+  VLOvenEEPROM::write_P( Offset + 1, (const uint8_t*)lpHeader + 1, sizeof(Header) - 1 );
+  VLOvenEEPROM::write_P( Offset, lpHeader, 1, lpCallback );
+  Offset += sizeof(Header) + Header.PhasesCount * sizeof(lpPhases[0]);
+}
+
+
 /*! 
  * \brief Function used for registering the default profiles in application data EEPROM.
- * 
+ * \remarks It must follow #EEPROMFormat(), the profiles are written from the start of the application data
+ * without reading the list, which the queued format has not cleared yet.
+ * \param lpCallback Function to call once the profiles are written, if any.
   */
-void EEPROMRegisterDefaultProfiles()
+void EEPROMRegisterDefaultProfiles( VLOvenEEPROMCallback_t lpCallback = NULL )
 {
-  ProfileInfo_t ProfileInfo;
-  
-  // STD Oven controller profile.
-  copyPS( (char*)&ProfileInfo, (const char*)&OVENCONTROLLER_PROFILEHEADER, sizeof(ProfileInfo) );
-  if (AllocProfilePhases( ProfileInfo )) {
-    copyPS( (char*)ProfileInfo.lpPhases, (const char*)&OVENCONTROLLER_PHASES, ProfileInfo.Header.PhasesCount * sizeof(VLOvenControllerPhase_t) );
+  int Offset = EEPROM_APPDATA_OFFSET;
 
-    EEPROMAppendProfile( &ProfileInfo );
-    FreeProfile( ProfileInfo );
-  }
+  // STD Oven controller profile.
+  EEPROMWriteDefaultProfile( Offset, &OVENCONTROLLER_PROFILEHEADER, OVENCONTROLLER_PHASES );
 
   // Pb-Free reflow oven controller profile.
-  copyPS( (char*)&ProfileInfo, (const char*)&PBFREEREFLOWCONTROLLER_PROFILEHEADER, sizeof(ProfileInfo) );
-  if (AllocProfilePhases( ProfileInfo )) {
-    copyPS( (char*)ProfileInfo.lpPhases, (const char*)&PBFREEREFLOWCONTROLLER_PHASES, ProfileInfo.Header.PhasesCount * sizeof(VLOvenControllerPhase_t) );
-
-    EEPROMAppendProfile( &ProfileInfo );
-    FreeProfile( ProfileInfo );
-  }
+  EEPROMWriteDefaultProfile( Offset, &PBFREEREFLOWCONTROLLER_PROFILEHEADER, PBFREEREFLOWCONTROLLER_PHASES, lpCallback );
 }
 
 
@@ -611,8 +679,8 @@ int LoadProfileHeader( ProfileHeader_t& Header, int ProfileIndex )
   if (ProfileIndex >= 0) {
     int Offset = EEPROM_APPDATA_OFFSET;
 
-    while (Offset < (EEPROM.length() - sizeof(Header))) {
-      EEPROM.get( Offset, Header );
+    while (Offset < (EEPROM_PROFILES_END - sizeof(Header))) {
+      VLOvenEEPROM::get( Offset, Header );
 
       if (Header.Name[0] == 0)
         return -1;
@@ -651,7 +719,7 @@ bool LoadProfile( ProfileInfo_t& ProfileInfo, int ProfileIndex )
 
       while (Count--)
       {
-        EEPROM.get( Offset, *lpPhase );
+        VLOvenEEPROM::get( Offset, *lpPhase );
         Offset += sizeof(*lpPhase);
         lpPhase++;
       }
@@ -667,6 +735,111 @@ bool LoadProfile( ProfileInfo_t& ProfileInfo, int ProfileIndex )
 }
 
 
+/*! 
+ * \brief Function used for completing a profile edit, called once its last EEPROM write is done.
+ * \param lpContext Unused.
+*/
+void onProfileEdited( void* lpContext )
+{
+  m_Edit.Active = false;
+  if (m_Edit.lpProfile == &m_Upload)
+    FreeProfile( m_Upload );
+
+  // The active profile was replaced, the next run must not use the copy of the old one.
+  if ((m_Edit.lpProfile != NULL) && (m_Edit.Index == m_CurrentProfileIndex) && !m_Controller.getRuning())
+    ActivateProfile( m_Edit.Index );
+
+  m_Console.beginEvent();
+  m_Console.send( F("pedit[idx=") );
+  m_Console.send( m_Edit.Index );
+  m_Console.send( F(",del=") );
+  m_Console.send( m_Edit.lpProfile == NULL );
+  m_Console.send( F("]") );
+  m_Console.endEvent();
+}
+
+
+/*! 
+ * \brief Function used for starting to delete, replace or append a temperature control profile.
+ * \param Index Index of the profile to delete or replace, the number of profiles for appending one.
+ * \param lpProfile Profile to store, \c NULL for deleting. It must stay unchanged until the edit completes.
+ * \return Returns \c TRUE when the edit started, \c FALSE when another edit is in progress, the EEPROM write
+ * queue is busy, there is no profile to delete or replace, or the new profile does not fit.
+ * \remarks The edit goes on through the EEPROM write queue, #onProfileEdited() reports its completion. Until then
+ * the profiles list ends before the edited profile, a reset meanwhile loses that profile and the following ones,
+ * but leaves a valid list.
+ */
+bool StartProfileEdit( int Index, const ProfileInfo_t* lpProfile )
+{
+  ProfileHeader_t Header;
+  int Offset;
+  int End = FindFreeEEPROMStart();
+  int OldSize = 0;
+  int NewSize = 0;
+  int Source;
+  int Target;
+  int Length;
+
+  if (m_Edit.Active || (End < 0) || (VLOvenEEPROM::getFree() < PROFILE_EDIT_REQUESTS))
+    return false;
+
+  Offset = LoadProfileHeader( Header, Index );
+  if (Offset > 0)
+    OldSize = sizeof(Header) + Header.PhasesCount * sizeof(VLOvenControllerPhase_t);
+  else if ((lpProfile != NULL) && (Index == GetProfilesCount()))
+    Offset = End;
+  else
+    return false;
+
+  if (lpProfile != NULL)
+    NewSize = sizeof(lpProfile->Header) + lpProfile->Header.PhasesCount * sizeof(lpProfile->lpPhases[0]);
+
+  // Room for the new profile, and for the empty header ending the list.
+  if (End + NewSize - OldSize + sizeof(Header) > EEPROM_PROFILES_END)
+    return false;
+
+  // The following profiles move up to the name byte of the empty header ending the list.
+  Source = Offset + OldSize;
+  Target = Offset + NewSize;
+  Length = (Source != Target) ? End + 1 - Source : 0;
+  if (lpProfile == NULL)
+  {
+    // Deleting moves the next profile over the deleted one, its name byte goes last.
+    m_Edit.First = VLOvenEEPROM::read( Source );
+    Source++;
+    Target++;
+    Length--;
+  }
+  else
+    m_Edit.First = lpProfile->Header.Name[ 0 ];
+
+  m_Edit.Active = true;
+  m_Edit.Index = Index;
+  m_Edit.lpProfile = lpProfile;
+
+  // Requests complete in order: unlink, move, write all but the first byte, which links the profile again.
+  VLOvenEEPROM::fill( Offset, 0, 1 );
+  VLOvenEEPROM::move( Target, Source, Length );
+  if (lpProfile != NULL)
+  {
+    VLOvenEEPROM::write( Offset + 1, (const uint8_t*)&lpProfile->Header + 1, sizeof(lpProfile->Header) - 1 );
+    VLOvenEEPROM::write( Offset + sizeof(lpProfile->Header), lpProfile->lpPhases, lpProfile->Header.PhasesCount * sizeof(lpProfile->lpPhases[0]) );
+  }
+  VLOvenEEPROM::write( Offset, &m_Edit.First, 1, onProfileEdited );
+  return true;
+}
+
+
+/*! 
+ * \brief Function used for handing the settings in use to the shield and the oven controller.
+*/
+void ApplySettings()
+{
+  m_Shield.setAveragingSamples( m_Settings.get().AveragingSamples );
+  m_Controller.applySettings( m_Settings.get() );
+}
+
+
 /*!
  * \brief Standard Arduino system configuration and setup function.
  * This function is called once by the Arduino startup code during system initialization.
@@ -681,18 +854,25 @@ void setup()
   Serial.begin( 115200 );
   m_Console.begin( F("%Reflow oven controller!" TEXTCONSOLE_EOLN) );
 
+  // Ask() keeps the controller cycle running, the hardware must be set up before.
+  m_Shield.begin();
+  m_Controller.begin();
+
   if (!EEPROMCheckSignature() && Ask( F("Wrong EEPROM, init?"), &Result ))
   {
     EEPROMFormat();
     EEPROMRegisterDefaultProfiles();
+    VLOvenEEPROM::flush();
   }
 
   if (LoadProfile( m_ActiveProfile, 0 )) {
     m_CurrentProfileIndex = 0;
   }
   
-  m_Controller.SetPIDTunings( PID_KP, PID_KI, PID_KD );
-  m_Controller.begin();
+  m_Settings.begin( EEPROM_SETTINGS_OFFSET );
+  ApplySettings();
+  m_Controller.getEnergy().begin( EEPROM_ENERGY_OFFSET );
+  m_History.begin( EEPROM_HISTORY_OFFSET );
 
   // Now we're on control!
   m_Shield.getLed1().on();
@@ -707,14 +887,25 @@ void updateProfileInfo()
 {
   // Temperature control profile info.
   m_Shield.getLCD().setCursor( 0, 0 );
-  if (m_ActiveProfile.lpPhases != NULL)
-    sprintf( m_TextsBuffer, "%10s", m_ActiveProfile.Header.Name );
-  else
-    sprintf( m_TextsBuffer, "%10s", "" );
+  formatText( m_TextsBuffer, (m_ActiveProfile.lpPhases != NULL) ? m_ActiveProfile.Header.Name : NULL, 10 );
   m_Shield.getLCD().print( m_TextsBuffer );
 }
 
 
+/*!
+ * \brief Utility function for formatting a temperature into a LCD field.
+ * \param Temp Temperature in degrees C, \c NAN when not available.
+ * \param Width Field width, as for #formatText().
+*/
+void formatTemperature( double Temp, int8_t Width )
+{
+  if (isnan( Temp ))
+    formatText( m_TextsBuffer, "---.-C", Width );
+  else
+    formatFixed( m_TextsBuffer, lround( Temp * 10.0 ), 1, 1, Width, "C" );
+}
+
+
 void SendProfileInfo()
 {
   m_Console.beginEvent();
@@ -774,6 +965,125 @@ void setPrevProfile()
 }
 
 
+/*!
+ * \brief Utility function storing the record of every run ending in the run history.
+ * This function is called from the #loop() function.
+*/
+void doHistoryCycle()
+{
+  VLOvenRunRecord_t Record;
+
+  // Records wait in the controller while the previous one is being written.
+  if (m_History.isReady() && m_Controller.popRunRecord( Record ))
+  {
+    Record.Profile = m_CurrentProfileIndex;
+    m_History.append( Record );
+  }
+}
+
+
+/*!
+ * \brief Utility function for reporting the end of a batch job, and removing it from the queue.
+ * \param Completed Whether all the job runs completed.
+*/
+void EndBatchJob( bool Completed )
+{
+  BatchJob_t* lpJob = &m_BatchJobs[ 0 ];
+
+  m_Console.beginEvent();
+  m_Console.send( F("job[idx=") );
+  m_Console.send( lpJob->ProfileIndex );
+  m_Console.send( F(",n=") );
+  m_Console.send( lpJob->Done );
+  m_Console.send( F(",of=") );
+  m_Console.send( lpJob->Runs );
+  m_Console.send( F(",t=") );
+  m_Console.send( millis() - m_BatchJobStartTime );
+  m_Console.send( F(",ok=") );
+  m_Console.send( Completed );
+  m_Console.send( F("]") );
+  m_Console.endEvent();
+
+  m_BatchCount--;
+  memmove( &m_BatchJobs[ 0 ], &m_BatchJobs[ 1 ], m_BatchCount * sizeof(m_BatchJobs[0]) );
+  m_BatchJobStartTime = millis();
+}
+
+
+/*!
+ * \brief Utility function running the batch jobs queue.
+ * This function is called from the #loop() function. Once the oven is idle and has cooled below the load temperature
+ * it starts the next queued run, so no operator confirmation is needed between boards. A run stopped before its end,
+ * by the operator or by the safety supervisor, cancels the whole queue.
+*/
+void doBatchCycle()
+{
+  BatchJob_t* lpJob = &m_BatchJobs[ 0 ];
+  float Temp;
+
+  if (m_BatchRunning)
+  {
+    if (m_Controller.getRuning())
+      return;
+
+    m_BatchRunning = false;
+    m_BatchIdleTime = millis();
+    if (m_BatchCount == 0)
+      return;
+
+    if (!m_Controller.getCompleted())
+    {
+      EndBatchJob( false );
+      m_BatchCount = 0;
+      return;
+    }
+
+    lpJob->Done++;
+    m_Console.beginEvent();
+    m_Console.send( F("run[idx=") );
+    m_Console.send( lpJob->ProfileIndex );
+    m_Console.send( F(",n=") );
+    m_Console.send( lpJob->Done );
+    m_Console.send( F(",of=") );
+    m_Console.send( lpJob->Runs );
+    m_Console.send( F(",t=") );
+    m_Console.send( m_Controller.getLastProcessDuration() );
+    m_Console.send( F(",wait=") );
+    m_Console.send( m_BatchWaitTime );
+    m_Console.send( F("]") );
+    m_Console.endEvent();
+
+    if (lpJob->Done >= lpJob->Runs)
+      EndBatchJob( true );
+    return;
+  }
+
+  if ((m_BatchCount == 0) || m_Controller.getRuning() || (m_Shield.getSafety().getFaults() != SAFETY_FAULT_NONE))
+    return;
+
+  Temp = m_Shield.readTC();
+  if (isnan( Temp ) || (Temp > m_BatchLoadTemp))
+    return;
+
+  if ((lpJob->ProfileIndex != m_CurrentProfileIndex) || (m_ActiveProfile.lpPhases == NULL))
+  {
+    if (!ActivateProfile( lpJob->ProfileIndex ))
+    {
+      EndBatchJob( false );
+      return;
+    }
+    SendProfileInfo();
+  }
+
+  m_Controller.setPhases( m_ActiveProfile.lpPhases, m_ActiveProfile.Header.PhasesCount, &m_ActiveProfile.Header.Limits );
+  if (m_Controller.Start())
+  {
+    m_BatchRunning = true;
+    m_BatchWaitTime = millis() - m_BatchIdleTime;
+  }
+}
+
+
 /*!
  * \brief Standard Arduino system application loop function.
  * This function is called continuously by the Arduino startup code during system initialization.
@@ -781,6 +1091,9 @@ void setPrevProfile()
 void loop()
 {
   m_Controller.doCycle();
+  doHistoryCycle();
+  doBatchCycle();
+  VLOvenEEPROM::doCycle();
   
   if (!m_Console.handleInput())
   {
@@ -812,7 +1125,7 @@ void loop()
       {
         if (Result)
         {
-          m_Controller.setPhases( m_ActiveProfile.lpPhases, m_ActiveProfile.Header.PhasesCount );
+          m_Controller.setPhases( m_ActiveProfile.lpPhases, m_ActiveProfile.Header.PhasesCount, &m_ActiveProfile.Header.Limits );
           m_Controller.Start();
         }
       }
@@ -841,29 +1154,26 @@ void loop()
         m_Shield.getLCD().print( F("OFF") );
 
       // Phase info.
-      if (Disabled)
-        sprintf( m_TextsBuffer, "Phase: %-13s", "DISABLED" );
-      else
-        sprintf( m_TextsBuffer, "Phase: %-13s", lpPhase->Name );
+      formatText( formatText( m_TextsBuffer, "Phase: ", 0 ), Disabled ? "DISABLED" : lpPhase->Name, -13 );
       m_Shield.getLCD().setCursor( 0, 1 );
       m_Shield.getLCD().print( m_TextsBuffer );
 
       // Elapsed times
-      sprintf( m_TextsBuffer, "PT: %4ds", m_Controller.getPhaseDuration() / 1000 );
+      formatText( formatInt( formatText( m_TextsBuffer, "PT: ", 0 ), m_Controller.getPhaseDuration() / 1000, 4 ), "s", 0 );
       m_Shield.getLCD().setCursor( 0, 2 );
       m_Shield.getLCD().print( m_TextsBuffer );
 
-      sprintf( m_TextsBuffer, "TT: %4ds", m_Controller.getProcessDuration() / 1000 );
+      formatText( formatInt( formatText( m_TextsBuffer, "TT: ", 0 ), m_Controller.getProcessDuration() / 1000, 4 ), "s", 0 );
       m_Shield.getLCD().setCursor( 10, 2 );
       m_Shield.getLCD().print( m_TextsBuffer );
       
       // Current temperature.
-      formatFloat( m_TextsBuffer, sizeof(m_TextsBuffer), m_Shield.readTC(), 10, 1, "C" );
+      formatTemperature( m_Shield.readTC(), -10 );
       m_Shield.getLCD().setCursor( 0, 3 );
       m_Shield.getLCD().print( m_TextsBuffer );
 
       // Setpoint.
-      formatFloat( m_TextsBuffer, sizeof(m_TextsBuffer), m_Controller.getSetpoint(), 10, 1, "C" );
+      formatTemperature( m_Controller.getSetpoint(), -10 );
       m_Shield.getLCD().setCursor( 10, 3 );
       m_Shield.getLCD().print( m_TextsBuffer );
     }
@@ -905,8 +1215,11 @@ void CmdReadInput( TextConsole* lpSilly )
     val = digitalRead( Index );
     if (val != pval)
     {
-      snprintf( m_ConsoleBuffer, sizeof(m_ConsoleBuffer), "in[%d]=%i;\r\n", Index, val );
-      lpSilly->send( m_ConsoleBuffer );
+      lpSilly->send( F("in[") );
+      lpSilly->send( Index );
+      lpSilly->send( F("]=") );
+      lpSilly->send( val );
+      lpSilly->send( F(";" TEXTCONSOLE_EOLN) );
     }
 
     pval = val;
@@ -916,220 +1229,1141 @@ void CmdReadInput( TextConsole* lpSilly )
 }
 
 
-void CmdEEPROM( TextConsole* lpSilly )
+/*!
+ * \brief Interpreter command handler: EEPROM INFO subcommand.
+ * Reports whether the layout signature matches and where the free space starts.
+*/
+void CmdEEPROMInfo( TextConsole* lpSilly )
 {
-  if (lpSilly->argsCount() == 0)
-  {
-   lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "inf" ))
-  {
-    bool SignatureOK;
+  bool SignatureOK;
 
-    SignatureOK = EEPROMCheckSignature();
-    
-    lpSilly->beginResponse();
-    m_Console.send( F("eeprom[sigOk=") );
-    m_Console.send( SignatureOK );
-    m_Console.send( F(", len=") );
-    m_Console.send( EEPROM.length() );
-    m_Console.send( F(", freestart=") );
-    m_Console.send( FindFreeEEPROMStart() );
-    m_Console.send( F("]" ) );
-    lpSilly->endResponse( CONSOLESUCCESS );
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "fmt" ))
-  {
-    EEPROMFormat();
-    EEPROMRegisterDefaultProfiles();
-    lpSilly->sendResponse( CONSOLESUCCESS );
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "d" ))
-  {
-    if (lpSilly->argsCount() != 2)  {
-     lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
-    }
-    else {
-      int Offset = atoi( lpSilly->getArg( 1 ) );
+  SignatureOK = EEPROMCheckSignature();
+  
+  lpSilly->beginResponse();
+  m_Console.send( F("eeprom[sigOk=") );
+  m_Console.send( SignatureOK );
+  m_Console.send( F(", len=") );
+  m_Console.send( EEPROM_END );
+  m_Console.send( F(", freestart=") );
+  m_Console.send( FindFreeEEPROMStart() );
+  m_Console.send( F("]" ) );
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Function used for completing a format, called once the default profiles are written.
+ * \param lpContext Unused.
+*/
+void onEEPROMFormatted( void* lpContext )
+{
+  m_Edit.Active = false;
 
-      EEPROM.get( Offset, m_TextsBuffer );
+  m_Console.beginEvent();
+  m_Console.send( F("eeprom[fmt=1]") );
+  m_Console.endEvent();
+}
 
-      lpSilly->beginResponse();
-      for (int Index = 0; Index < sizeof(m_TextsBuffer); Index++) {
-        char Txt[16];
 
-        if (0 == (Index % 16))
-          m_Console.send( F(TEXTCONSOLE_EOLN) );
-          
-        sprintf( Txt, "%02X ", (unsigned char)m_TextsBuffer[Index] );
-        lpSilly->send( Txt );
-      }
-      lpSilly->endResponse( CONSOLESUCCESS );
-    }
-  }
-  else {
+/*!
+ * \brief Interpreter command handler: EEPROM FORMAT subcommand.
+ * Starts restoring the default profiles, keeping the lifetime counters. It takes the whole EEPROM write queue,
+ * and counts as a profile edit until an \c eeprom event reports its completion.
+*/
+void CmdEEPROMFormat( TextConsole* lpSilly )
+{
+  if (m_Edit.Active || !VLOvenEEPROM::isIdle()) {
     lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
   }
+
+  m_Edit.Active = true;
+  EEPROMFormat( true );
+  EEPROMRegisterDefaultProfiles( onEEPROMFormatted );
+  lpSilly->sendResponse( CONSOLESUCCESS );
 }
 
 
-void CmdReset( TextConsole* lpSilly )
+/*!
+ * \brief Interpreter command handler: EEPROM COUNTERS subcommand.
+ * Reports the lifetime heater counters.
+*/
+void CmdEEPROMCounters( TextConsole* lpSilly )
 {
-  soft_restart();
+  VLOvenEnergyCounters_t Counters;
+
+  m_Controller.getEnergy().getLifetime( Counters );
+
+  lpSilly->beginResponse();
+  m_Console.send( F("counters[runs=") );
+  m_Console.send( Counters.Runs );
+  m_Console.send( F(",ton=") );
+  m_Console.send( Counters.OnTime );
+  // On-time in seconds instead of ms, the same conversion gives kWh.
+  m_Console.send( F(",kwh=") );
+  m_Console.send( VLOvenEnergy::toWattHours( Counters.OnTime ) );
+  m_Console.send( F(",sat=") );
+  m_Console.send( Counters.SaturatedTime );
+  m_Console.send( F("]") );
+  lpSilly->endResponse( CONSOLESUCCESS );
 }
 
 
 /*!
- * \brief Interpreter command handler: PROFILES handling command.
- * This function is called when the commands interpreter receives a request for the PROFILES handling command.
+ * \brief Interpreter command handler: EEPROM DUMP subcommand.
+ * Dumps in hexadecimal the EEPROM contents from the offset given as argument.
 */
-void CmdProfiles( TextConsole* lpSilly )
+void CmdEEPROMDump( TextConsole* lpSilly )
 {
-  if (lpSilly->argsCount() == 0)
-  {
-   lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "cur" ))
-  {
-    lpSilly->beginResponse();
-    lpSilly->send( m_CurrentProfileIndex );
-    lpSilly->endResponse( CONSOLESUCCESS );
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "ls" ))
-  {
-    int Index;
-    ProfileHeader_t Header;
+  int Offset = atoi( lpSilly->getArg( 1 ) );
 
-    lpSilly->beginResponse();
-    Index = 0;
+  VLOvenEEPROM::get( Offset, m_TextsBuffer );
 
-    while (LoadProfileHeader( Header, Index ) > 0)
-    {
-      if (Index)
-        lpSilly->send( TEXTCONSOLE_EOLN );
-        
-      lpSilly->send( Header.Name );
-      Index++;
-    }
+  lpSilly->beginResponse();
+  for (int Index = 0; Index < sizeof(m_TextsBuffer); Index++) {
+    char Txt[ 4 ];
 
-    lpSilly->endResponse( CONSOLESUCCESS );
+    if (0 == (Index % 16))
+      m_Console.send( F(TEXTCONSOLE_EOLN) );
+      
+    formatText( formatHex( Txt, (unsigned char)m_TextsBuffer[Index], 2 ), " ", 0 );
+    lpSilly->send( Txt );
   }
-  else if (!strcmp( lpSilly->getArg( 0 ), "sel" ))
-  {
-    if (lpSilly->argsCount() != 2) {
-      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
-    }
-    else {
-      int ProfileIndex = atoi( lpSilly->getArg( 1 ) );
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
 
-      /* Disable the controller */
-      if (m_Controller.getRuning())
-        m_Controller.setPhases( NULL, 0 );
 
-      if (ActivateProfile( ProfileIndex )) {
-        lpSilly->sendResponse( CONSOLESUCCESS );
-        SendProfileInfo();
-      }
-      else
-        lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
-    }
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "on" )) {
-    if (lpSilly->argsCount() != 1) {
-      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
-    }
-    else if (m_ActiveProfile.lpPhases == NULL) {
-      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
-    }
-    else {
-      m_Controller.setPhases( m_ActiveProfile.lpPhases, m_ActiveProfile.Header.PhasesCount );
-      m_Controller.Start();
-      lpSilly->sendResponse( CONSOLESUCCESS );
-    }
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "off" )) {
-    if (lpSilly->argsCount() != 1) {
-      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
-    }
-    else {
-      m_Controller.setPhases( NULL, 0 );
-      lpSilly->sendResponse( CONSOLESUCCESS );
-    }
-  }
-  else if (!strcmp( lpSilly->getArg( 0 ), "get" )) {
-    if (lpSilly->argsCount() != 2) {
-      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
-    }
-    else {
-      ProfileInfo_t Profile;
-      int ProfileIndex = atoi( lpSilly->getArg( 1 ) );
+/*! 
+ * \brief EEPROM subcommands, sorted by name.
+*/
+static constexpr VLOvenCommand_t EEPROMCommands[] PROGMEM =
+{
+  { "cnt",  0, 0, CmdEEPROMCounters,  NULL, 0 },
+  { "d",    1, 1, CmdEEPROMDump,      NULL, 0 },
+  { "fmt",  0, 0, CmdEEPROMFormat,    NULL, 0 },
+  { "inf",  0, 0, CmdEEPROMInfo,      NULL, 0 }
+};
+COMMANDS_CHECK( EEPROMCommands );
 
-      if (!LoadProfile( Profile, ProfileIndex)) {
-        lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
-      }
-      else {
-        const VLOvenControllerPhase_t*  lpPhase;
-
-        lpSilly->beginResponse();
-        m_Console.send( F("profile[idx=") );
-        m_Console.send( ProfileIndex );
-        m_Console.send( F(",Name=\"") );
-        m_Console.send( Profile.Header.Name );
-        m_Console.send( F("\",pnct=") );
-        m_Console.send( Profile.Header.PhasesCount );
-        m_Console.send( F("]" ) );
-
-        lpPhase = Profile.lpPhases;
-
-        for (int Count = 0; Count < Profile.Header.PhasesCount; Count++) {
-          m_Console.send( F(TEXTCONSOLE_EOLN) );
-          m_Controller.SendPhaseInfo( lpPhase );
-          lpPhase++;
-        }
-        lpSilly->endResponse( CONSOLESUCCESS );
 
-        FreeProfile( Profile );
-      }
+/*!
+ * \brief Interpreter command handler: EEPROM handling command.
+ * This function is called when the commands interpreter receives a request for the EEPROM handling command.
+*/
+void CmdEEPROM( TextConsole* lpSilly )
+{
+  dispatchCommand( lpSilly, EEPROMCommands, COMMANDS_COUNT( EEPROMCommands ) );
+}
+
+
+void CmdReset( TextConsole* lpSilly )
+{
+  soft_restart();
+}
+
+
+/*!
+ * \brief Interpreter command handler: SAFETY supervisor state.
+ * Reports the supervisor state.
+*/
+void CmdSafetyState( TextConsole* lpSilly )
+{
+  lpSilly->beginResponse();
+  m_Controller.SendSafetyState();
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: SAFETY CLEAR subcommand.
+ * Clears the latched faults.
+*/
+void CmdSafetyClear( TextConsole* lpSilly )
+{
+  m_Shield.getSafety().clear();
+  lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: SAFETY INJECT subcommand.
+ * Injects a fault for testing the shutdown path.
+*/
+void CmdSafetyInject( TextConsole* lpSilly )
+{
+  m_Shield.getSafety().trip( SAFETY_FAULT_INJECTED );
+  lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*! 
+ * \brief Safety supervisor subcommands, sorted by name.
+*/
+static constexpr VLOvenCommand_t SafetyCommands[] PROGMEM =
+{
+  { "",     0, 0, CmdSafetyState,   NULL, 0 },
+  { "clr",  0, 0, CmdSafetyClear,   NULL, 0 },
+  { "inj",  0, 0, CmdSafetyInject,  NULL, 0 }
+};
+COMMANDS_CHECK( SafetyCommands );
+
+
+/*!
+ * \brief Interpreter command handler: SAFETY supervisor command.
+ * Without arguments reports the supervisor state, \c clr clears the latched faults and \c inj injects a fault
+ * for testing the shutdown path.
+*/
+void CmdSafety( TextConsole* lpSilly )
+{
+  dispatchCommand( lpSilly, SafetyCommands, COMMANDS_COUNT( SafetyCommands ) );
+}
+
+
+/*!
+ * \brief Interpreter command handler: SIMULATOR command.
+ * Drives the mock sensor channels (see #TC_DEVICE_MOCK): \c t overrides the simulated oven temperature and
+ * \c f injects converter fault flags, \c 0 going back to normal operation.
+*/
+void CmdSimulator( TextConsole* lpSilly )
+{
+  uint8_t Count = 0;
+
+  if (lpSilly->argsCount() != 2)
+  {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
+    return;
+  }
+
+  if (strcmp( lpSilly->getArg( 0 ), "t" ) && strcmp( lpSilly->getArg( 0 ), "f" ))
+  {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+
+  for (uint8_t Channel = 0; Channel < TC_CHANNELS; Channel++)
+  {
+    VLOvenMAX31855* lpConverter = m_Shield.getConverter( Channel );
+
+    if ((lpConverter == NULL) || !lpConverter->isMock())
+      continue;
+
+    if (!strcmp( lpSilly->getArg( 0 ), "t" ))
+      lpConverter->setMockTemperature( atof( lpSilly->getArg( 1 ) ) );
+    else
+      lpConverter->setMockFault( atoi( lpSilly->getArg( 1 ) ) );
+    Count++;
+  }
+
+  if (Count)
+    lpSilly->sendResponse( CONSOLESUCCESS );
+  else
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+}
+
+
+/*!
+ * \brief Interpreter command handler: batch QUEUE state.
+ * Reports the load temperature and the queued jobs.
+*/
+void CmdQueueState( TextConsole* lpSilly )
+{
+  lpSilly->beginResponse();
+  m_Console.send( F("batch[lt=") );
+  m_Console.send( m_BatchLoadTemp );
+  m_Console.send( F(",jobs=") );
+  m_Console.send( m_BatchCount );
+  m_Console.send( F(",run=") );
+  m_Console.send( m_BatchRunning );
+  m_Console.send( F("]") );
+  for (uint8_t Index = 0; Index < m_BatchCount; Index++)
+  {
+    m_Console.send( F(TEXTCONSOLE_EOLN "job[idx=") );
+    m_Console.send( m_BatchJobs[ Index ].ProfileIndex );
+    m_Console.send( F(",n=") );
+    m_Console.send( m_BatchJobs[ Index ].Done );
+    m_Console.send( F(",of=") );
+    m_Console.send( m_BatchJobs[ Index ].Runs );
+    m_Console.send( F("]") );
+  }
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: batch QUEUE ADD subcommand.
+ * Queues a job running the profile given as first argument the number of times given as second argument.
+*/
+void CmdQueueAdd( TextConsole* lpSilly )
+{
+  int ProfileIndex = atoi( lpSilly->getArg( 1 ) );
+  int Runs = atoi( lpSilly->getArg( 2 ) );
+
+  if ((ProfileIndex < 0) || (ProfileIndex >= GetProfilesCount()) || (Runs < 1)) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+  }
+  else if (m_BatchCount >= BATCH_QUEUE_LENGTH) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDNOMEMORY) );
+  }
+  else {
+    // Waiting for the first run counts from now on.
+    if (m_BatchCount == 0)
+    {
+      m_BatchIdleTime = millis();
+      m_BatchJobStartTime = m_BatchIdleTime;
     }
+    m_BatchJobs[ m_BatchCount ].ProfileIndex = ProfileIndex;
+    m_BatchJobs[ m_BatchCount ].Runs = Runs;
+    m_BatchJobs[ m_BatchCount ].Done = 0;
+    m_BatchCount++;
+    lpSilly->sendResponse( CONSOLESUCCESS );
   }
-  else if (!strcmp( lpSilly->getArg( 0 ), "nw" )) {
-    const char* Name;
-    ProfileInfo_t Profile;
-    int NameLen;
-    int PhasesCount;
-    
-    if (lpSilly->argsCount() != 3) {
-      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
+}
+
+
+/*!
+ * \brief Interpreter command handler: batch QUEUE CLEAR subcommand.
+ * Empties the queue.
+*/
+void CmdQueueClear( TextConsole* lpSilly )
+{
+  // A run in progress goes on, it is just not counted anymore.
+  m_BatchCount = 0;
+  m_BatchRunning = false;
+  lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: batch QUEUE LOAD TEMPERATURE subcommand.
+ * Sets the load temperature the oven must cool below before starting each run, within the profile temperatures range.
+*/
+void CmdQueueLoadTemp( TextConsole* lpSilly )
+{
+  const char* lpValue = lpSilly->getArg( 1 );
+  char* lpEnd;
+  double Value = strtod( lpValue, &lpEnd );
+
+  // Same range as the profile temperatures, see VLOvenController::checkPhases().
+  if ((lpEnd == lpValue) || (*lpEnd != '\0') || !((Value >= 0.0) && (Value <= SAFETY_MAX_TEMPERATURE))) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+  else {
+    m_BatchLoadTemp = Value;
+    lpSilly->sendResponse( CONSOLESUCCESS );
+  }
+}
+
+
+/*! 
+ * \brief Batch queue subcommands, sorted by name.
+*/
+static constexpr VLOvenCommand_t QueueCommands[] PROGMEM =
+{
+  { "",     0, 0, CmdQueueState,    NULL, 0 },
+  { "add",  2, 2, CmdQueueAdd,      NULL, 0 },
+  { "clr",  0, 0, CmdQueueClear,    NULL, 0 },
+  { "lt",   1, 1, CmdQueueLoadTemp, NULL, 0 }
+};
+COMMANDS_CHECK( QueueCommands );
+
+
+/*!
+ * \brief Interpreter command handler: batch QUEUE command.
+ * Without arguments reports the queue, \c add <profile> <runs> queues a job, \c clr empties the queue and
+ * \c lt <temperature> sets the load temperature the oven must cool below before starting each run.
+*/
+void CmdQueue( TextConsole* lpSilly )
+{
+  dispatchCommand( lpSilly, QueueCommands, COMMANDS_COUNT( QueueCommands ) );
+}
+
+
+/*!
+ * \brief Interpreter command handler: run HISTORY command.
+ * Reports the stored run records, newest first. Temperatures are in degrees C and times in seconds.
+*/
+void CmdHistory( TextConsole* lpSilly )
+{
+  VLOvenRunRecord_t Record;
+  bool First = true;
+
+  if (lpSilly->argsCount() != 0)
+  {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
+    return;
+  }
+
+  lpSilly->beginResponse();
+  for (uint8_t Index = 0; Index < HISTORY_RUNS; Index++)
+  {
+    // Empty slots and damaged records are skipped.
+    if (!m_History.get( Index, Record ))
+      continue;
+    if (!First)
+      m_Console.send( F(TEXTCONSOLE_EOLN) );
+    First = false;
+    m_Console.send( F("run[seq=") );
+    m_Console.send( Record.Sequence );
+    m_Console.send( F(",idx=") );
+    m_Console.send( Record.Profile );
+    m_Console.send( F(",st=") );
+    m_Console.send( Record.StartTime );
+    m_Console.send( F(",ok=") );
+    m_Console.send( (bool)(Record.Result & HISTORY_RESULT_COMPLETED) );
+    m_Console.send( F(",qa=") );
+    m_Console.send( !(Record.Result & HISTORY_RESULT_QA_FAILED) );
+    m_Console.send( F(",flt=") );
+    m_Console.send( Record.Faults );
+    m_Console.send( F(",pk=") );
+    m_Console.send( (double)Record.Peak / TRAJECTORY_TEMP_SCALE );
+    m_Console.send( F(",tal=") );
+    m_Console.send( Record.TimeAboveLiquidus );
+    m_Console.send( F(",ovs=") );
+    m_Console.send( (double)Record.Overshoot / TRAJECTORY_TEMP_SCALE );
+    m_Console.send( F(",pt=") );
+    for (uint8_t Phase = 0; (Phase < Record.PhasesCount) && (Phase < HISTORY_PHASES); Phase++)
+    {
+      if (Phase)
+        m_Console.send( F(":") );
+      m_Console.send( Record.PhaseTime[ Phase ] );
     }
-    else {
-      Name = lpSilly->getArg( 1 );
-      NameLen = strlen( Name );
-      PhasesCount = atoi( lpSilly->getArg( 2 ) );
+    m_Console.send( F("]") );
+  }
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Utility function sending one setting as \c name=value.
+ * \param Index Setting index.
+*/
+void SendSetting( uint8_t Index )
+{
+  char Txt[ FORMAT_NUMBER_LENGTH ];
+
+  VLOvenSettings::getName( Index, Txt );
+  m_Console.send( Txt );
+  m_Console.send( F("=") );
+  if (VLOvenSettings::getType( Index ) == SETTING_TYPE_FLOAT)
+    formatFixed( Txt, lround( m_Settings.getValue( Index ) * 10000.0 ), 4, 4, 0 );
+  else
+    formatInt( Txt, (long)m_Settings.getValue( Index ), 0 );
+  m_Console.send( Txt );
+}
+
+
+/*!
+ * \brief Interpreter command handler: SETTINGS list.
+ * Reports every setting in use, and whether they differ from the stored ones.
+*/
+void CmdSettingsList( TextConsole* lpSilly )
+{
+  lpSilly->beginResponse();
+  m_Console.send( F("cfg[") );
+  for (uint8_t Index = 0; Index < VLOvenSettings::getCount(); Index++)
+  {
+    SendSetting( Index );
+    m_Console.send( F(",") );
+  }
+  m_Console.send( F("mod=") );
+  m_Console.send( m_Settings.isModified() );
+  m_Console.send( F("]") );
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: SETTINGS GET subcommand.
+ * Reports the setting whose name is given as argument.
+*/
+void CmdSettingsGet( TextConsole* lpSilly )
+{
+  int8_t Index = VLOvenSettings::find( lpSilly->getArg( 1 ) );
+
+  if (Index < 0) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+
+  lpSilly->beginResponse();
+  m_Console.send( F("cfg[") );
+  SendSetting( Index );
+  m_Console.send( F("]") );
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: SETTINGS SET subcommand.
+ * Changes the setting whose name is given as first argument to the value given as second argument, and applies
+ * it right away. Settings affecting a run in progress as a whole are refused while running, and so is a value
+ * that is not entirely a number.
+*/
+void CmdSettingsSet( TextConsole* lpSilly )
+{
+  int8_t Index = VLOvenSettings::find( lpSilly->getArg( 1 ) );
+  const char* lpValue = lpSilly->getArg( 2 );
+  char* lpEnd;
+  double Value = strtod( lpValue, &lpEnd );
+
+  if ((Index < 0) || ((VLOvenSettings::getFlags( Index ) & SETTING_FLAG_IDLE) && m_Controller.getRuning())) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+  else if ((lpEnd == lpValue) || (*lpEnd != '\0')) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+  else if (!m_Settings.setValue( Index, Value )) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+  }
+  else {
+    ApplySettings();
+    lpSilly->sendResponse( CONSOLESUCCESS );
+  }
+}
+
+
+/*!
+ * \brief Interpreter command handler: SETTINGS DEFAULTS subcommand.
+ * Goes back to the built-in settings, which are not stored until committed.
+*/
+void CmdSettingsDefaults( TextConsole* lpSilly )
+{
+  if (m_Controller.getRuning()) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+
+  m_Settings.setDefaults();
+  ApplySettings();
+  lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: SETTINGS COMMIT subcommand.
+ * Stores the settings in use, they are loaded on the next start.
+*/
+void CmdSettingsCommit( TextConsole* lpSilly )
+{
+  if (!m_Settings.commit())
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDNOMEMORY) );
+  else
+    lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*! 
+ * \brief Settings subcommands, sorted by name.
+*/
+static constexpr VLOvenCommand_t SettingsCommands[] PROGMEM =
+{
+  { "",     0, 0, CmdSettingsList,      NULL, 0 },
+  { "cm",   0, 0, CmdSettingsCommit,    NULL, 0 },
+  { "def",  0, 0, CmdSettingsDefaults,  NULL, 0 },
+  { "get",  1, 1, CmdSettingsGet,       NULL, 0 },
+  { "set",  2, 2, CmdSettingsSet,       NULL, 0 }
+};
+COMMANDS_CHECK( SettingsCommands );
+
+
+/*!
+ * \brief Interpreter command handler: SETTINGS command.
+ * Without arguments lists the controller settings, \c get and \c set read and change one of them by name,
+ * \c def goes back to the defaults and \c cm stores them in EEPROM.
+*/
+void CmdSettings( TextConsole* lpSilly )
+{
+  dispatchCommand( lpSilly, SettingsCommands, COMMANDS_COUNT( SettingsCommands ) );
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES CURRENT subcommand.
+ * Reports the index of the active profile.
+*/
+void CmdProfilesCurrent( TextConsole* lpSilly )
+{
+  lpSilly->beginResponse();
+  lpSilly->send( m_CurrentProfileIndex );
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES LIST subcommand.
+ * Reports the names of the stored profiles.
+*/
+void CmdProfilesList( TextConsole* lpSilly )
+{
+  int Index;
+  ProfileHeader_t Header;
+
+  lpSilly->beginResponse();
+  Index = 0;
+
+  while (LoadProfileHeader( Header, Index ) > 0)
+  {
+    if (Index)
+      lpSilly->send( TEXTCONSOLE_EOLN );
       
-      if ((NameLen >= (sizeof( Profile.Header.Name ) - 1)) || (PhasesCount < 1)) {
-        lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
-      }
-      else {
-        memcpy( &Profile.Header.Name[0], Name, NameLen );
-        Profile.Header.PhasesCount = PhasesCount;
+    lpSilly->send( Header.Name );
+    Index++;
+  }
 
-        if (AllocProfilePhases( Profile )) {
-          memset( Profile.lpPhases, 0, Profile.Header.PhasesCount * sizeof(Profile.lpPhases[0]) );
-          ActivateProfile( Profile );
-          m_CurrentProfileIndex = GetProfilesCount();
-          lpSilly->endResponse( CONSOLESUCCESS );
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
 
-          SendProfileInfo();
-        }
-        else {
-          lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDNOMEMORY) );
-        }
-      }
+
+/*!
+ * \brief Interpreter command handler: PROFILES SELECT subcommand.
+ * Stops the controller and activates the profile whose index is given as argument.
+*/
+void CmdProfilesSelect( TextConsole* lpSilly )
+{
+  int ProfileIndex = atoi( lpSilly->getArg( 1 ) );
+
+  /* Disable the controller */
+  if (m_Controller.getRuning())
+    m_Controller.setPhases( NULL, 0 );
+
+  if (ActivateProfile( ProfileIndex )) {
+    lpSilly->sendResponse( CONSOLESUCCESS );
+    SendProfileInfo();
+  }
+  else
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES ON subcommand.
+ * Starts the controller with the active profile, the error tells why the controller refused to start.
+*/
+void CmdProfilesOn( TextConsole* lpSilly )
+{
+  if (m_ActiveProfile.lpPhases == NULL) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+  else {
+    m_Controller.setPhases( m_ActiveProfile.lpPhases, m_ActiveProfile.Header.PhasesCount, &m_ActiveProfile.Header.Limits );
+    if (m_Controller.Start())
+      lpSilly->sendResponse( CONSOLESUCCESS );
+    else if (m_Shield.getSafety().getFaults() != SAFETY_FAULT_NONE)
+      lpSilly->sendResponse( CONSOLEERROR, F(TEXT_START_SAFETYFAULT) );
+    else if (isnan( m_Shield.readTC() ))
+      lpSilly->sendResponse( CONSOLEERROR, F(TEXT_START_NOTEMP) );
+    else
+      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES OFF subcommand.
+ * Stops the controller.
+*/
+void CmdProfilesOff( TextConsole* lpSilly )
+{
+  m_Controller.setPhases( NULL, 0 );
+  lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES GET subcommand.
+ * Reports the header and the phases of the profile whose index is given as argument.
+*/
+void CmdProfilesGet( TextConsole* lpSilly )
+{
+  ProfileInfo_t Profile;
+  int ProfileIndex = atoi( lpSilly->getArg( 1 ) );
+
+  if (!LoadProfile( Profile, ProfileIndex)) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+  }
+  else {
+    const VLOvenControllerPhase_t*  lpPhase;
+
+    lpSilly->beginResponse();
+    m_Console.send( F("profile[idx=") );
+    m_Console.send( ProfileIndex );
+    m_Console.send( F(",Name=\"") );
+    m_Console.send( Profile.Header.Name );
+    m_Console.send( F("\",pnct=") );
+    m_Console.send( Profile.Header.PhasesCount );
+    m_Console.send( F(",pk=") );
+    m_Console.send( Profile.Header.Limits.PeakMin );
+    m_Console.send( F(":") );
+    m_Console.send( Profile.Header.Limits.PeakMax );
+    m_Console.send( F(",tal=") );
+    m_Console.send( Profile.Header.Limits.TALMin );
+    m_Console.send( F(":") );
+    m_Console.send( Profile.Header.Limits.TALMax );
+    m_Console.send( F(",up=") );
+    m_Console.send( Profile.Header.Limits.HeatingRateMax );
+    m_Console.send( F(",dn=") );
+    m_Console.send( Profile.Header.Limits.CoolingRateMax );
+    m_Console.send( F(",stl=") );
+    m_Console.send( Profile.Header.Limits.SettlingTimeMax );
+    m_Console.send( F("]" ) );
+
+    lpPhase = Profile.lpPhases;
+
+    for (int Count = 0; Count < Profile.Header.PhasesCount; Count++) {
+      m_Console.send( F(TEXTCONSOLE_EOLN) );
+      m_Controller.SendPhaseInfo( lpPhase );
+      lpPhase++;
     }
+    lpSilly->endResponse( CONSOLESUCCESS );
+
+    FreeProfile( Profile );
+  }
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES TRAJECTORY subcommand.
+ * Reports the setpoint trajectory of the running process, or the one the active profile would follow from the
+ * current temperature, leaving the idle controller as it is.
+*/
+void CmdProfilesTrajectory( TextConsole* lpSilly )
+{
+  VLOvenTrajectorySegment_t* lpTrajectory;
+  int Count = m_ActiveProfile.Header.PhasesCount;
+
+  if (m_Controller.getRuning()) {
+    lpSilly->beginResponse();
+    m_Controller.SendTrajectory();
+    lpSilly->endResponse( CONSOLESUCCESS );
+  }
+  else if (m_ActiveProfile.lpPhases == NULL) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+  else if ((Count < 1) || (Count > MAX_PROFILE_PHASES)) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+  }
+  else if ((lpTrajectory = (VLOvenTrajectorySegment_t*)malloc( Count * sizeof(lpTrajectory[0]) )) == NULL) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDNOMEMORY) );
   }
   else {
+    m_Controller.compileTrajectory( m_ActiveProfile.lpPhases, Count, m_Shield.readTC(), lpTrajectory );
+
+    lpSilly->beginResponse();
+    m_Controller.SendTrajectory( lpTrajectory, Count );
+    lpSilly->endResponse( CONSOLESUCCESS );
+    free( lpTrajectory );
+  }
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES NEW subcommand.
+ * Activates a new empty profile with the name and the number of phases given as arguments.
+*/
+void CmdProfilesNew( TextConsole* lpSilly )
+{
+  const char* Name;
+  ProfileInfo_t Profile;
+  int NameLen;
+  int PhasesCount;
+  
+  Name = lpSilly->getArg( 1 );
+  NameLen = strlen( Name );
+  PhasesCount = atoi( lpSilly->getArg( 2 ) );
+  
+  if ((NameLen >= (sizeof( Profile.Header.Name ) - 1)) || (PhasesCount < 1)) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+  }
+  else {
+    memset( &Profile.Header, 0, sizeof(Profile.Header) );
+    memcpy( &Profile.Header.Name[0], Name, NameLen );
+    Profile.Header.PhasesCount = PhasesCount;
+
+    if (AllocProfilePhases( Profile )) {
+      memset( Profile.lpPhases, 0, Profile.Header.PhasesCount * sizeof(Profile.lpPhases[0]) );
+      ActivateProfile( Profile );
+      m_CurrentProfileIndex = GetProfilesCount();
+      lpSilly->endResponse( CONSOLESUCCESS );
+
+      SendProfileInfo();
+    }
+    else {
+      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDNOMEMORY) );
+    }
+  }
+}
+
+
+/*!
+ * \brief Check whether the uploaded profile is being stored.
+ * \return Returns \c true while a profile edit still needs #m_Upload unchanged.
+*/
+bool isUploadBusy()
+{
+  return m_Edit.Active && (m_Edit.lpProfile == &m_Upload);
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES UPLOAD subcommand.
+ * Starts the upload of a new profile with the name and the number of phases given as arguments, dropping any
+ * upload in progress. The phases are then sent with the \c ph or \c wr subcommands and stored with \c cm.
+*/
+void CmdProfilesUpload( TextConsole* lpSilly )
+{
+  const char* Name = lpSilly->getArg( 1 );
+  int NameLen = strlen( Name );
+  int PhasesCount = atoi( lpSilly->getArg( 2 ) );
+
+  if (isUploadBusy()) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+
+  FreeProfile( m_Upload );
+
+  if ((NameLen < 1) || (NameLen >= sizeof(m_Upload.Header.Name)) || (PhasesCount < 1) || (PhasesCount > MAX_PROFILE_PHASES)) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+    return;
+  }
+
+  memset( &m_Upload.Header, 0, sizeof(m_Upload.Header) );
+  memcpy( &m_Upload.Header.Name[0], Name, NameLen );
+  m_Upload.Header.PhasesCount = PhasesCount;
+
+  if (!AllocProfilePhases( m_Upload )) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDNOMEMORY) );
+    return;
+  }
+
+  memset( m_Upload.lpPhases, 0, PhasesCount * sizeof(m_Upload.lpPhases[0]) );
+  m_UploadCount = PhasesCount;
+  m_UploadReceived = 0;
+  lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES PHASE subcommand.
+ * Sets the uploaded phase whose index is given as first argument from its name, end temperature, slope and
+ * duration, without zone offsets nor exit rules.
+*/
+void CmdProfilesPhase( TextConsole* lpSilly )
+{
+  int PhaseIndex = atoi( lpSilly->getArg( 1 ) );
+  const char* Name = lpSilly->getArg( 2 );
+  VLOvenControllerPhase_t* lpPhase;
+
+  if ((m_Upload.lpPhases == NULL) || isUploadBusy()) {
     lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+  if ((PhaseIndex < 0) || (PhaseIndex >= m_UploadCount) || (strlen( Name ) >= MAX_PHASENAME_LEN)) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+    return;
   }
+
+  lpPhase = &m_Upload.lpPhases[ PhaseIndex ];
+  memset( lpPhase, 0, sizeof(*lpPhase) );
+  strcpy( lpPhase->Name, Name );
+  lpPhase->EndTemp = atof( lpSilly->getArg( 3 ) );
+  lpPhase->Slope = atof( lpSilly->getArg( 4 ) );
+  lpPhase->Duration = atoi( lpSilly->getArg( 5 ) );
+  m_UploadReceived |= (1U << PhaseIndex);
+  lpSilly->sendResponse( CONSOLESUCCESS );
 }
 
 
+/*!
+ * \brief Interpreter command handler: PROFILES WRITE subcommand.
+ * Writes the bytes given in hexadecimal as second argument into the uploaded profile, at the offset given as
+ * first argument. Offsets address the profile as laid out in EEPROM, the header followed by the phases, so
+ * a whole profile image can be sent in chunks, or a phase at a time.
+*/
+void CmdProfilesWrite( TextConsole* lpSilly )
+{
+  uint8_t Data[ sizeof(m_ConsoleBuffer) / 2 ];
+  int Offset = atoi( lpSilly->getArg( 1 ) );
+  int Count = parseHex( lpSilly->getArg( 2 ), Data, sizeof(Data) );
+  int Size = sizeof(m_Upload.Header) + m_UploadCount * sizeof(m_Upload.lpPhases[0]);
+
+  if ((m_Upload.lpPhases == NULL) || isUploadBusy()) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+  if ((Count < 1) || (Offset < 0) || (Offset + Count > Size)) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+    return;
+  }
+
+  for (int Index = 0; Index < Count; Index++, Offset++)
+  {
+    if (Offset < sizeof(m_Upload.Header))
+      ((uint8_t*)&m_Upload.Header)[ Offset ] = Data[ Index ];
+    else
+    {
+      int PhaseOffset = Offset - sizeof(m_Upload.Header);
+
+      ((uint8_t*)m_Upload.lpPhases)[ PhaseOffset ] = Data[ Index ];
+      m_UploadReceived |= (1U << (PhaseOffset / sizeof(m_Upload.lpPhases[0])));
+    }
+  }
+  lpSilly->sendResponse( CONSOLESUCCESS );
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES COMMIT subcommand.
+ * Checks the uploaded profile and starts storing it in place of the profile whose index is given as optional
+ * argument, or after the stored ones, reporting its index. A \c pedit event follows once it is stored.
+*/
+void CmdProfilesCommit( TextConsole* lpSilly )
+{
+  int ProfileIndex = (lpSilly->argsCount() > 1) ? atoi( lpSilly->getArg( 1 ) ) : GetProfilesCount();
+
+  // Batch jobs refer to the profiles by index, the active profile may be replaced only while idle.
+  if ((m_Upload.lpPhases == NULL) || m_Edit.Active || (m_BatchCount != 0) ||
+    ((ProfileIndex == m_CurrentProfileIndex) && m_Controller.getRuning())) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+  else if ((ProfileIndex < 0) || (ProfileIndex > GetProfilesCount()) ||
+    (m_UploadReceived != (uint16_t)((1UL << m_UploadCount) - 1)) || (m_Upload.Header.PhasesCount != m_UploadCount) ||
+    (m_Upload.Header.Name[0] == 0) || (memchr( m_Upload.Header.Name, '\0', sizeof(m_Upload.Header.Name) ) == NULL) ||
+    !VLOvenController::checkPhases( m_Upload.lpPhases, m_UploadCount )) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+  }
+  else if (!StartProfileEdit( ProfileIndex, &m_Upload )) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDNOMEMORY) );
+  }
+  else {
+    lpSilly->beginResponse();
+    lpSilly->send( ProfileIndex );
+    lpSilly->endResponse( CONSOLESUCCESS );
+  }
+}
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES DELETE subcommand.
+ * Starts deleting the profile whose index is given as argument, the following profiles move down one index.
+ * A \c pedit event follows once it is deleted.
+*/
+void CmdProfilesDelete( TextConsole* lpSilly )
+{
+  int ProfileIndex = atoi( lpSilly->getArg( 1 ) );
+
+  // The active profile may go only while idle, the controller runs from its copy.
+  if (m_Edit.Active || (m_BatchCount != 0) ||
+    ((ProfileIndex == m_CurrentProfileIndex) && m_Controller.getRuning())) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+  }
+  else if ((ProfileIndex < 0) || !StartProfileEdit( ProfileIndex, NULL )) {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+  }
+  else {
+    if (ProfileIndex == m_CurrentProfileIndex) {
+      m_Controller.setPhases( NULL, 0 );
+      FreeProfile( m_ActiveProfile );
+      m_CurrentProfileIndex = -1;
+    }
+    else if ((m_CurrentProfileIndex >= 0) && (ProfileIndex < m_CurrentProfileIndex))
+      m_CurrentProfileIndex--;
+    lpSilly->sendResponse( CONSOLESUCCESS );
+    SendProfileInfo();
+  }
+}
+
+
+/*! 
+ * \brief Profiles subcommands, sorted by name.
+*/
+static constexpr VLOvenCommand_t ProfilesCommands[] PROGMEM =
+{
+  { "cm",   0, 1, CmdProfilesCommit,      NULL, 0 },
+  { "cur",  0, 0, CmdProfilesCurrent,     NULL, 0 },
+  { "del",  1, 1, CmdProfilesDelete,      NULL, 0 },
+  { "get",  1, 1, CmdProfilesGet,         NULL, 0 },
+  { "ls",   0, 0, CmdProfilesList,        NULL, 0 },
+  { "nw",   2, 2, CmdProfilesNew,         NULL, 0 },
+  { "off",  0, 0, CmdProfilesOff,         NULL, 0 },
+  { "on",   0, 0, CmdProfilesOn,          NULL, 0 },
+  { "ph",   5, 5, CmdProfilesPhase,       NULL, 0 },
+  { "sel",  1, 1, CmdProfilesSelect,      NULL, 0 },
+  { "trj",  0, 0, CmdProfilesTrajectory,  NULL, 0 },
+  { "up",   2, 2, CmdProfilesUpload,      NULL, 0 },
+  { "wr",   2, 2, CmdProfilesWrite,       NULL, 0 }
+};
+COMMANDS_CHECK( ProfilesCommands );
+
+
+/*!
+ * \brief Interpreter command handler: PROFILES handling command.
+ * This function is called when the commands interpreter receives a request for the PROFILES handling command.
+*/
+void CmdProfiles( TextConsole* lpSilly )
+{
+  dispatchCommand( lpSilly, ProfilesCommands, COMMANDS_COUNT( ProfilesCommands ) );
+}
+
+
+/*!
+ * \brief Benchmark step, one call of the timed function.
+ * \param Index Call index, from \c 0.
+ * \param lpContext Context pointer given to #RunBenchmark().
+*/
+typedef void (*BenchmarkStep_t)( uint16_t Index, void* lpContext );
+
+/*!
+ * \brief Statistics instance updated by the benchmark command, as small as the SPI channel ones.
+*/
+typedef VLOvenStatistics<float, TC_SPI_AVERAGING_SAMPLES, TC_AVERAGING_OPTIONS> BenchmarkAverage_t;
+
+
+/*! \brief Benchmark step: channel statistics update, on a #BenchmarkAverage_t instance. */
+void BenchmarkAdd( uint16_t Index, void* lpContext )
+{
+  ((BenchmarkAverage_t*)lpContext)->addValue( Index );
+}
+
+/*! \brief Benchmark step: first sensor channel average, stored into a \c volatile \c double. */
+void BenchmarkAverage( uint16_t Index, void* lpContext )
+{
+  *(volatile double*)lpContext = m_Shield.getChannelAverage( 0 ).getAverage();
+}
+
+/*! \brief Benchmark step: first sensor channel buffer minimum, stored into a \c volatile \c double. */
+void BenchmarkMin( uint16_t Index, void* lpContext )
+{
+  *(volatile double*)lpContext = m_Shield.getChannelAverage( 0 ).getMin();
+}
+
+/*! \brief Benchmark step: fixed point formatting, into a #FORMAT_NUMBER_LENGTH chars buffer. */
+void BenchmarkFormat( uint16_t Index, void* lpContext )
+{
+  formatFixed( (char*)lpContext, 2174L * Index, 4, 2, 0 );
+}
+
+/*! \brief Benchmark step: one idle controller cycle. */
+void BenchmarkControl( uint16_t Index, void* lpContext )
+{
+  m_Controller.doCycle();
+}
+
+/*! \brief Benchmark step: profile directory walk up to the profile whose index is pointed to. */
+void BenchmarkDirectory( uint16_t Index, void* lpContext )
+{
+  ProfileHeader_t Header;
+
+  LoadProfileHeader( Header, *(int*)lpContext );
+}
+
+/*! \brief Benchmark step: free EEPROM space lookup. */
+void BenchmarkFree( uint16_t Index, void* lpContext )
+{
+  FindFreeEEPROMStart();
+}
+
+/*! \brief Benchmark step: profiles subcommand lookup, in turn for every name copied into an array of names. */
+void BenchmarkLookup( uint16_t Index, void* lpContext )
+{
+  const char (*lpNames)[ COMMAND_NAME_LENGTH ] = (const char (*)[ COMMAND_NAME_LENGTH ])lpContext;
+
+  findCommand( lpNames[ Index % COMMANDS_COUNT( ProfilesCommands ) ], ProfilesCommands, COMMANDS_COUNT( ProfilesCommands ) );
+}
+
+
+/*!
+ * \brief Utility function timing a function and sending the result as <tt>bm[fn=name,us=total,per=call]</tt>.
+ * The calls are timed #BENCHMARK_CHUNK_CALLS at a time, the controller cycle running between chunks keeps the
+ * sensors scan and the safety supervisor going.
+ * \param lpName Timed function short name.
+ * \param lpStep Benchmark step calling the function.
+ * \param lpContext Context pointer for the step.
+ * \param Calls Number of calls to time.
+*/
+void RunBenchmark( const __FlashStringHelper* lpName, BenchmarkStep_t lpStep, void* lpContext, uint16_t Calls )
+{
+  char Txt[ FORMAT_NUMBER_LENGTH ];
+  unsigned long Time = 0;
+  uint16_t Index = 0;
+
+  while (Index < Calls)
+  {
+    uint16_t End = min( Calls, Index + BENCHMARK_CHUNK_CALLS );
+    unsigned long Start = micros();
+
+    for (; Index < End; Index++)
+      lpStep( Index, lpContext );
+    Time += micros() - Start;
+    m_Controller.doCycle();
+  }
+
+  m_Console.send( F(TEXTCONSOLE_EOLN "bm[fn=") );
+  m_Console.send( lpName );
+  m_Console.send( F(",us=") );
+  m_Console.send( Time );
+  m_Console.send( F(",per=") );
+  formatFixed( Txt, (Time * 100) / Calls, 2, 2, 0 );
+  m_Console.send( Txt );
+  m_Console.send( F("]") );
+}
+
+
+/*!
+ * \brief Interpreter command handler: BENCHMARK command.
+ * Times the sketch hot paths on the target, the optional argument giving the number of calls per function.
+ * Reports <tt>bench[n=calls]</tt> followed by one <tt>bm[...]</tt> record per function, times in <b>us</b>
+ * including the step call, with the interrupts left running, so the background load is counted too.
+ * The functions are: \c add and \c avg for the channel statistics update and average, \c min for the channel
+ * buffer minimum, \c fmt for the fixed point formatting, \c ctl for one idle controller cycle, \c dir for the
+ * profile directory walk up to the last profile header, \c free for the free EEPROM space lookup and \c cmd for
+ * a profiles subcommand lookup. Refused while the controller runs, its events would mix with the results.
+*/
+void CmdBenchmark( TextConsole* lpSilly )
+{
+  BenchmarkAverage_t Average;
+  char Names[ COMMANDS_COUNT( ProfilesCommands ) ][ COMMAND_NAME_LENGTH ];
+  char Txt[ FORMAT_NUMBER_LENGTH ];
+  volatile double Sink;
+  int LastProfile = GetProfilesCount() - 1;
+  long Calls = BENCHMARK_CALLS;
+
+  if (lpSilly->argsCount() > 1)
+  {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
+    return;
+  }
+
+  if (m_Controller.getRuning())
+  {
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+
+  if (lpSilly->argsCount() == 1)
+  {
+    Calls = atol( lpSilly->getArg( 0 ) );
+    if ((Calls < 1) || (Calls > BENCHMARK_MAX_CALLS))
+    {
+      lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGOUTOFRANGE) );
+      return;
+    }
+  }
+
+  for (uint8_t Index = 0; Index < COMMANDS_COUNT( ProfilesCommands ); Index++)
+    strcpy_P( Names[ Index ], ProfilesCommands[ Index ].Name );
+
+  lpSilly->beginResponse();
+  m_Console.send( F("bench[n=") );
+  m_Console.send( Calls );
+  m_Console.send( F("]") );
+  RunBenchmark( F("add"), BenchmarkAdd, &Average, Calls );
+  RunBenchmark( F("avg"), BenchmarkAverage, (void*)&Sink, Calls );
+  RunBenchmark( F("min"), BenchmarkMin, (void*)&Sink, Calls );
+  RunBenchmark( F("fmt"), BenchmarkFormat, Txt, Calls );
+  RunBenchmark( F("ctl"), BenchmarkControl, NULL, Calls );
+  RunBenchmark( F("dir"), BenchmarkDirectory, &LastProfile, Calls );
+  RunBenchmark( F("free"), BenchmarkFree, NULL, Calls );
+  RunBenchmark( F("cmd"), BenchmarkLookup, Names, Calls );
+  lpSilly->endResponse( CONSOLESUCCESS );
+}
@@ -0,0 +1,64 @@
+/*! \file
+ *  \brief Console command registry.
+ *  This file implements the console subcommands dispatcher.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "VLOvenCommands.h"
+
+
+int8_t findCommand( const char* lpName, const VLOvenCommand_t* lpCommands, uint8_t Count )
+{
+  uint8_t Low = 0;
+  uint8_t High = Count;
+
+  while (Low < High)
+  {
+    uint8_t Middle = (Low + High) / 2;
+    int Result = strcmp_P( lpName, lpCommands[ Middle ].Name );
+
+    if (Result > 0)
+      Low = Middle + 1;
+    else if (Result < 0)
+      High = Middle;
+    else
+      return Middle;
+  }
+  return -1;
+}
+
+
+void dispatchCommand( TextConsole* lpSilly, const VLOvenCommand_t* lpCommands, uint8_t Count, uint8_t Level )
+{
+  bool Missing = (lpSilly->argsCount() <= Level);
+  const char* lpName = Missing ? "" : lpSilly->getArg( Level );
+  uint8_t Args = Missing ? 0 : lpSilly->argsCount() - Level - 1;
+  int8_t Index = findCommand( lpName, lpCommands, Count );
+  VLOvenCommand_t Command;
+
+  if (Index < 0)
+  {
+    lpSilly->sendResponse( CONSOLEERROR, Missing ? F(TEXTCONSOLE_CMDARGSCOUNT) : F(TEXTCONSOLE_CMDARGINVALIDOPT) );
+    return;
+  }
+
+  memcpy_P( &Command, &lpCommands[ Index ], sizeof(Command) );
+  if (Command.lpSubCommands != NULL)
+    dispatchCommand( lpSilly, Command.lpSubCommands, Command.SubCommandsCount, Level + 1 );
+  else if ((Args < Command.MinArgs) || (Args > Command.MaxArgs))
+    lpSilly->sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDARGSCOUNT) );
+  else
+    Command.Handler( lpSilly );
+}
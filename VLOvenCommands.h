@@ -0,0 +1,112 @@
+/*! \file
+ *  \brief Console command registry.
+ *  This file declares the tables describing the console subcommands and their dispatcher.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenCommands_h_
+#define  _VLOvenCommands_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+#include <TextConsole.h>
+
+
+#define COMMAND_NAME_LENGTH     (4)       /*!< \brief Room for a command name, terminating zero included. */
+
+
+/*!
+ * \brief Command handler.
+ * Handlers read their arguments with absolute indexes, the command names included.
+*/
+typedef void (*VLOvenCommandHandler_t)( TextConsole* lpSilly );
+
+
+/*!
+ * \brief Command table entry.
+ * Tables live in flash and are sorted by name, an empty name matching a missing command name.
+ * An entry either runs a handler or looks up the next argument in a nested table.
+*/
+struct VLOvenCommand_t
+{
+  char Name[ COMMAND_NAME_LENGTH ];             /*!< \brief Command name, longer names do not compile. */
+  uint8_t MinArgs;                              /*!< \brief Minimum number of arguments after the name. */
+  uint8_t MaxArgs;                              /*!< \brief Maximum number of arguments after the name. */
+  VLOvenCommandHandler_t Handler;               /*!< \brief Command handler, \c NULL for a nested table. */
+  const VLOvenCommand_t* lpSubCommands;         /*!< \brief Nested table, \c NULL for a handler. */
+  uint8_t SubCommandsCount;                     /*!< \brief Number of entries in the nested table. */
+};
+
+
+/*!
+ * \brief Compile time command names comparison, as \c strcmp().
+*/
+constexpr int compareCommandNames( const char* lpName1, const char* lpName2 )
+{
+  return ((*lpName1 != *lpName2) || (*lpName1 == '\0')) ? (uint8_t)*lpName1 - (uint8_t)*lpName2 :
+    compareCommandNames( lpName1 + 1, lpName2 + 1 );
+}
+
+
+/*!
+ * \brief Compile time command table check.
+ * \return Returns \c true when the table is sorted by name, without duplicates, and every entry has a
+ *         consistent argument count range and either a handler or a nested table.
+*/
+constexpr bool checkCommands( const VLOvenCommand_t* lpCommands, size_t Count )
+{
+  return (Count == 0) ||
+    ((lpCommands[ 0 ].MinArgs <= lpCommands[ 0 ].MaxArgs) &&
+     ((lpCommands[ 0 ].Handler == NULL) != (lpCommands[ 0 ].lpSubCommands == NULL)) &&
+     ((Count == 1) || (compareCommandNames( lpCommands[ 0 ].Name, lpCommands[ 1 ].Name ) < 0)) &&
+     checkCommands( lpCommands + 1, Count - 1 ));
+}
+
+
+/*! \brief Number of entries in a command table. */
+#define COMMANDS_COUNT( Table )   (sizeof(Table) / sizeof(Table[ 0 ]))
+
+/*! \brief Reject at compile time a command table the dispatcher cannot search. */
+#define COMMANDS_CHECK( Table ) \
+  static_assert( checkCommands( Table, COMMANDS_COUNT( Table ) ), #Table ": unsorted names or inconsistent entries" )
+
+
+/*!
+ * \brief Look a command up by name.
+ * Binary search in the table, reading the names straight from flash.
+ *
+ * \param lpName Command name.
+ * \param lpCommands Command table, in flash.
+ * \param Count Number of entries in the table.
+ * \return Returns the index of the matching entry, \c -1 when there is none.
+*/
+extern int8_t findCommand( const char* lpName, const VLOvenCommand_t* lpCommands, uint8_t Count );
+
+
+/*!
+ * \brief Run the command matching an argument.
+ * The entry is looked up with #findCommand(). The argument count is checked against the entry before calling
+ * its handler, otherwise the error is reported on the console.
+ *
+ * \param lpSilly Console the command came from.
+ * \param lpCommands Command table, in flash.
+ * \param Count Number of entries in the table.
+ * \param Level Index of the argument holding the command name.
+*/
+extern void dispatchCommand( TextConsole* lpSilly, const VLOvenCommand_t* lpCommands, uint8_t Count, uint8_t Level = 0 );
+
+
+#endif  /* _VLOvenCommands_h_ */
@@ -28,14 +28,28 @@ VLOvenController::VLOvenController( VLOvenShield& shield, TextConsole& Console )
   m_Shield( shield ),
   m_Console( Console ),
   m_lpPhases( NULL ), m_CurrentPhase( 0 ), m_PhasesCount( 0 ),
-  m_Running( false ),
-  m_PID( &m_PID_Input, &m_PID_Output, &m_PID_Setpoint, 0, 0, 0, DIRECT )
-{}
+  m_Running( false ), m_Completed( false ), m_LastProcessDuration( 0 ),
+  m_LeadTime( PROFILE_SETPOINT_LEADTIME ), m_BlendTime( PROFILE_BLENDING_TIME ),
+  m_PIDSampleTime( PID_SAMPLE_TIME ), m_ProfileSamplingTime( PROFILE_SAMPLING_TIME ),
+  m_HeatingRateLimit( MAXIMUM_HEATING_RATE ), m_TelemetryDivider( 1 ), m_TelemetryCount( 0 ),
+  m_MeasuredSlope( MEASURED_SLOPE_SAMPLE_TIME ), m_SlopeSampleTime( 0 ),
+  m_SafetyFaults( SAFETY_FAULT_NONE ), m_RecordReady( false )
+{
+  memset( &m_Limits, 0, sizeof(m_Limits) );
+}
+
+
+/*! \brief Sensor channels regulating each heater zone. */
+static const uint8_t ZONE_SENSORS[ HEATER_CHANNELS ] = { HEATER_CHANNEL_SENSORS };
 
 
-void VLOvenController::setPhases( const VLOvenControllerPhase_t* lpPhases, int Count )
+void VLOvenController::setPhases( const VLOvenControllerPhase_t* lpPhases, int Count, const VLOvenQualityLimits_t* lpLimits )
 {
   Stop();
+  if (lpLimits != NULL)
+    m_Limits = *lpLimits;
+  else
+    memset( &m_Limits, 0, sizeof(m_Limits) );
   m_lpPhases = lpPhases;
   m_CurrentPhase = 0;
   m_Shield.setHeaterDuty( 0.0 );
@@ -44,6 +58,44 @@ void VLOvenController::setPhases( const VLOvenControllerPhase_t* lpPhases, int C
 }
 
 
+bool VLOvenController::checkPhases( const VLOvenControllerPhase_t* lpPhases, int Count )
+{
+  if ((lpPhases == NULL) || (Count < 1) || (Count > MAX_PROFILE_PHASES))
+    return false;
+
+  for (int Index = 0; Index < Count; Index++)
+  {
+    const VLOvenControllerPhase_t* lpPhase = &lpPhases[ Index ];
+
+    // NaN fails every comparison, so the ranges reject it too.
+    if ((memchr( lpPhase->Name, '\0', sizeof(lpPhase->Name) ) == NULL) ||
+      !((lpPhase->EndTemp >= 0.0) && (lpPhase->EndTemp <= SAFETY_MAX_TEMPERATURE)) ||
+      !(fabs( lpPhase->Slope ) <= MAXIMUM_TEMPERATURE_SLOPE) ||
+      (lpPhase->Duration < -1))
+      return false;
+
+    for (uint8_t Rule = 0; Rule < PHASE_EXIT_RULES; Rule++)
+    {
+      const VLOvenPhaseExit_t* lpRule = &lpPhase->Exit[ Rule ];
+
+      if ((lpRule->Condition > PHASE_EXIT_LOOP) ||
+        ((lpRule->Target >= Count) && (lpRule->Target != PHASE_EXIT_NEXT) && (lpRule->Target != PHASE_EXIT_STOP)))
+        return false;
+
+      // Profiles come from the console, only the configured input pins may be read.
+      if ((lpRule->Condition == PHASE_EXIT_INPUT) &&
+        ((lpRule->Level != (uint8_t)lpRule->Level) || !VLOvenShield::isInputPin( lpRule->Level )))
+        return false;
+
+      if ((lpRule->Condition == PHASE_EXIT_LOOP) && (lpRule->Time > PHASE_LOOP_MAX_COUNT))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+
 void VLOvenController::begin()
 {
   m_Shield.getLCD().begin( 20, 4 );
@@ -77,45 +129,479 @@ void VLOvenController::SetPIDTunings( double kp, double ki, double kd )
 }
 
 
+void VLOvenController::SetSetpointLeadTime( unsigned long LeadTime, unsigned long BlendTime )
+{
+  m_LeadTime = LeadTime;
+  m_BlendTime = BlendTime;
+}
+
+
+void VLOvenController::applySettings( const VLOvenSettings_t& Settings )
+{
+  SetPIDTunings( Settings.Kp, Settings.Ki, Settings.Kd );
+  SetSetpointLeadTime( Settings.LeadTime, Settings.BlendTime );
+  m_PIDSampleTime = Settings.PIDSampleTime;
+  m_ProfileSamplingTime = Settings.ProfileSampleTime;
+  m_HeatingRateLimit = Settings.MaxHeatingRate;
+  m_TelemetryDivider = Settings.TelemetryDivider;
+
+  // The PID rescales its integral and derivative terms for the new sampling time, no bump in the output.
+  if (m_Running)
+  {
+    for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+    {
+      m_Zones[ Zone ].Loop.SetSampleTime( m_PIDSampleTime );
+      m_Zones[ Zone ].Loop.SetTunings( m_PIDTunings.kp, m_PIDTunings.ki, m_PIDTunings.kd );
+    }
+  }
+}
+
+
+/*!
+ * \brief Convert a temperature value to trajectory fixed-point representation.
+ * \param Value Temperature value in degrees C.
+ * \return Returns the temperature value scaled by #TRAJECTORY_TEMP_SCALE.
+*/
+static int16_t toFixedTemp( double Value )
+{
+  return (int16_t)lround( constrain( Value, -327.0, 327.0 ) * TRAJECTORY_TEMP_SCALE );
+}
+
+
+void VLOvenController::compileTrajectory( const VLOvenControllerPhase_t* lpPhases, int Count, double StartTemp,
+  VLOvenTrajectorySegment_t* lpTrajectory ) const
+{
+  const VLOvenControllerPhase_t* lpPhase;
+  VLOvenTrajectorySegment_t* lpSegment;
+  int16_t Temp;
+  long Delta;
+  long Slope;
+
+  if (Count <= 0)
+    return;
+
+  Temp = toFixedTemp( isnan( StartTemp ) ? lpPhases[ 0 ].EndTemp : StartTemp );
+  for (int Index = 0; Index < Count; Index++)
+  {
+    lpPhase = &lpPhases[ Index ];
+    lpSegment = &lpTrajectory[ Index ];
+
+    // Phases are chained, each one starts where the previous one's envelope ends.
+    lpSegment->StartTemp = Temp;
+    lpSegment->EndTemp = toFixedTemp( lpPhase->EndTemp );
+    Delta = (long)lpSegment->EndTemp - (long)Temp;
+
+    if (lpPhase->Slope != 0.0)
+      Slope = toFixedTemp( fabs( lpPhase->Slope ) );
+    else if (lpPhase->Duration > 0)
+      Slope = (labs( Delta ) + lpPhase->Duration / 2) / lpPhase->Duration;
+    else
+      Slope = (long)(MAXIMUM_TEMPERATURE_SLOPE * TRAJECTORY_TEMP_SCALE);
+
+    if ((Slope == 0) && (Delta != 0))
+      Slope = 1;
+
+    // The slope sign always follows the ramp direction, the ramp time
+    // is derived from the rounded slope so the ramp ends where expected.
+    lpSegment->Slope = (int16_t)((Delta >= 0) ? Slope : -Slope);
+    lpSegment->RampTime = (Slope != 0) ? ((unsigned long)labs( Delta ) * 1000UL) / (unsigned long)Slope : 0;
+    lpSegment->Length = lpSegment->RampTime;
+
+    if (lpPhase->Duration < 0)
+      lpSegment->EndCondition = SEGMENT_END_NEVER;
+    else if (lpPhase->Duration > 0)
+    {
+      lpSegment->EndCondition = SEGMENT_END_TIME;
+      lpSegment->Length = max( lpSegment->RampTime, (unsigned long)lpPhase->Duration * 1000UL );
+    }
+    else if (Delta > 0)
+      lpSegment->EndCondition = SEGMENT_END_RISING;
+    else if (Delta < 0)
+      lpSegment->EndCondition = SEGMENT_END_FALLING;
+    else if (lpPhase->Slope == 0.0)
+      lpSegment->EndCondition = SEGMENT_END_SETTLED;
+    else
+      lpSegment->EndCondition = SEGMENT_END_TIME;
+
+    Temp = lpSegment->EndTemp;
+  }
+}
+
+
+int16_t VLOvenController::evalTrajectory( uint8_t Segment, long Time, int16_t* lpSlope )
+{
+  const VLOvenTrajectorySegment_t* lpSegment;
+
+  // Walk backwards across segment boundaries.
+  while ((Time < 0) && (Segment > 0))
+  {
+    Segment--;
+    Time += (long)m_Trajectory[ Segment ].Length;
+  }
+  if (Time < 0)
+    Time = 0;
+
+  // Walk forward across segment boundaries.
+  while (
+    (m_Trajectory[ Segment ].EndCondition != SEGMENT_END_NEVER) &&
+    ((unsigned long)Time >= m_Trajectory[ Segment ].Length) &&
+    (Segment < (m_PhasesCount - 1))
+  ) {
+    Time -= (long)m_Trajectory[ Segment ].Length;
+    Segment++;
+  }
+
+  lpSegment = &m_Trajectory[ Segment ];
+  if ((unsigned long)Time >= lpSegment->RampTime)
+  {
+    if (lpSlope)
+      *lpSlope = 0;
+    return lpSegment->EndTemp;
+  }
+
+  // Time is below the ramp time, the product can't exceed the ramp span times 1000.
+  if (lpSlope)
+    *lpSlope = lpSegment->Slope;
+  return lpSegment->StartTemp + (int16_t)(((long)lpSegment->Slope * Time) / 1000L);
+}
+
+
+int16_t VLOvenController::getTrajectorySetpoint( unsigned long PhaseTime )
+{
+  long HalfBlend;
+  const VLOvenTrajectorySegment_t* lpSegment = &m_Trajectory[ m_CurrentPhase ];
+
+  // Leading into the next phase would keep a hold phase from ever settling.
+  if (lpSegment->EndCondition == SEGMENT_END_SETTLED)
+  {
+    m_Slope = 0;
+    return lpSegment->EndTemp;
+  }
+
+  // While the phase is waiting for its end condition, the look-ahead
+  // stops advancing so the setpoint can't run away along the profile.
+  if ((lpSegment->EndCondition != SEGMENT_END_NEVER) && (PhaseTime > lpSegment->Length))
+    PhaseTime = lpSegment->Length;
+  PhaseTime += m_LeadTime;
+
+  if (m_BlendTime == 0)
+    return evalTrajectory( m_CurrentPhase, (long)PhaseTime, &m_Slope );
+
+  // Averaging both window ends is exact along a ramp and rounds the corners between phases.
+  HalfBlend = (long)(m_BlendTime / 2);
+  return (int16_t)(((long)evalTrajectory( m_CurrentPhase, (long)PhaseTime - HalfBlend, NULL ) + 
+    (long)evalTrajectory( m_CurrentPhase, (long)PhaseTime + HalfBlend, &m_Slope )) / 2);
+}
+
+
+bool VLOvenController::isPhaseEnded( unsigned long PhaseTime, int16_t Temp )
+{
+  const VLOvenTrajectorySegment_t* lpSegment = &m_Trajectory[ m_CurrentPhase ];
+
+  switch (lpSegment->EndCondition)
+  {
+    case SEGMENT_END_TIME :
+      return (PhaseTime >= lpSegment->Length);
+
+    case SEGMENT_END_RISING :
+      return (PhaseTime >= lpSegment->RampTime) && (Temp >= lpSegment->EndTemp);
+
+    // The loop holds the end temperature from above, its derivative kicks on the sensor steps keep the
+    // oven a little over it, and without a cooling actuator nothing pulls it further down.
+    case SEGMENT_END_FALLING :
+      return (PhaseTime >= lpSegment->RampTime) &&
+        (Temp <= lpSegment->EndTemp + (int16_t)(PHASE_SETTLED_BAND * TRAJECTORY_TEMP_SCALE));
+
+    case SEGMENT_END_SETTLED :
+      return m_MeasuredSlope.isValid() &&
+        (abs( m_MeasuredSlope.getSlope() ) <= (int16_t)(PHASE_SETTLED_SLOPE * TRAJECTORY_TEMP_SCALE)) &&
+        (abs( Temp - lpSegment->EndTemp ) <= (int16_t)(PHASE_SETTLED_BAND * TRAJECTORY_TEMP_SCALE));
+
+    default :
+      return false;
+  }
+}
+
+
+int VLOvenController::getExitTarget( uint8_t Target )
+{
+  if (Target == PHASE_EXIT_NEXT)
+    return m_CurrentPhase + 1;
+  if (Target >= m_PhasesCount)
+    return m_PhasesCount;
+  return Target;
+}
+
+
+int VLOvenController::getNextPhase( unsigned long PhaseTime, int16_t Temp )
+{
+  const VLOvenControllerPhase_t* lpPhase = &m_lpPhases[ m_CurrentPhase ];
+  unsigned long Now = millis();
+  unsigned long Elapsed = Now - m_ExitSampleTime;
+
+  m_ExitSampleTime = Now;
+  for (uint8_t Rule = 0; Rule < PHASE_EXIT_RULES; Rule++)
+  {
+    const VLOvenPhaseExit_t* lpRule = &lpPhase->Exit[ Rule ];
+    bool Met;
+
+    switch (lpRule->Condition)
+    {
+      case PHASE_EXIT_TIME :
+      case PHASE_EXIT_TIME_ABOVE :
+        Met = (lpRule->Condition == PHASE_EXIT_TIME) || (Temp >= lpRule->Level);
+
+        // Accumulated, never restarted within the phase.
+        if (Met)
+          m_ExitTime[ Rule ] += Elapsed;
+        Met = true;
+        break;
+
+      case PHASE_EXIT_ABOVE :
+        Met = (Temp >= lpRule->Level);
+        break;
+
+      case PHASE_EXIT_BELOW :
+        Met = (Temp <= lpRule->Level);
+        break;
+
+      case PHASE_EXIT_SLOPE_BELOW :
+        Met = m_MeasuredSlope.isValid() && (abs( m_MeasuredSlope.getSlope() ) <= lpRule->Level);
+        break;
+
+      case PHASE_EXIT_INPUT :
+        Met = (lpRule->Level == (uint8_t)lpRule->Level) && m_Shield.readInput( lpRule->Level );
+        break;
+
+      default :
+        continue;
+    }
+
+    if (lpRule->Condition > PHASE_EXIT_TIME_ABOVE)
+    {
+      if (Met)
+        m_ExitTime[ Rule ] += Elapsed;
+      else
+        m_ExitTime[ Rule ] = 0;
+    }
+
+    if (Met && (m_ExitTime[ Rule ] >= (unsigned long)lpRule->Time * 1000UL))
+      return getExitTarget( lpRule->Target );
+  }
+
+  if (!isPhaseEnded( PhaseTime, Temp ))
+    return -1;
+
+  for (uint8_t Rule = 0; Rule < PHASE_EXIT_RULES; Rule++)
+  {
+    const VLOvenPhaseExit_t* lpRule = &lpPhase->Exit[ Rule ];
+    int Target;
+
+    // A count the counter cannot reach would loop for ever.
+    if ((lpRule->Condition != PHASE_EXIT_LOOP) || (m_LoopCount[ m_CurrentPhase ] >= min( lpRule->Time, PHASE_LOOP_MAX_COUNT )))
+      continue;
+
+    // Loops jumped back over restart from scratch, so nested loops repeat on every outer pass.
+    Target = getExitTarget( lpRule->Target );
+    for (int Index = Target; Index < m_CurrentPhase; Index++)
+    {
+      m_LoopCount[ Index ] = 0;
+    }
+    m_LoopCount[ m_CurrentPhase ]++;
+    return Target;
+  }
+
+  return m_CurrentPhase + 1;
+}
+
+
+void VLOvenController::endPhaseRecord()
+{
+  unsigned long Duration = millis() - m_PhaseStartTime;
+
+  if (m_CurrentPhase < HISTORY_PHASES)
+    m_Record.PhaseTime[ m_CurrentPhase ] += (Duration + 500) / 1000;
+
+  // A hold phase that never settled took its whole length.
+  if (!m_PhaseSettled && isHoldPhase())
+    m_MaxSettlingTime = max( m_MaxSettlingTime, (uint16_t)(Duration / 1000) );
+}
+
+
+uint8_t VLOvenController::checkQuality( bool Completed )
+{
+  uint8_t Fail = Completed ? 0 : QA_FAIL_ABORTED;
+
+  if ((m_Limits.PeakMin && (m_Record.Peak < m_Limits.PeakMin * TRAJECTORY_TEMP_SCALE)) ||
+    (m_Limits.PeakMax && (m_Record.Peak > m_Limits.PeakMax * TRAJECTORY_TEMP_SCALE)))
+    Fail |= QA_FAIL_PEAK;
+  if ((m_Limits.TALMin && (m_Record.TimeAboveLiquidus < m_Limits.TALMin)) ||
+    (m_Limits.TALMax && (m_Record.TimeAboveLiquidus > m_Limits.TALMax)))
+    Fail |= QA_FAIL_TAL;
+  if (m_Limits.HeatingRateMax && (m_MaxHeatingRate > m_Limits.HeatingRateMax * (TRAJECTORY_TEMP_SCALE / 10)))
+    Fail |= QA_FAIL_HEATING;
+  if (m_Limits.CoolingRateMax && (m_MaxCoolingRate > m_Limits.CoolingRateMax * (TRAJECTORY_TEMP_SCALE / 10)))
+    Fail |= QA_FAIL_COOLING;
+  if (m_Limits.SettlingTimeMax && (m_MaxSettlingTime > m_Limits.SettlingTimeMax))
+    Fail |= QA_FAIL_SETTLING;
+
+  m_Console.beginEvent();
+  m_Console.send( F("qa[pass=") );
+  m_Console.send( Fail == 0 );
+  m_Console.send( F(",fail=") );
+  m_Console.send( Fail );
+  m_Console.send( F(",pk=") );
+  m_Console.send( (double)m_Record.Peak / TRAJECTORY_TEMP_SCALE );
+  m_Console.send( F(",tal=") );
+  m_Console.send( m_Record.TimeAboveLiquidus );
+  m_Console.send( F(",ovs=") );
+  m_Console.send( (double)m_Record.Overshoot / TRAJECTORY_TEMP_SCALE );
+  m_Console.send( F(",up=") );
+  m_Console.send( (double)m_MaxHeatingRate / TRAJECTORY_TEMP_SCALE );
+  m_Console.send( F(",dn=") );
+  m_Console.send( (double)m_MaxCoolingRate / TRAJECTORY_TEMP_SCALE );
+  m_Console.send( F(",stl=") );
+  m_Console.send( m_MaxSettlingTime );
+  m_Console.send( F("]") );
+  m_Console.endEvent();
+
+  return Fail;
+}
+
+
+void VLOvenController::endRunRecord( bool Completed )
+{
+  m_Record.Result = Completed ? HISTORY_RESULT_COMPLETED : 0;
+  m_Record.Faults = m_Shield.getSafety().getFaults();
+  m_Record.TimeAboveLiquidus = (m_TimeAboveLiquidus + 500) / 1000;
+  m_Record.Overshoot = (m_Record.Peak > m_ProfilePeak) ? m_Record.Peak - m_ProfilePeak : 0;
+  if (checkQuality( Completed ))
+    m_Record.Result |= HISTORY_RESULT_QA_FAILED;
+  m_RecordReady = true;
+}
+
+
+bool VLOvenController::popRunRecord( VLOvenRunRecord_t& Record )
+{
+  if (!m_RecordReady)
+    return false;
+
+  Record = m_Record;
+  m_RecordReady = false;
+  return true;
+}
+
+
+void VLOvenController::SendTrajectory()
+{
+  if ((m_lpPhases == NULL) || (m_PhasesCount > MAX_PROFILE_PHASES))
+    return;
+
+  if (!m_Running)
+    compileTrajectory( m_Shield.readTC() );
+
+  SendTrajectory( m_Trajectory, m_PhasesCount );
+}
+
+
+void VLOvenController::SendTrajectory( const VLOvenTrajectorySegment_t* lpTrajectory, int Count )
+{
+  const VLOvenTrajectorySegment_t* lpSegment;
+
+  for (int Index = 0; Index < Count; Index++)
+  {
+    lpSegment = &lpTrajectory[ Index ];
+
+    if (Index)
+      m_Console.send( F(TEXTCONSOLE_EOLN) );
+    m_Console.send( F("seg[idx=") );
+    m_Console.send( Index );
+    m_Console.send( F(",st=") );
+    m_Console.send( lpSegment->StartTemp );
+    m_Console.send( F(",end=") );
+    m_Console.send( lpSegment->EndTemp );
+    m_Console.send( F(",m=") );
+    m_Console.send( lpSegment->Slope );
+    m_Console.send( F(",rt=") );
+    m_Console.send( (unsigned long)lpSegment->RampTime );
+    m_Console.send( F(",len=") );
+    m_Console.send( (unsigned long)lpSegment->Length );
+    m_Console.send( F(",ec=") );
+    m_Console.send( lpSegment->EndCondition );
+    m_Console.send( F("]") );
+  }
+}
+
+
 void VLOvenController::startPhase( int PhaseIndex )
 {
   const VLOvenControllerPhase_t* lpCurrentPhase;
 
+  // The phase being left is over, Start() enters the first one with m_Running still false.
+  if (m_Running)
+  {
+    SendEnergyStats( m_CurrentPhase );
+    endPhaseRecord();
+  }
+  m_Energy.startPhase();
+  m_PhaseSettled = false;
+
   if ((PhaseIndex < 0) || (PhaseIndex >= m_PhasesCount))
   {
-    // End of process;
+    // End of process, nothing should be left heating.
+    for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+    {
+      m_Zones[ Zone ].Loop.SetMode( MANUAL );
+    }
+    m_Shield.setHeaterDuty( 0.0 );
+    m_Shield.setFanDuty( 0.0 );
+    m_Shield.setCoolerDuty( 0.0 );
     m_Running = false;
     m_CurrentPhase = -1;
+    m_Completed = true;
+    m_LastProcessDuration = millis() - m_ProcessStartTime;
+    SendEnergyStats( -1 );
+    m_Energy.endRun();
+    endRunRecord( true );
     SendOvenState();
     return;
   }
 
   m_CurrentPhase = PhaseIndex;
   lpCurrentPhase = &m_lpPhases[ m_CurrentPhase ];
-  m_StartTemp = m_Shield.readTC();
 
-  // Configure profile envelope generation parameters.
-  if (lpCurrentPhase->Slope > 0.0)
-    m_Slope = lpCurrentPhase->Slope;
-  else if (lpCurrentPhase->Duration > 0)
-    m_Slope = (lpCurrentPhase->EndTemp - m_StartTemp) / ((double)lpCurrentPhase->Duration);
-  else
-    m_Slope = lpCurrentPhase->EndTemp > m_StartTemp ? MAXIMUM_TEMPERATURE_SLOPE : -MAXIMUM_TEMPERATURE_SLOPE;
+  // The setpoint was already leading into this phase, carry on from there.
+  m_Setpoint = (double)getTrajectorySetpoint( 0 ) / TRAJECTORY_TEMP_SCALE;
+
+  // Falling ramps may pull the temperature down, negative outputs drive the cooling actuator.
+  double OutputMin = PID_OUTPUT_LIMIT_MIN;
+#if defined(PIN_COOLER)
+  if (m_Trajectory[ m_CurrentPhase ].EndTemp < m_Trajectory[ m_CurrentPhase ].StartTemp)
+    OutputMin = -PID_COOLING_LIMIT;
+#endif
+
+  for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+  {
+    VLOvenZone_t* lpZone = &m_Zones[ Zone ];
 
-  // The objective is to follow the profile envelope,
-  // it should not be a problem if current temperature is above the initial temperature
-  m_PID_Setpoint = m_StartTemp;
+    lpZone->Setpoint = m_Setpoint + lpCurrentPhase->ZoneOffset[ Zone ];
 
-  // Configure the PID controller.
-  m_PID.SetOutputLimits( PID_OUTPUT_LIMIT_MIN, PID_OUTPUT_LIMIT_MAX );
-  m_PID.SetSampleTime( PID_SAMPLE_TIME );
-  m_PID.SetTunings( m_PIDTunings.kp, m_PIDTunings.ki, m_PIDTunings.kd );
+    // Configure the PID controller.
+    lpZone->Loop.SetOutputLimits( OutputMin, PID_OUTPUT_LIMIT_MAX );
+    lpZone->Loop.SetSampleTime( m_PIDSampleTime );
+    lpZone->Loop.SetTunings( m_PIDTunings.kp, m_PIDTunings.ki, m_PIDTunings.kd );
 
-  // Turn the PID on
-  m_PID.SetMode( AUTOMATIC );
+    // Turn the PID on
+    lpZone->Loop.SetMode( AUTOMATIC );
+  }
 
   m_PhaseStartTime = millis();
   m_ProfileSampleTime = m_PhaseStartTime;
+  m_ExitSampleTime = m_PhaseStartTime;
+  for (uint8_t Rule = 0; Rule < PHASE_EXIT_RULES; Rule++)
+  {
+    m_ExitTime[ Rule ] = 0;
+  }
   
   m_Console.beginEvent();
   SendPhaseInfo( lpCurrentPhase );
@@ -125,9 +611,40 @@ void VLOvenController::startPhase( int PhaseIndex )
 
 bool VLOvenController::Start()
 {
-  if (!m_Running && (m_lpPhases != NULL))
+  double Temp = m_Shield.readTC();
+
+  // Without a reading there is no point the trajectory could start from.
+  if (
+    !m_Running && (m_lpPhases != NULL) && (m_PhasesCount > 0) && (m_PhasesCount <= MAX_PROFILE_PHASES) &&
+    (m_Shield.getSafety().getFaults() == SAFETY_FAULT_NONE) && !isnan( Temp )
+  )
   {
+    // The objective is to follow the profile envelope,
+    // it should not be a problem if current temperature is above the initial temperature
+    compileTrajectory( Temp );
+
     m_ProcessStartTime = millis();
+    m_Completed = false;
+    m_Energy.startRun();
+    m_EnergySampleTime = m_ProcessStartTime;
+
+    memset( &m_Record, 0, sizeof(m_Record) );
+    m_Record.PhasesCount = m_PhasesCount;
+    m_Record.StartTime = m_ProcessStartTime / 1000;
+    m_Record.Peak = INT16_MIN;
+    m_RecordReady = false;
+    m_TimeAboveLiquidus = 0;
+    m_RunSampleTime = m_ProcessStartTime;
+    m_ProfilePeak = INT16_MIN;
+    m_MaxHeatingRate = 0;
+    m_MaxCoolingRate = 0;
+    m_MaxSettlingTime = 0;
+    for (int Index = 0; Index < m_PhasesCount; Index++)
+    {
+      m_ProfilePeak = max( m_ProfilePeak, m_Trajectory[ Index ].EndTemp );
+    }
+    memset( m_LoopCount, 0, sizeof(m_LoopCount) );
+    m_Shield.setFanDuty( FAN_DUTY_RUNNING );
     startPhase( 0 );
 
     m_Running = true;
@@ -169,6 +686,43 @@ void VLOvenController::SendTemperatureSensorState()
 }
 
 
+void VLOvenController::SendSafetyState()
+{
+  m_Console.send( F("safety[flt=") );
+  m_Console.send( m_Shield.getSafety().getFaults() );
+  m_Console.send( F(",tmp=") );
+  m_Console.send( m_Shield.readTC() );
+  m_Console.send( F(",failed=") );
+  m_Console.send( m_Shield.getFailedChannels() );
+  m_Console.send( F("]") );
+}
+
+
+void VLOvenController::SendEnergyStats( int Phase )
+{
+  const VLOvenEnergyStats_t& Stats = (Phase < 0) ? m_Energy.getRunStats() : m_Energy.getPhaseStats();
+
+  m_Console.beginEvent();
+  if (Phase < 0)
+    m_Console.send( F("energy[run=1") );
+  else
+  {
+    m_Console.send( F("energy[ph=") );
+    m_Console.send( Phase );
+  }
+  m_Console.send( F(",ton=") );
+  m_Console.send( Stats.OnTime );
+  m_Console.send( F(",wh=") );
+  m_Console.send( VLOvenEnergy::toWattHours( Stats.OnTime ) );
+  m_Console.send( F(",pk=") );
+  m_Console.send( (double)Stats.PeakDuty / 10.0 );
+  m_Console.send( F(",sat=") );
+  m_Console.send( Stats.SaturatedTime );
+  m_Console.send( F("]") );
+  m_Console.endEvent();
+}
+
+
 void VLOvenController::SendOvenState()
 {
   m_Console.beginEvent();
@@ -191,6 +745,32 @@ void VLOvenController::SendPhaseInfo( const VLOvenControllerPhase_t* lpPhase )
     m_Console.send( lpPhase->Slope );
     m_Console.send( F(",t=") );
     m_Console.send( lpPhase->Duration );
+#if (HEATER_CHANNELS > 1)
+    for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+    {
+      m_Console.send( F(",z") );
+      m_Console.send( Zone );
+      m_Console.send( F("=") );
+      m_Console.send( lpPhase->ZoneOffset[ Zone ] );
+    }
+#endif
+    for (uint8_t Rule = 0; Rule < PHASE_EXIT_RULES; Rule++)
+    {
+      const VLOvenPhaseExit_t* lpRule = &lpPhase->Exit[ Rule ];
+
+      if (lpRule->Condition == PHASE_EXIT_NONE)
+        continue;
+      m_Console.send( F(",x") );
+      m_Console.send( Rule );
+      m_Console.send( F("=") );
+      m_Console.send( lpRule->Condition );
+      m_Console.send( F(":") );
+      m_Console.send( lpRule->Target );
+      m_Console.send( F(":") );
+      m_Console.send( lpRule->Level );
+      m_Console.send( F(":") );
+      m_Console.send( lpRule->Time );
+    }
     m_Console.send( F("]") );
   }
   else
@@ -200,100 +780,233 @@ void VLOvenController::SendPhaseInfo( const VLOvenControllerPhase_t* lpPhase )
 
 void VLOvenController::Stop()
 {
-  // Turn the PID off.
-  m_PID.SetMode( MANUAL );
+  // An aborted run is reported too, its heating counts for the lifetime on-time but not as a run.
+  if (m_Running)
+  {
+    SendEnergyStats( -1 );
+    m_Energy.flush();
+    endPhaseRecord();
+    endRunRecord( false );
+  }
+
+  // Turn the PIDs off.
+  for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+  {
+    m_Zones[ Zone ].Loop.SetMode( MANUAL );
+  }
   m_Shield.setHeaterDuty( 0.0 );
+  m_Shield.setFanDuty( 0.0 );
+  m_Shield.setCoolerDuty( 0.0 );
   m_Running = false;
   SendOvenState();
 }
 
 
+void VLOvenController::applyPowerBudget()
+{
+  double Total = 0.0;
+  double Scale = 1.0;
+  double Cooling = 0.0;
+
+  // Negative outputs ask for cooling, the actuator is shared by all the zones.
+  for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+  {
+    if (m_Zones[ Zone ].Output > 0.0)
+      Total += m_Zones[ Zone ].Output;
+    else
+      Cooling -= m_Zones[ Zone ].Output;
+  }
+
+  if (Total > HEATER_POWER_BUDGET)
+    Scale = HEATER_POWER_BUDGET / Total;
+
+  // Heating too fast, back off whatever the PIDs ask for.
+  if (getMeasuredSlope() > m_HeatingRateLimit)
+    Scale *= max( 0.0, 1.0 - (getMeasuredSlope() - m_HeatingRateLimit) / HEATING_RATE_BAND );
+
+  for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+  {
+    m_Shield.setHeaterDuty( Zone, max( 0.0, m_Zones[ Zone ].Output ) * Scale );
+  }
+  // A single actuator, each zone asking for full cooling gets it whatever the others do.
+  m_Shield.setCoolerDuty( min( 100.0, Cooling * 100.0 / PID_COOLING_LIMIT ) );
+}
+
+
 void VLOvenController::doCycle()
 {
   unsigned long Now;
   unsigned long ElapsedPhaseTime;
   PressedKeyCode_t Key;
-  const VLOvenControllerPhase_t* lpCurrentPhase;
 
   m_Shield.doCycle();
 
+  // The shield already cut the heaters, stop the process and tell about it.
+  if (m_Shield.getSafety().getFaults() != m_SafetyFaults)
+  {
+    m_SafetyFaults = m_Shield.getSafety().getFaults();
+    if (m_Running && (m_SafetyFaults != SAFETY_FAULT_NONE))
+      Stop();
+
+    m_Console.beginEvent();
+    SendSafetyState();
+    m_Console.endEvent();
+  }
+
+  if (MEASURED_SLOPE_SAMPLE_TIME <= (millis() - m_SlopeSampleTime))
+  {
+    double Temp = m_Shield.readTC();
+
+    m_SlopeSampleTime = millis();
+    // A gap would show up as a step, start over once the sensor is back.
+    if (isnan( Temp ))
+      m_MeasuredSlope.clear();
+    else
+      m_MeasuredSlope.addSample( toFixedTemp( Temp ) );
+  }
+
   if (m_Running)
   {
     Now = millis();
     ElapsedPhaseTime = Now - m_PhaseStartTime;
 
-    /* Read current temperature value */
-    m_PID_Input = m_Shield.readTC();
+    /* Read current temperature values */
+    m_Temperature = m_Shield.readTC();
+    for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+    {
+      m_Zones[ Zone ].Input = m_Shield.readTC( ZONE_SENSORS[ Zone ] );
+    }
 
-    //if (0 == (ElapsedPhaseTime % PROFILE_SAMPLING_TIME))
-    if (PROFILE_SAMPLING_TIME <= (Now - m_ProfileSampleTime))
+    if (m_ProfileSamplingTime <= (Now - m_ProfileSampleTime))
     {
-      lpCurrentPhase = &m_lpPhases[ m_CurrentPhase ];
       m_ProfileSampleTime = Now;
-      if (m_Slope != 0.0)
+
+      /* Run record figures */
+      if (!isnan( m_Temperature ))
       {
-        /* Adjust the setpoint for following the profile envelope */
-        m_PID_Setpoint = m_StartTemp + m_Slope * ((double)ElapsedPhaseTime / 1000.0);
-        if (m_StartTemp < lpCurrentPhase->EndTemp)
+        int16_t Temp = toFixedTemp( m_Temperature );
+
+        if (Temp > m_Record.Peak)
+          m_Record.Peak = Temp;
+        if (m_Temperature >= RUN_LIQUIDUS_TEMPERATURE)
+          m_TimeAboveLiquidus += Now - m_RunSampleTime;
+
+        if (!m_PhaseSettled && isHoldPhase() &&
+          (abs( Temp - m_Trajectory[ m_CurrentPhase ].EndTemp ) <= (int16_t)(PHASE_SETTLED_BAND * TRAJECTORY_TEMP_SCALE)))
         {
-          if (m_PID_Setpoint > lpCurrentPhase->EndTemp)
-          {
-            m_PID_Setpoint = lpCurrentPhase->EndTemp;
-            m_Slope = 0.0;
-          }
+          m_PhaseSettled = true;
+          m_MaxSettlingTime = max( m_MaxSettlingTime, (uint16_t)(ElapsedPhaseTime / 1000) );
         }
-        else if (m_StartTemp > lpCurrentPhase->EndTemp)
+      }
+      if (m_MeasuredSlope.isValid())
+      {
+        int16_t Rate = m_MeasuredSlope.getSlope();
+
+        m_MaxHeatingRate = max( m_MaxHeatingRate, Rate );
+        m_MaxCoolingRate = max( m_MaxCoolingRate, (int16_t)-Rate );
+      }
+      m_RunSampleTime = Now;
+
+      /* Adjust the setpoint for following the profile envelope */
+      m_Setpoint = (double)getTrajectorySetpoint( ElapsedPhaseTime ) / TRAJECTORY_TEMP_SCALE;
+
+      if (!isnan( m_Temperature ))
+      {
+        int NextPhase = getNextPhase( ElapsedPhaseTime, toFixedTemp( m_Temperature ) );
+
+        if (NextPhase >= 0)
+          startPhase( NextPhase );
+      }
+
+      if (m_Running)
+      {
+        for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
         {
-          if (m_PID_Setpoint < lpCurrentPhase->EndTemp)
-          {
-            m_PID_Setpoint = lpCurrentPhase->EndTemp;
-            m_Slope = 0.0;
-          }
+          m_Zones[ Zone ].Setpoint = m_Setpoint + m_lpPhases[ m_CurrentPhase ].ZoneOffset[ Zone ];
         }
       }
+    }
+
+    /* Let the PID controllers do their job */
+    bool Computed = false;
+    for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+    {
+      VLOvenZone_t* lpZone = &m_Zones[ Zone ];
 
-      if (m_Slope == 0.0)
+      if (isnan( lpZone->Input ))
       {
-        if (
-          /* Phase duration reached */
-          (
-            (lpCurrentPhase->Duration > 0) &&
-            (getPhaseDuration() / 1000 >= lpCurrentPhase->Duration)
-          ) ||
-          (
-            (lpCurrentPhase->Duration == 0) &&
-            (
-              /* Phase end temperature reached */
-              ((m_StartTemp <= lpCurrentPhase->EndTemp) && (m_PID_Input >= lpCurrentPhase->EndTemp)) ||
-              ((m_StartTemp >= lpCurrentPhase->EndTemp) && (m_PID_Input <= lpCurrentPhase->EndTemp))
-            )
-          )
-        ) {
-          startPhase( ++m_CurrentPhase );
+        // No usable sensor, the zone heater stays off until it comes back.
+        if (lpZone->Loop.GetMode() == AUTOMATIC)
+        {
+          lpZone->Loop.SetMode( MANUAL );
+          lpZone->Output = 0.0;
+          m_Shield.setHeaterDuty( Zone, 0.0 );
         }
       }
+      else
+      {
+        if (m_Running && (lpZone->Loop.GetMode() == MANUAL))
+          lpZone->Loop.SetMode( AUTOMATIC );
+        Computed |= lpZone->Loop.Compute();
+      }
     }
 
-    /* Let the PID controller do its job */
-    if (m_PID.Compute())
+    if (Computed)
     {
-      /* Handle the SSR */
-      m_Shield.setHeaterDuty( m_PID_Output );
-
-      m_Console.beginEvent();
-      m_Console.send( F("pid[pdt=") );
-      m_Console.send( getProcessDuration() );
-      m_Console.send( F(",tmp=") );
-      m_Console.send( m_PID_Input );
-      m_Console.send( F(",slp=") );
-      m_Console.send( m_Slope );
-      m_Console.send( F(",spt=") );
-      m_Console.send( m_PID_Setpoint );
-      m_Console.send( F(",out=") );
-      m_Console.send( m_PID_Output );
-      m_Console.send( F("]") );
-
-      m_Console.endEvent();
+      /* Account for the duty applied since the previous computation, then handle the SSRs */
+      uint16_t Duty = 0;
+      bool Saturated = false;
+
+      for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+      {
+        double ZoneDuty = m_Shield.getHeaterDuty( Zone );
+
+        Duty += (uint16_t)(ZoneDuty * 10.0 + 0.5);
+        Saturated |= (ZoneDuty >= 100.0);
+      }
+      m_Energy.addSample( Duty, Saturated, Now - m_EnergySampleTime );
+      m_EnergySampleTime = Now;
+
+      applyPowerBudget();
+
+      // Telemetry every few computations, at the fastest PID rates the serial link would not keep up.
+      if ((m_TelemetryDivider != 0) && (++m_TelemetryCount >= m_TelemetryDivider))
+      {
+        m_TelemetryCount = 0;
+        m_Console.beginEvent();
+        m_Console.send( F("pid[pdt=") );
+        m_Console.send( getProcessDuration() );
+        m_Console.send( F(",tmp=") );
+        m_Console.send( m_Temperature );
+        m_Console.send( F(",slp=") );
+        m_Console.send( (double)m_Slope / TRAJECTORY_TEMP_SCALE );
+        m_Console.send( F(",rate=") );
+        m_Console.send( getMeasuredSlope() );
+        m_Console.send( F(",spt=") );
+        m_Console.send( m_Setpoint );
+        m_Console.send( F(",out=") );
+        m_Console.send( m_Zones[ 0 ].Output );
+#if defined(PIN_COOLER)
+        m_Console.send( F(",cool=") );
+        m_Console.send( m_Shield.getCoolerDuty() );
+#endif
+#if (HEATER_CHANNELS > 1)
+        for (uint8_t Zone = 0; Zone < HEATER_CHANNELS; Zone++)
+        {
+          m_Console.send( F(",t") );
+          m_Console.send( Zone );
+          m_Console.send( F("=") );
+          m_Console.send( m_Zones[ Zone ].Input );
+          m_Console.send( F(",o") );
+          m_Console.send( Zone );
+          m_Console.send( F("=") );
+          m_Console.send( m_Zones[ Zone ].Output );
+        }
+#endif
+        m_Console.send( F("]") );
+
+        m_Console.endEvent();
+      }
     }
   }
   else
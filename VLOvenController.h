@@ -22,16 +22,47 @@
 #include <arduino.h>
 #include <PID_v1.h>
 #include "VLOvenShield.h"
+#include "VLOvenSlope.h"
+#include "VLOvenEnergy.h"
+#include "VLOvenHistory.h"
+#include "VLOvenSettings.h"
 
 
 #define PID_OUTPUT_LIMIT_MAX      (100.0)       /*!< \brief Upper limit for the PID output. */
 #define PID_OUTPUT_LIMIT_MIN      (0.0)         /*!< \brief Lower limit for the PID output. */
-#define PID_SAMPLE_TIME           (250)         /*!< \brief Sampling time for the PID in <b>ms</b>. */
-#define PROFILE_SAMPLING_TIME     (50)          /*!< \brief Sampling time for temperature profile generator in <b>ms</b>. */
+#define PID_COOLING_LIMIT         (100.0)       /*!< \brief Magnitude of the negative PID output driving the cooling actuator at full power. */
+#define PID_SAMPLE_TIME           (250)         /*!< \brief Default sampling time for the PID in <b>ms</b>. */
+#define PROFILE_SAMPLING_TIME     (50)          /*!< \brief Default sampling time for temperature profile generator in <b>ms</b>. */
 #define TEMPLOGSAMPLING_TIME      (500)         /*!< \brief Temperature reporting time while the oven controller is idle. */
 
+#define PROFILE_SETPOINT_LEADTIME (4000)        /*!< \brief Default look-ahead time in <b>ms</b> for the setpoint handed to the PID. */
+#define PROFILE_BLENDING_TIME     (2000)        /*!< \brief Default width in <b>ms</b> of the window blending the setpoint at phase boundaries. */
+
 #define MAX_PHASENAME_LEN         (10+1)        /*!< \brief Maximum number of chars for storing profile phase names. */
 #define MAXIMUM_TEMPERATURE_SLOPE 100.0         /*!< \brief Absolute maximum value for temperature slope specification. */
+#define MAX_PROFILE_PHASES        (16)          /*!< \brief Maximum number of phases the setpoint trajectory can hold. */
+#define MAX_HEATER_ZONES          (4)           /*!< \brief Maximum number of heater zones phase definitions can address. */
+
+#define FAN_DUTY_RUNNING          (100.0)       /*!< \brief Convection fan duty cycle while the controller is running. */
+
+#define MEASURED_SLOPE_SAMPLE_TIME (250)        /*!< \brief Sampling time in <b>ms</b> for the measured temperature slope estimator. */
+#define MAXIMUM_HEATING_RATE      (3.0)         /*!< \brief Default measured heating rate in degrees C/second above which the heater duty is throttled. */
+#define HEATING_RATE_BAND         (1.0)         /*!< \brief Heating rate excess in degrees C/second over which the throttling goes from none to full. */
+#define PHASE_SETTLED_SLOPE       (0.1)         /*!< \brief Measured slope magnitude in degrees C/second below which a hold phase is settled. */
+#define PHASE_SETTLED_BAND        (2.0)         /*!< \brief Distance to the end temperature in degrees C within which a hold phase is settled, or a falling phase ends. */
+#define RUN_LIQUIDUS_TEMPERATURE  (217.0)       /*!< \brief Solder liquidus temperature in degrees C, for the run time above liquidus. */
+
+#define QA_FAIL_PEAK              0x01          /*!< \brief Quality check failure: peak temperature out of limits. */
+#define QA_FAIL_TAL               0x02          /*!< \brief Quality check failure: time above liquidus out of limits. */
+#define QA_FAIL_HEATING           0x04          /*!< \brief Quality check failure: measured heating rate too high. */
+#define QA_FAIL_COOLING           0x08          /*!< \brief Quality check failure: measured cooling rate too high. */
+#define QA_FAIL_SETTLING          0x10          /*!< \brief Quality check failure: a hold phase took too long to settle. */
+#define QA_FAIL_ABORTED           0x80          /*!< \brief Quality check failure: the run did not complete. */
+
+#if (HEATER_CHANNELS > MAX_HEATER_ZONES)
+# error "HEATER_CHANNELS exceeds the number of zones addressable from phase definitions."
+#endif
+#define TRAJECTORY_TEMP_SCALE     (100)         /*!< \brief Fixed-point scale for trajectory temperatures and slopes, values are stored in 1/100 degrees C. */
 
 
 /*!
@@ -45,6 +76,44 @@ typedef struct {
 } PIDTunings_t;
 
 
+#define PHASE_EXIT_RULES          (2)           /*!< \brief Number of exit rules per phase. */
+#define PHASE_EXIT_NEXT           (0xFF)        /*!< \brief Exit rule target: go on with the next phase. */
+#define PHASE_EXIT_STOP           (0xFE)        /*!< \brief Exit rule target: end the process. */
+#define PHASE_LOOP_MAX_COUNT      (255)         /*!< \brief Highest loop rule count, the range of the loop counters. */
+
+
+/*!
+ * \brief Phase exit rule conditions.
+ * Codes identifying the condition checked by a phase exit rule. Unless noted otherwise the condition must hold
+ * continuously for the rule \b Time before the rule fires.
+*/
+typedef enum {
+  PHASE_EXIT_NONE,          /*!< \brief Unused rule. */
+  PHASE_EXIT_TIME,          /*!< \brief Fires once the phase lasted \b Time, a maximum phase duration. */
+  PHASE_EXIT_TIME_ABOVE,    /*!< \brief Fires once the temperature was at or above \b Level for \b Time in total during the phase,
+                                 time above liquidus. */
+  PHASE_EXIT_ABOVE,         /*!< \brief Fires when the temperature is at or above \b Level. */
+  PHASE_EXIT_BELOW,         /*!< \brief Fires when the temperature is at or below \b Level. */
+  PHASE_EXIT_SLOPE_BELOW,   /*!< \brief Fires when the measured slope magnitude is at or below \b Level, the temperature is stable. */
+  PHASE_EXIT_INPUT,         /*!< \brief Fires when the input pin \b Level, one of #EXIT_INPUT_PINS, is pulled low, for instance by a switch. */
+  PHASE_EXIT_LOOP           /*!< \brief Checked when the phase ends normally: jumps to \b Target up to \b Time times, at most
+                                 #PHASE_LOOP_MAX_COUNT, counted since the process start or since an outer loop jumped back over
+                                 this phase. */
+} VLOvenPhaseExitCondition_t;
+
+
+/*!
+ * \brief Phase exit rule.
+ * Compact rule ending the phase on a condition, and optionally branching to a phase other than the next one.
+*/
+typedef struct {
+  uint8_t Condition;        /*!< \brief Condition code, one of #VLOvenPhaseExitCondition_t values. */
+  uint8_t Target;           /*!< \brief Index of the phase to go to, #PHASE_EXIT_NEXT or #PHASE_EXIT_STOP. */
+  int16_t Level;            /*!< \brief Temperature in 1/100 degrees C, slope in 1/100 degrees C/second, or input pin. */
+  uint16_t Time;            /*!< \brief Time in seconds, or loop count. */
+} VLOvenPhaseExit_t;
+
+
 /*!
  * \brief Oven control phase parameters definition.
  * Fields in this structure control how the oven operates during a temperature control phase.
@@ -63,12 +132,80 @@ typedef struct {
   double Slope;
 
   /*! \brief Minimum phase duration in seconds.
-      \remarks When specified as \c 0 seconds, the temperature controller changes to next phase when the final temperature is reached.
+      \remarks When specified as \c 0 seconds, the temperature controller changes to next phase when the final temperature is reached,
+      or for a phase holding the previous phase temperature with \c 0.0 slope, once the measured temperature settled there.
       The value \c -1 instructs the controller to stay in current phase \c indefinitely.*/
   int Duration;
+
+  /*! \brief Per-zone setpoint offset in degrees C.
+      \remarks Each heater zone regulates at the profile setpoint plus its offset, so for instance the bottom element
+      can run hotter than the top one. Offsets for zones not present in the oven are ignored. */
+  int8_t ZoneOffset[ MAX_HEATER_ZONES ];
+
+  /*! \brief Additional exit rules, checked in order on every profile sampling.
+      \remarks The first rule firing ends the phase. Rules never firing leave the phase to its regular end condition,
+      so a phase lasting indefinitely with rules only ends through them. */
+  VLOvenPhaseExit_t Exit[ PHASE_EXIT_RULES ];
 } VLOvenControllerPhase_t;
 
 
+/*!
+ * \brief Profile quality limits.
+ * Tolerance windows the run metrics are checked against at the end of every run. A \c 0 limit is not checked.
+*/
+typedef struct {
+  int16_t PeakMin;          /*!< \brief Lowest peak temperature in degrees C. */
+  int16_t PeakMax;          /*!< \brief Highest peak temperature in degrees C. */
+  uint16_t TALMin;          /*!< \brief Shortest time above liquidus in seconds. */
+  uint16_t TALMax;          /*!< \brief Longest time above liquidus in seconds. */
+  uint8_t HeatingRateMax;   /*!< \brief Highest measured heating rate in 1/10 degrees C/second. */
+  uint8_t CoolingRateMax;   /*!< \brief Highest measured cooling rate in 1/10 degrees C/second. */
+  uint8_t SettlingTimeMax;  /*!< \brief Longest time in seconds for a hold phase to get within #PHASE_SETTLED_BAND. */
+} VLOvenQualityLimits_t;
+
+
+/*!
+ * \brief Trajectory segment end conditions.
+ * Codes identifying how the phase described by a trajectory segment terminates.
+*/
+typedef enum {
+  SEGMENT_END_TIME,         /*!< \brief The segment ends once its nominal length elapsed. */
+  SEGMENT_END_RISING,       /*!< \brief The segment ends after the ramp, once the temperature rises up to the end temperature. */
+  SEGMENT_END_FALLING,      /*!< \brief The segment ends after the ramp, once the temperature falls within #PHASE_SETTLED_BAND of the end temperature. */
+  SEGMENT_END_NEVER,        /*!< \brief The segment lasts indefinitely. */
+  SEGMENT_END_SETTLED       /*!< \brief The segment ends once the temperature settles next to the end temperature. */
+} VLOvenSegmentEnd_t;
+
+
+/*!
+ * \brief Setpoint trajectory segment.
+ * Fixed-point piecewise-linear setpoint envelope for one phase, compiled from the phase control parameters 
+ * when the process starts. Temperatures and slopes are scaled by #TRAJECTORY_TEMP_SCALE.
+*/
+typedef struct {
+  int16_t StartTemp;        /*!< \brief Nominal setpoint at segment start. */
+  int16_t EndTemp;          /*!< \brief Setpoint at the end of the ramp. */
+  int16_t Slope;            /*!< \brief Ramp slope per second, its sign follows the ramp direction. */
+  uint8_t EndCondition;     /*!< \brief Phase end condition, one of #VLOvenSegmentEnd_t values. */
+  uint32_t RampTime;        /*!< \brief Ramp duration in <b>ms</b>. */
+  uint32_t Length;          /*!< \brief Nominal segment duration in <b>ms</b>, not used by #SEGMENT_END_NEVER segments. */
+} VLOvenTrajectorySegment_t;
+
+
+/*!
+ * \brief Heater zone control loop.
+ * Each heater zone is regulated by its own PID controller, reading the sensor channel next to the heater.
+*/
+struct VLOvenZone_t {
+  double Input;             /*!< \brief Zone temperature, read from the zone sensor channel. */
+  double Output;            /*!< \brief PID output, requested zone heater duty cycle. */
+  double Setpoint;          /*!< \brief Zone setpoint, profile setpoint plus the phase zone offset. */
+  PID Loop;                 /*!< \brief PID controller implementation instance. */
+
+  VLOvenZone_t() : Input( 0.0 ), Output( 0.0 ), Setpoint( 0.0 ), Loop( &Input, &Output, &Setpoint, 0, 0, 0, DIRECT ) {}
+};
+
+
 /*!
  * \brief Oven controller implementation class.
  * This class implements functionalities required for controlling the oven.
@@ -105,9 +242,17 @@ class VLOvenController
      * \brief Get the current setpoint (requested temperature for the tempearture controller).
      * \return A value indicating the requested oven temperature for the temperature controller.
      * \remarks This value changes over time at a rate defined by #PROFILE_SAMPLING_TIME to follow the temperatuure 
-     * envelope established in the phase configuration structure.
+     * envelope established in the phase configuration structure. The value leads the envelope by the time interval
+     * configured with #SetSetpointLeadTime().
     */
-    double getSetpoint() { return m_PID_Setpoint; }
+    double getSetpoint() { return m_Setpoint; }
+
+    /*!
+     * \brief Get the measured temperature slope.
+     * \return Returns the control temperature rate of change in degrees C/second, estimated over the last
+     * #SLOPE_WINDOW_SAMPLES samples taken every #MEASURED_SLOPE_SAMPLE_TIME.
+    */
+    double getMeasuredSlope() { return (double)m_MeasuredSlope.getSlope() / TRAJECTORY_TEMP_SCALE; }
     
     
     /*!
@@ -128,12 +273,24 @@ class VLOvenController
      * \param lpPhases Pointer to the first entry in the list of phase control parameters. Can be \c NULL to force the 
      * oven controller to stop operation.
      * \param Count Number of phases defined in the phases list.
+     * \param lpLimits Quality limits the runs are checked against, \c NULL for not checking any.
+    */
+    void setPhases( const VLOvenControllerPhase_t* lpPhases, int Count, const VLOvenQualityLimits_t* lpLimits = NULL );
+
+    /*!
+     * \brief Check a phase control parameters list before it gets stored.
+     * \param lpPhases Pointer to the first entry in the list of phase control parameters.
+     * \param Count Number of phases defined in the phases list.
+     * \return Returns \c true when every phase has a terminated name, temperatures and slopes within the oven
+     * limits, a valid duration and exit rules with known conditions and targets inside the list, input rules
+     * reading one of #EXIT_INPUT_PINS and loop rules counting up to #PHASE_LOOP_MAX_COUNT.
     */
-    void setPhases( const VLOvenControllerPhase_t* lpPhases, int Count );
+    static bool checkPhases( const VLOvenControllerPhase_t* lpPhases, int Count );
     
     /*!
      * \brief Enables the oven controller for operation.
      * \remarks Prior to enabling operation, the phase control parameters list must be established using the function #setPhases().
+     * The process can't start while the safety supervisor has a fault latched, nor without a valid temperature reading.
      * \return Returns \c true on successful process start, \c false otherwise.
     */
     bool Start();
@@ -159,6 +316,19 @@ class VLOvenController
     */
     unsigned long getPhaseDuration();
 
+    /*!
+     * \brief Check how the last process ended.
+     * \return Returns \c true when the last process went through all its phases, \c false when it was stopped,
+     * or is still running.
+    */
+    bool getCompleted() { return m_Completed; };
+
+    /*!
+     * \brief Get the duration of the last completed process in \b ms.
+     * \return Returns the last completed process duration, \c 0 if none completed yet.
+    */
+    unsigned long getLastProcessDuration() { return m_LastProcessDuration; };
+
     /*!
      * \brief Send an asych event with a value indicating the current oven state.
      * \remarks This function must NOT be called when already started sending a console command response.
@@ -184,24 +354,112 @@ class VLOvenController
     */
     void SetPIDTunings( double kp, double ki, double kd );
 
+    /*!
+     * \brief Set the setpoint generator look-ahead parameters.
+     * \param LeadTime Time interval in \b ms the setpoint leads the temperature envelope, compensating the oven thermal lag.
+     * \param BlendTime Width in \b ms of the window used for blending the envelope at phase boundaries, \c 0 disables blending.
+    */
+    void SetSetpointLeadTime( unsigned long LeadTime, unsigned long BlendTime = PROFILE_BLENDING_TIME );
+
+    /*!
+     * \brief Take the tunable settings.
+     * \param Settings Settings to use from now on. While running, the PID tunings and sampling time apply right
+     * away, the setpoint generator look-ahead parameters ought to be changed only while idle.
+    */
+    void applySettings( const VLOvenSettings_t& Settings );
+
+    /*!
+     * \brief Send a text message describing the safety supervisor state.
+    */
+    void SendSafetyState();
+
+    /*!
+     * \brief Send a text message with heater energy statistics.
+     * \param Phase Index of the phase the statistics belong to, \c -1 for the whole run.
+    */
+    void SendEnergyStats( int Phase );
+
+    /*!
+     * \brief Method for accessing the heater energy accounting instance.
+     * \return Returns a reference to the heater energy accounting, which owns the lifetime counters.
+    */
+    VLOvenEnergy& getEnergy() { return m_Energy; }
+
+    /*!
+     * \brief Get the record of the last run, once.
+     * \param Record Variable receiving the record, the profile index is left for the caller to fill.
+     * \return Returns \c true when a run ended since the previous call.
+    */
+    bool popRunRecord( VLOvenRunRecord_t& Record );
+
+    /*!
+     * \brief Send a text message listing the setpoint trajectory segments.
+     * \remarks When the controller is not running, the trajectory is compiled from the current phases list
+     * starting at current temperature, or at the first phase end temperature when there is no valid reading.
+    */
+    void SendTrajectory();
+
+    /*!
+     * \brief Send a text message listing the given setpoint trajectory segments.
+     * \param lpTrajectory Trajectory segments, as compiled by #compileTrajectory().
+     * \param Count Number of segments.
+    */
+    void SendTrajectory( const VLOvenTrajectorySegment_t* lpTrajectory, int Count );
+
+    /*!
+     * \brief Compute the setpoint trajectory for a phases list, leaving the controller untouched.
+     * \param lpPhases Phases list.
+     * \param Count Number of phases.
+     * \param StartTemp Temperature the first phase starts from, \c NAN for starting at its own end temperature.
+     * \param lpTrajectory Buffer receiving one segment per phase.
+    */
+    void compileTrajectory( const VLOvenControllerPhase_t* lpPhases, int Count, double StartTemp,
+      VLOvenTrajectorySegment_t* lpTrajectory ) const;
+
   private :
     bool m_Running;                                           /*!< General status flag, indicates whether the controller is running or not. */
     TextConsole& m_Console;                                   /*!< Reference to remote PC console interface */
     VLOvenShield&  m_Shield;                                /*!< Reference to the hardware abstraction layer implementation. */
-    PID m_PID;                                                /*!< PID controller implementation instance. */
+    VLOvenZone_t m_Zones[ HEATER_CHANNELS ];                  /*!< Heater zones control loops. */
     const VLOvenControllerPhase_t* m_lpPhases;              /*!< Pointer to the first entry in the list of phase control parameters. */
     int m_PhasesCount;                                        /*!< Configured phases count */
     int m_CurrentPhase;                                       /*!< Index to current phase control parameters into the phases list. */
-    double m_PID_Setpoint;                                    /*!< PID setpoint, requested oven temperature.*/
-    double m_PID_Input;                                       /*!< Input value for the PID controller, read from the shield temperature sensor using function #VLOvenShield::readTC(). */
-    double m_PID_Output;                                      /*!< Output value from the PID controller, used for commanding the SSR duty cycle. */
-    double m_Slope;                                           /*!< Current temperature profile envelope slope. */
+    double m_Setpoint;                                        /*!< Profile setpoint, requested oven temperature.*/
+    double m_Temperature;                                     /*!< Process temperature, read from the shield temperature sensor using function #VLOvenShield::readTC(). */
+    int16_t m_Slope;                                          /*!< Current temperature profile envelope slope, scaled by #TRAJECTORY_TEMP_SCALE. */
     unsigned long m_PhaseStartTime;                           /*!< Time of current phase start, undefined if #m_Running is \c false. */
     unsigned long m_ProcessStartTime;                         /*!< Time of process start, undefined if #m_Running is \c false. */
+    bool m_Completed;                                         /*!< Last process went through all its phases. */
+    unsigned long m_LastProcessDuration;                      /*!< Duration in ms of the last completed process. */
     unsigned long m_ProfileSampleTime;                        /*!< Time of previous profile sampling. */
     unsigned long m_TemperatureSampleTime;                    /*!< Time of previous temperature log sampling. */
+    VLOvenSlope m_MeasuredSlope;                              /*!< Measured control temperature slope estimator. */
+    unsigned long m_SlopeSampleTime;                          /*!< Time of previous slope estimator sampling. */
+    uint8_t m_SafetyFaults;                                   /*!< Safety supervisor faults already reported. */
+    unsigned long m_ExitTime[ PHASE_EXIT_RULES ];             /*!< Time in ms each exit rule condition held in current phase. */
+    unsigned long m_ExitSampleTime;                           /*!< Time of previous exit rules evaluation. */
+    uint8_t m_LoopCount[ MAX_PROFILE_PHASES ];                /*!< Number of jumps taken by each phase loop rule. */
+    VLOvenEnergy m_Energy;                                    /*!< Heater energy accounting. */
+    unsigned long m_EnergySampleTime;                         /*!< Time of previous heater energy accounting. */
+    VLOvenRunRecord_t m_Record;                               /*!< Current, or last, run record. */
+    bool m_RecordReady;                                       /*!< #m_Record holds a finished run not taken yet. */
+    unsigned long m_TimeAboveLiquidus;                        /*!< Current run time in ms above #RUN_LIQUIDUS_TEMPERATURE. */
+    unsigned long m_RunSampleTime;                            /*!< Time of previous run record sampling. */
+    int16_t m_ProfilePeak;                                    /*!< Highest profile temperature, scaled by #TRAJECTORY_TEMP_SCALE. */
+    VLOvenQualityLimits_t m_Limits;                           /*!< Quality limits for the current profile. */
+    int16_t m_MaxHeatingRate;                                 /*!< Current run highest measured heating rate, scaled by #TRAJECTORY_TEMP_SCALE. */
+    int16_t m_MaxCoolingRate;                                 /*!< Current run highest measured cooling rate, scaled by #TRAJECTORY_TEMP_SCALE. */
+    uint16_t m_MaxSettlingTime;                               /*!< Current run longest hold phase settling time in seconds. */
+    bool m_PhaseSettled;                                      /*!< Current hold phase got within #PHASE_SETTLED_BAND. */
     PIDTunings_t m_PIDTunings;                                /*!< Control parameters for the PID controller. */
-    double m_StartTemp;                                       /*!< Buffer for storing the temperature value at which current phase started. */
+    unsigned long m_LeadTime;                                 /*!< Setpoint look-ahead time in ms. */
+    unsigned long m_BlendTime;                                /*!< Setpoint blending window width at phase boundaries in ms. */
+    uint16_t m_PIDSampleTime;                                 /*!< PID sampling time in ms. */
+    uint16_t m_ProfileSamplingTime;                           /*!< Temperature profile generator sampling time in ms. */
+    float m_HeatingRateLimit;                                 /*!< Measured heating rate in degrees C/second above which the heater duty is throttled. */
+    uint8_t m_TelemetryDivider;                               /*!< Number of PID computations per \c pid event, \c 0 for none. */
+    uint8_t m_TelemetryCount;                                 /*!< PID computations since the last \c pid event. */
+    VLOvenTrajectorySegment_t m_Trajectory[ MAX_PROFILE_PHASES ]; /*!< Setpoint trajectory, one segment per phase. */
 
     /*!
      * \brief Setup controller parameters for executing a process phase.
@@ -210,6 +468,83 @@ class VLOvenController
      * oven controller to stop operation.
     */
     void startPhase( int PhaseIndex );
+
+    /*!
+     * \brief Compute the setpoint trajectory for the whole phases list.
+     * \param StartTemp Temperature the first phase starts from.
+    */
+    void compileTrajectory( double StartTemp ) { compileTrajectory( m_lpPhases, m_PhasesCount, StartTemp, m_Trajectory ); }
+
+    /*!
+     * \brief Evaluate the setpoint trajectory.
+     * \param Segment Index of the segment the time is relative to.
+     * \param Time Time in \b ms relative to the segment start, can go past either segment boundary.
+     * \param lpSlope Optional buffer receiving the envelope slope at the evaluated point.
+     * \return Returns the trajectory setpoint at the requested time, scaled by #TRAJECTORY_TEMP_SCALE.
+    */
+    int16_t evalTrajectory( uint8_t Segment, long Time, int16_t* lpSlope );
+
+    /*!
+     * \brief Calculate the look-ahead setpoint for the current phase.
+     * \param PhaseTime Elapsed time in \b ms from current phase start.
+     * \return Returns the blended setpoint, #m_LeadTime ahead in the trajectory, scaled by #TRAJECTORY_TEMP_SCALE.
+    */
+    int16_t getTrajectorySetpoint( unsigned long PhaseTime );
+
+    /*!
+     * \brief Evaluate the end condition for the current phase.
+     * \param PhaseTime Elapsed time in \b ms from current phase start.
+     * \param Temp Current temperature, scaled by #TRAJECTORY_TEMP_SCALE.
+     * \return Returns \c true when the current phase should end.
+    */
+    bool isPhaseEnded( unsigned long PhaseTime, int16_t Temp );
+
+    /*!
+     * \brief Evaluate the current phase exit rules, then its regular end condition.
+     * \param PhaseTime Elapsed time in \b ms from current phase start.
+     * \param Temp Current temperature, scaled by #TRAJECTORY_TEMP_SCALE.
+     * \return Returns the index of the phase to go to, #m_PhasesCount for ending the process, or \c -1 for staying
+     * in the current phase.
+    */
+    int getNextPhase( unsigned long PhaseTime, int16_t Temp );
+
+    /*!
+     * \brief Resolve an exit rule target.
+     * \param Target Exit rule target.
+     * \return Returns the index of the phase to go to, #m_PhasesCount for ending the process.
+    */
+    int getExitTarget( uint8_t Target );
+
+    /*!
+     * \brief Add the time spent in the current phase to the run record.
+    */
+    void endPhaseRecord();
+
+    /*!
+     * \brief Complete the run record.
+     * \param Completed Whether the run went through all its phases.
+    */
+    void endRunRecord( bool Completed );
+
+    /*!
+     * \brief Check the run metrics against the quality limits and send the result.
+     * \param Completed Whether the run went through all its phases.
+     * \return Returns the \c QA_FAIL_xxx flags for the failed checks.
+    */
+    uint8_t checkQuality( bool Completed );
+
+    /*!
+     * \brief Check whether the current phase holds a constant temperature.
+    */
+    bool isHoldPhase() { return m_Trajectory[ m_CurrentPhase ].StartTemp == m_Trajectory[ m_CurrentPhase ].EndTemp; }
+
+    /*!
+     * \brief Command the heater channels from the zones PID outputs.
+     * When the zones together request more power than #HEATER_POWER_BUDGET, all outputs are scaled down proportionally.
+     * The same happens while the measured heating rate exceeds #MAXIMUM_HEATING_RATE, down to no power at all
+     * #HEATING_RATE_BAND above it.
+    */
+    void applyPowerBudget();
 };
 
 #endif  /* _VLOvenController_h_ */
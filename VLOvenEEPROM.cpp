@@ -0,0 +1,160 @@
+/*! \file
+ *  \brief Interrupt driven EEPROM writer.
+ *  This file implements the class methods for the interrupt driven EEPROM writer.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <avr/eeprom.h>
+#include "VLOvenEEPROM.h"
+
+
+VLOvenEEPROMRequest_t VLOvenEEPROM::s_Queue[ EEPROM_QUEUE_LENGTH ];
+volatile uint8_t VLOvenEEPROM::s_Done = 0;
+volatile uint8_t VLOvenEEPROM::s_Head = 0;
+volatile uint8_t VLOvenEEPROM::s_Tail = 0;
+uint16_t VLOvenEEPROM::s_Position = 0;
+
+
+ISR(EE_READY_vect)
+{
+  VLOvenEEPROM::onReady();
+}
+
+
+/*!
+ * \brief Read one EEPROM byte from the interrupt, the EEPROM is known to be ready.
+*/
+static inline uint8_t readReady( uint16_t Offset )
+{
+  EEAR = Offset;
+  EECR |= _BV( EERE );
+  return EEDR;
+}
+
+
+bool VLOvenEEPROM::push( uint8_t Type, int Offset, uintptr_t Source, int Length, VLOvenEEPROMCallback_t lpCallback, void* lpContext )
+{
+  VLOvenEEPROMRequest_t* lpRequest;
+
+  if (getFree() == 0)
+    return false;
+
+  // Only the interrupt reads the entry, and only once the tail moves past it.
+  lpRequest = &s_Queue[ s_Tail & (EEPROM_QUEUE_LENGTH - 1) ];
+  lpRequest->Offset = Offset;
+  lpRequest->Length = Length;
+  lpRequest->Source = Source;
+  lpRequest->Type = Type;
+  lpRequest->lpCallback = lpCallback;
+  lpRequest->lpContext = lpContext;
+  s_Tail++;
+
+  EECR |= _BV( EERIE );
+  return true;
+}
+
+
+void VLOvenEEPROM::onReady()
+{
+  for (uint8_t Step = 0; Step < EEPROM_ISR_STEPS; Step++)
+  {
+    const VLOvenEEPROMRequest_t* lpRequest;
+    uint16_t Index;
+    uint8_t Value;
+
+    if (s_Head == s_Tail)
+    {
+      EECR &= ~_BV( EERIE );
+      return;
+    }
+
+    lpRequest = &s_Queue[ s_Head & (EEPROM_QUEUE_LENGTH - 1) ];
+    if (s_Position >= lpRequest->Length)
+    {
+      s_Position = 0;
+      s_Head++;
+      continue;
+    }
+
+    // Moving up goes backwards, so that no byte is overwritten before it is moved.
+    Index = s_Position++;
+    if ((lpRequest->Type == EEPROM_REQUEST_MOVE) && (lpRequest->Offset > lpRequest->Source))
+      Index = lpRequest->Length - 1 - Index;
+
+    switch (lpRequest->Type)
+    {
+      case EEPROM_REQUEST_WRITE:
+        Value = ((const uint8_t*)lpRequest->Source)[ Index ];
+        break;
+
+      case EEPROM_REQUEST_WRITE_P:
+        Value = pgm_read_byte( (const uint8_t*)lpRequest->Source + Index );
+        break;
+
+      case EEPROM_REQUEST_FILL:
+        Value = lpRequest->Source;
+        break;
+
+      default:
+        Value = readReady( lpRequest->Source + Index );
+        break;
+    }
+
+    if (readReady( lpRequest->Offset + Index ) == Value)
+      continue;
+
+    // Erase and write, the next interrupt comes once the cell is written.
+    EEAR = lpRequest->Offset + Index;
+    EEDR = Value;
+    EECR |= _BV( EEMPE );
+    EECR |= _BV( EEPE );
+    return;
+  }
+}
+
+
+void VLOvenEEPROM::doCycle()
+{
+  // Callbacks may queue new requests, the entry is freed only after its callback returns.
+  while (s_Done != s_Head)
+  {
+    const VLOvenEEPROMRequest_t* lpRequest = &s_Queue[ s_Done & (EEPROM_QUEUE_LENGTH - 1) ];
+
+    if (lpRequest->lpCallback != NULL)
+      lpRequest->lpCallback( lpRequest->lpContext );
+    s_Done++;
+  }
+}
+
+
+void VLOvenEEPROM::flush()
+{
+  while (!isIdle())
+  {
+    doCycle();
+  }
+}
+
+
+void VLOvenEEPROM::read( int Offset, void* lpData, int Length )
+{
+  uint8_t Enabled = EECR & _BV( EERIE );
+
+  // The interrupt uses the address register too, hold it off while reading.
+  EECR &= ~_BV( EERIE );
+  eeprom_busy_wait();
+  eeprom_read_block( lpData, (const void*)Offset, Length );
+  EECR |= Enabled;
+}
@@ -0,0 +1,182 @@
+/*! \file
+ *  \brief Interrupt driven EEPROM writer.
+ *  This file declares the class queueing EEPROM writes, and performing them from the EEPROM ready interrupt.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenEEPROM_h_
+#define  _VLOvenEEPROM_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define EEPROM_QUEUE_LENGTH       (8)       /*!< \brief Number of queued write requests, must be a power of two. */
+#define EEPROM_ISR_STEPS          (8)       /*!< \brief Most bytes compared by one interrupt before giving the main program a turn. */
+
+#define EEPROM_REQUEST_WRITE      0         /*!< \brief Write request copying from RAM. */
+#define EEPROM_REQUEST_WRITE_P    1         /*!< \brief Write request copying from flash. */
+#define EEPROM_REQUEST_FILL       2         /*!< \brief Write request setting every byte to the same value. */
+#define EEPROM_REQUEST_MOVE       3         /*!< \brief Write request copying from another EEPROM location, overlap allowed. */
+
+
+/*!
+ * \brief Write request completion callback.
+ * \param lpContext Context pointer given with the request.
+*/
+typedef void (*VLOvenEEPROMCallback_t)( void* lpContext );
+
+
+/*!
+ * \brief Queued write request.
+*/
+typedef struct
+{
+  uint16_t Offset;                        /*!< \brief EEPROM location written. */
+  uint16_t Length;                        /*!< \brief Number of bytes written. */
+  uintptr_t Source;                       /*!< \brief RAM or flash address, fill value, or EEPROM location of the data. */
+  uint8_t Type;                           /*!< \brief Request type, one of the \c EEPROM_REQUEST_xxx values. */
+  VLOvenEEPROMCallback_t lpCallback;      /*!< \brief Function called once the request is completed, if any. */
+  void* lpContext;                        /*!< \brief Context pointer given to the callback. */
+} VLOvenEEPROMRequest_t;
+
+
+/*!
+ * \brief Interrupt driven EEPROM writer.
+ * Write requests are queued and performed one byte at a time from the EEPROM ready interrupt, so the main program
+ * never waits for the 3.4 ms of a cell write. Bytes already holding their value are not written again.
+ * Requests are performed in order, a request only starts once the previous one is completed, so a later request
+ * can rely on the earlier ones being in place. The data of a request must stay unchanged until it is completed.
+ * Completion callbacks are called from #doCycle(), not from the interrupt.
+*/
+class VLOvenEEPROM
+{
+  public:
+    /*!
+     * \brief Queue a write from RAM.
+     * \param Offset EEPROM location to write.
+     * \param lpData Data to write, which must stay unchanged until the request is completed.
+     * \param Length Number of bytes to write.
+     * \param lpCallback Function to call once the request is completed, if any.
+     * \param lpContext Context pointer for the callback.
+     * \return Returns \c true when the request is queued, \c false when the queue is full.
+    */
+    static bool write( int Offset, const void* lpData, int Length, VLOvenEEPROMCallback_t lpCallback = NULL, void* lpContext = NULL )
+      { return push( EEPROM_REQUEST_WRITE, Offset, (uintptr_t)lpData, Length, lpCallback, lpContext ); }
+
+    /*!
+     * \brief Queue a write from flash.
+     * \param Offset EEPROM location to write.
+     * \param lpData Data to write, in program memory.
+     * \param Length Number of bytes to write.
+     * \param lpCallback Function to call once the request is completed, if any.
+     * \param lpContext Context pointer for the callback.
+     * \return Returns \c true when the request is queued, \c false when the queue is full.
+    */
+    static bool write_P( int Offset, const void* lpData, int Length, VLOvenEEPROMCallback_t lpCallback = NULL, void* lpContext = NULL )
+      { return push( EEPROM_REQUEST_WRITE_P, Offset, (uintptr_t)lpData, Length, lpCallback, lpContext ); }
+
+    /*!
+     * \brief Queue a fill.
+     * \param Offset EEPROM location to write.
+     * \param Value Value written to every byte.
+     * \param Length Number of bytes to write.
+     * \param lpCallback Function to call once the request is completed, if any.
+     * \param lpContext Context pointer for the callback.
+     * \return Returns \c true when the request is queued, \c false when the queue is full.
+    */
+    static bool fill( int Offset, uint8_t Value, int Length, VLOvenEEPROMCallback_t lpCallback = NULL, void* lpContext = NULL )
+      { return push( EEPROM_REQUEST_FILL, Offset, Value, Length, lpCallback, lpContext ); }
+
+    /*!
+     * \brief Queue a move of EEPROM data.
+     * \param Offset EEPROM location to write.
+     * \param Source EEPROM location of the data, the two areas may overlap.
+     * \param Length Number of bytes to move.
+     * \param lpCallback Function to call once the request is completed, if any.
+     * \param lpContext Context pointer for the callback.
+     * \return Returns \c true when the request is queued, \c false when the queue is full.
+    */
+    static bool move( int Offset, int Source, int Length, VLOvenEEPROMCallback_t lpCallback = NULL, void* lpContext = NULL )
+      { return push( EEPROM_REQUEST_MOVE, Offset, Source, Length, lpCallback, lpContext ); }
+
+    /*!
+     * \brief Get the room left in the queue.
+     * \return Returns the number of requests that can be queued, a request counts until its callback is called.
+    */
+    static uint8_t getFree() { return EEPROM_QUEUE_LENGTH - (uint8_t)(s_Tail - s_Done); }
+
+    /*!
+     * \brief Check whether every request is completed and its callback called.
+    */
+    static bool isIdle() { return s_Done == s_Tail; }
+
+    /*!
+     * \brief Call the callbacks of the completed requests, and free their queue entries.
+     * \remarks This function must be called from the main loop.
+    */
+    static void doCycle();
+
+    /*!
+     * \brief Wait for every request to be completed, calling the callbacks along the way.
+    */
+    static void flush();
+
+    /*!
+     * \brief Read EEPROM data.
+     * Data written by requests not completed yet may not be there.
+     * \param Offset EEPROM location to read.
+     * \param lpData Buffer receiving the data.
+     * \param Length Number of bytes to read.
+    */
+    static void read( int Offset, void* lpData, int Length );
+
+    /*!
+     * \brief Read an EEPROM object.
+     * \param Offset EEPROM location to read.
+     * \param Value Variable receiving the object.
+     * \return Returns \p Value.
+    */
+    template <class T> static T& get( int Offset, T& Value ) { read( Offset, &Value, sizeof(T) ); return Value; }
+
+    /*!
+     * \brief Read one EEPROM byte.
+     * \param Offset EEPROM location to read.
+     * \return Returns the byte value.
+    */
+    static uint8_t read( int Offset ) { uint8_t Value; read( Offset, &Value, 1 ); return Value; }
+
+    /*!
+     * \brief EEPROM ready handling, starting the next byte write.
+     * \remarks This function must be called from the EEPROM ready interrupt.
+    */
+    static void onReady();
+
+  private:
+    static VLOvenEEPROMRequest_t s_Queue[ EEPROM_QUEUE_LENGTH ];   /*!< \brief Request ring buffer. */
+    static volatile uint8_t s_Done;       /*!< \brief Count of requests whose callback was called. */
+    static volatile uint8_t s_Head;       /*!< \brief Count of completed requests. */
+    static volatile uint8_t s_Tail;       /*!< \brief Count of queued requests. */
+    static uint16_t s_Position;           /*!< \brief Number of bytes of the current request handled so far. */
+
+    /*!
+     * \brief Queue a request, and start the interrupt.
+     * \return Returns \c true when the request is queued, \c false when the queue is full.
+    */
+    static bool push( uint8_t Type, int Offset, uintptr_t Source, int Length, VLOvenEEPROMCallback_t lpCallback, void* lpContext );
+};
+
+
+#endif  /* _VLOvenEEPROM_h_ */
@@ -0,0 +1,155 @@
+/*! \file
+ *  \brief Heater energy accounting.
+ *  This file implements the class methods for the heater energy accounting.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stddef.h>
+#include "VLOvenEEPROM.h"
+#include "VLOvenEnergy.h"
+
+
+VLOvenEnergy::VLOvenEnergy() :
+  m_PendingOnTime( 0 ), m_PendingSaturated( 0 ), m_PendingRuns( 0 ), m_Remainder( 0 ),
+  m_Offset( -1 ), m_Slot( 0 ), m_Writing( false )
+{
+  memset( &m_Lifetime, 0, sizeof(m_Lifetime) );
+  startRun();
+}
+
+
+uint8_t VLOvenEnergy::getCheck( const VLOvenEnergyCounters_t& Counters )
+{
+  const uint8_t* lpData = (const uint8_t*)&Counters;
+  uint8_t Check = 0xA5;
+
+  for (uint8_t Index = 0; Index < offsetof( VLOvenEnergyCounters_t, Check ); Index++)
+  {
+    Check = (Check << 1 | Check >> 7) ^ lpData[ Index ];
+  }
+  return Check;
+}
+
+
+void VLOvenEnergy::begin( int Offset )
+{
+  VLOvenEnergyCounters_t Counters;
+  bool Found = false;
+
+  m_Offset = Offset;
+  memset( &m_Lifetime, 0, sizeof(m_Lifetime) );
+  m_Slot = ENERGY_COUNTER_SLOTS - 1;
+
+  // Newest valid record wins, sequence numbers compare modulo 2^16.
+  for (uint8_t Slot = 0; Slot < ENERGY_COUNTER_SLOTS; Slot++)
+  {
+    VLOvenEEPROM::get( m_Offset + Slot * sizeof(Counters), Counters );
+    if (Counters.Check != getCheck( Counters ))
+      continue;
+    if (!Found || ((int16_t)(Counters.Sequence - m_Lifetime.Sequence) > 0))
+    {
+      m_Lifetime = Counters;
+      m_Slot = Slot;
+      Found = true;
+    }
+  }
+}
+
+
+void VLOvenEnergy::startRun()
+{
+  memset( &m_Run, 0, sizeof(m_Run) );
+  startPhase();
+}
+
+
+void VLOvenEnergy::startPhase()
+{
+  memset( &m_Phase, 0, sizeof(m_Phase) );
+}
+
+
+void VLOvenEnergy::addSample( VLOvenEnergyStats_t& Stats, uint16_t Duty, uint32_t OnTime, bool Saturated, unsigned long Elapsed )
+{
+  Stats.OnTime += OnTime;
+  if (Saturated)
+    Stats.SaturatedTime += Elapsed;
+  if (Duty > Stats.PeakDuty)
+    Stats.PeakDuty = Duty;
+}
+
+
+void VLOvenEnergy::addSample( uint16_t Duty, bool Saturated, unsigned long Elapsed )
+{
+  uint32_t Product = (uint32_t)Duty * Elapsed + m_Remainder;
+  uint32_t OnTime = Product / 1000;
+
+  m_Remainder = Product % 1000;
+  addSample( m_Phase, Duty, OnTime, Saturated, Elapsed );
+  addSample( m_Run, Duty, OnTime, Saturated, Elapsed );
+
+  m_PendingOnTime += OnTime;
+  if (Saturated)
+    m_PendingSaturated += Elapsed;
+  if (m_PendingOnTime >= ENERGY_FLUSH_ONTIME)
+    flush();
+}
+
+
+void VLOvenEnergy::endRun()
+{
+  m_PendingRuns++;
+  flush();
+}
+
+
+void VLOvenEnergy::getLifetime( VLOvenEnergyCounters_t& Counters ) const
+{
+  Counters = m_Lifetime;
+  Counters.Runs += m_PendingRuns;
+  Counters.OnTime += m_PendingOnTime / 1000;
+  Counters.SaturatedTime += m_PendingSaturated / 1000;
+}
+
+
+void VLOvenEnergy::onWritten( void* lpContext )
+{
+  VLOvenEnergy* lpEnergy = (VLOvenEnergy*)lpContext;
+
+  // A run ending during the write is not left waiting for the next run.
+  lpEnergy->m_Writing = false;
+  if (lpEnergy->m_PendingRuns != 0)
+    lpEnergy->flush();
+}
+
+
+void VLOvenEnergy::flush()
+{
+  if ((m_Offset < 0) || m_Writing || (VLOvenEEPROM::getFree() == 0) || ((m_PendingRuns == 0) && (m_PendingOnTime < 1000) && (m_PendingSaturated < 1000)))
+    return;
+
+  // Whole seconds go out, the rest waits for the next write.
+  getLifetime( m_Lifetime );
+  m_PendingRuns = 0;
+  m_PendingOnTime %= 1000;
+  m_PendingSaturated %= 1000;
+
+  m_Lifetime.Sequence++;
+  m_Lifetime.Check = getCheck( m_Lifetime );
+  if (++m_Slot >= ENERGY_COUNTER_SLOTS)
+    m_Slot = 0;
+  m_Writing = true;
+  VLOvenEEPROM::write( m_Offset + m_Slot * sizeof(m_Lifetime), &m_Lifetime, sizeof(m_Lifetime), onWritten, this );
+}
@@ -0,0 +1,164 @@
+/*! \file
+ *  \brief Heater energy accounting.
+ *  This file declares the class accounting heater on-time and energy per phase, per run and over the oven lifetime.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenEnergy_h_
+#define  _VLOvenEnergy_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define HEATER_WATTAGE            (1500)        /*!< \brief Power of one heater element in W, used for estimating the energy. */
+#define ENERGY_COUNTER_SLOTS      (4)           /*!< \brief Number of EEPROM slots the lifetime counters rotate over. */
+#define ENERGY_FLUSH_ONTIME       (1800000UL)   /*!< \brief Heater on-time in <b>ms</b> after which a long run flushes the lifetime counters. */
+
+
+/*!
+ * \brief Heater usage statistics.
+ * On-times are heater element full power equivalents, summed over the heater channels: one element at
+ * 50% for two seconds counts as one second.
+*/
+typedef struct {
+  uint32_t OnTime;          /*!< \brief Heater on-time in <b>ms</b>. */
+  uint32_t SaturatedTime;   /*!< \brief Time in <b>ms</b> with a heater channel at full power. */
+  uint16_t PeakDuty;        /*!< \brief Highest heater duty summed over the heater channels, in 1/10 percent. */
+} VLOvenEnergyStats_t;
+
+
+/*!
+ * \brief Lifetime counters record, as stored in EEPROM.
+*/
+typedef struct {
+  uint16_t Sequence;        /*!< \brief Write sequence number, the slot holding the highest one is the current record. */
+  uint32_t Runs;            /*!< \brief Number of completed runs. */
+  uint32_t OnTime;          /*!< \brief Heater on-time in seconds. */
+  uint32_t SaturatedTime;   /*!< \brief Time in seconds with a heater channel at full power. */
+  uint8_t Check;            /*!< \brief Check byte over the previous fields, detects records torn by a reset while writing. */
+} VLOvenEnergyCounters_t;
+
+
+/*!
+ * \brief Heater energy accounting.
+ * Integrates the applied heater duty into integer accumulators, for the current phase, the current run and
+ * the oven lifetime, at a constant cost per sample. Lifetime counters are kept in EEPROM, written at the end
+ * of every run and every #ENERGY_FLUSH_ONTIME of heating during long runs, rotating over
+ * #ENERGY_COUNTER_SLOTS slots so every cell takes only a share of the writes.
+*/
+class VLOvenEnergy
+{
+  public:
+    /*!
+     * \brief Constructor.
+    */
+    VLOvenEnergy();
+
+    /*!
+     * \brief Load the lifetime counters.
+     * \param Offset EEPROM location of the counter slots, #getStorageSize() bytes long.
+    */
+    void begin( int Offset );
+
+    /*!
+     * \brief Get the EEPROM space taken by the lifetime counters.
+     * \return Returns the size in bytes of all the counter slots.
+    */
+    static int getStorageSize() { return ENERGY_COUNTER_SLOTS * sizeof(VLOvenEnergyCounters_t); }
+
+    /*!
+     * \brief Restart the run and phase statistics.
+    */
+    void startRun();
+
+    /*!
+     * \brief Restart the phase statistics.
+    */
+    void startPhase();
+
+    /*!
+     * \brief Account for the heater duty applied over an interval.
+     * \param Duty Heater duty summed over the heater channels, in 1/10 percent.
+     * \param Saturated Whether a heater channel was at full power.
+     * \param Elapsed Interval length in <b>ms</b>.
+    */
+    void addSample( uint16_t Duty, bool Saturated, unsigned long Elapsed );
+
+    /*!
+     * \brief Add the completed run to the lifetime counters and write them.
+    */
+    void endRun();
+
+    /*!
+     * \brief Queue the write of the lifetime counters when anything changed since the last write.
+     * Nothing is written while the previous write is in progress or the EEPROM write queue is full, the
+     * changes wait for the next call.
+    */
+    void flush();
+
+    /*!
+     * \brief Get the current phase statistics.
+    */
+    const VLOvenEnergyStats_t& getPhaseStats() const { return m_Phase; }
+
+    /*!
+     * \brief Get the current, or last, run statistics.
+    */
+    const VLOvenEnergyStats_t& getRunStats() const { return m_Run; }
+
+    /*!
+     * \brief Get the lifetime counters, including what is not written yet.
+     * \param Counters Variable receiving the counters.
+    */
+    void getLifetime( VLOvenEnergyCounters_t& Counters ) const;
+
+    /*!
+     * \brief Convert a heater on-time into energy.
+     * \param OnTime Heater on-time in <b>ms</b>.
+     * \return Returns the estimated energy in Wh.
+    */
+    static double toWattHours( uint32_t OnTime ) { return (double)OnTime * HEATER_WATTAGE / 3600000.0; }
+
+  private:
+    VLOvenEnergyStats_t m_Phase;              /*!< \brief Current phase statistics. */
+    VLOvenEnergyStats_t m_Run;                /*!< \brief Current run statistics. */
+    VLOvenEnergyCounters_t m_Lifetime;        /*!< \brief Lifetime counters as last written. */
+    uint32_t m_PendingOnTime;                 /*!< \brief Heater on-time in ms not written yet. */
+    uint32_t m_PendingSaturated;              /*!< \brief Saturated time in ms not written yet. */
+    uint16_t m_PendingRuns;                   /*!< \brief Completed runs not written yet. */
+    uint16_t m_Remainder;                     /*!< \brief Duty times ms below one ms of on-time, carried to the next sample. */
+    int m_Offset;                             /*!< \brief EEPROM location of the counter slots, \c -1 before #begin(). */
+    uint8_t m_Slot;                           /*!< \brief Slot holding the current record. */
+    bool m_Writing;                           /*!< \brief The current record is still being written from #m_Lifetime. */
+
+    /*!
+     * \brief Compute the check byte of a counters record.
+    */
+    static uint8_t getCheck( const VLOvenEnergyCounters_t& Counters );
+
+    /*!
+     * \brief EEPROM write completion callback.
+    */
+    static void onWritten( void* lpContext );
+
+    /*!
+     * \brief Update one statistics set with a sample.
+    */
+    static void addSample( VLOvenEnergyStats_t& Stats, uint16_t Duty, uint32_t OnTime, bool Saturated, unsigned long Elapsed );
+};
+
+
+#endif  /* _VLOvenEnergy_h_ */
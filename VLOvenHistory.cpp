@@ -0,0 +1,118 @@
+/*! \file
+ *  \brief Run history store.
+ *  This file implements the class methods for the run history store.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stddef.h>
+#include <util/crc16.h>
+#include "VLOvenEEPROM.h"
+#include "VLOvenHistory.h"
+
+
+VLOvenHistory::VLOvenHistory() :
+  m_Offset( -1 ), m_Slot( HISTORY_RUNS - 1 ), m_Sequence( 0 ), m_Writing( false )
+{}
+
+
+uint16_t VLOvenHistory::getCrc( const VLOvenRunRecord_t& Record )
+{
+  const uint8_t* lpData = (const uint8_t*)&Record;
+  uint16_t Crc = 0xFFFF;
+
+  for (uint8_t Index = 0; Index < offsetof( VLOvenRunRecord_t, Crc ); Index++)
+  {
+    Crc = _crc_ccitt_update( Crc, lpData[ Index ] );
+  }
+  return Crc;
+}
+
+
+bool VLOvenHistory::read( uint8_t Slot, VLOvenRunRecord_t& Record )
+{
+  VLOvenEEPROM::get( m_Offset + Slot * sizeof(Record), Record );
+  return (Record.Crc == getCrc( Record ));
+}
+
+
+void VLOvenHistory::begin( int Offset )
+{
+  VLOvenRunRecord_t Record;
+  bool Found = false;
+
+  m_Offset = Offset;
+  m_Slot = HISTORY_RUNS - 1;
+  m_Sequence = 0;
+
+  // Newest valid record wins, sequence numbers compare modulo 2^16.
+  for (uint8_t Slot = 0; Slot < HISTORY_RUNS; Slot++)
+  {
+    if (!read( Slot, Record ))
+      continue;
+    if (!Found || ((int16_t)(Record.Sequence - m_Sequence) > 0))
+    {
+      m_Slot = Slot;
+      m_Sequence = Record.Sequence;
+      Found = true;
+    }
+  }
+}
+
+
+void VLOvenHistory::onWritten( void* lpContext )
+{
+  ((VLOvenHistory*)lpContext)->m_Writing = false;
+}
+
+
+bool VLOvenHistory::isReady() const
+{
+  return !m_Writing && (VLOvenEEPROM::getFree() > 0);
+}
+
+
+bool VLOvenHistory::append( const VLOvenRunRecord_t& Record )
+{
+  if (m_Offset < 0)
+    return true;
+  if (!isReady())
+    return false;
+
+  if (++m_Slot >= HISTORY_RUNS)
+    m_Slot = 0;
+  m_Record = Record;
+  m_Record.Sequence = ++m_Sequence;
+  m_Record.Crc = getCrc( m_Record );
+  m_Writing = true;
+  VLOvenEEPROM::write( m_Offset + m_Slot * sizeof(m_Record), &m_Record, sizeof(m_Record), onWritten, this );
+  return true;
+}
+
+
+bool VLOvenHistory::get( uint8_t Index, VLOvenRunRecord_t& Record )
+{
+  if ((m_Offset < 0) || (Index >= HISTORY_RUNS))
+    return false;
+
+  // The EEPROM holds only part of a record being written.
+  if ((Index == 0) && m_Writing)
+  {
+    Record = m_Record;
+    return true;
+  }
+
+  // A slot left over from before a gap in the sequence does not belong to the history.
+  return read( (m_Slot + HISTORY_RUNS - Index) % HISTORY_RUNS, Record ) && (Record.Sequence == (uint16_t)(m_Sequence - Index));
+}
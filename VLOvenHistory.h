@@ -0,0 +1,124 @@
+/*! \file
+ *  \brief Run history store.
+ *  This file declares the class keeping the records of the last runs in EEPROM.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenHistory_h_
+#define  _VLOvenHistory_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define HISTORY_RUNS              (6)           /*!< \brief Number of runs the history keeps. */
+#define HISTORY_PHASES            (10)          /*!< \brief Number of phases whose durations a run record keeps. */
+
+#define HISTORY_RESULT_COMPLETED  0x01          /*!< \brief Run record result flag: the run went through all its phases. */
+#define HISTORY_RESULT_QA_FAILED  0x02          /*!< \brief Run record result flag: the run is out of its profile quality limits. */
+
+
+/*!
+ * \brief Run record, as stored in EEPROM.
+ * Temperatures are in 1/100 degrees C and times in seconds.
+*/
+typedef struct {
+  uint16_t Sequence;                        /*!< \brief Record sequence number, increased on every run. */
+  uint8_t Profile;                          /*!< \brief Index of the profile run. */
+  uint8_t PhasesCount;                      /*!< \brief Number of phases in the profile. */
+  uint8_t Result;                           /*!< \brief \c HISTORY_RESULT_xxx flags. */
+  uint8_t Faults;                           /*!< \brief Safety supervisor \c SAFETY_FAULT_xxx flags latched at the run end. */
+  uint32_t StartTime;                       /*!< \brief Run start, time from power up. */
+  uint16_t PhaseTime[ HISTORY_PHASES ];     /*!< \brief Time spent in each phase, loops included. */
+  int16_t Peak;                             /*!< \brief Peak temperature. */
+  uint16_t TimeAboveLiquidus;               /*!< \brief Time above the liquidus temperature. */
+  int16_t Overshoot;                        /*!< \brief Peak temperature excess over the highest profile temperature. */
+  uint16_t Crc;                             /*!< \brief CRC-16 over the previous fields. */
+} VLOvenRunRecord_t;
+
+
+/*!
+ * \brief Run history store.
+ * Circular buffer of run records in EEPROM. Each run costs one record write, into the slot of the oldest
+ * record, so the writes are evenly spread over the slots. Records carry a CRC, a record torn by a reset
+ * while writing is just skipped. Records are written through the EEPROM write queue, one at a time.
+*/
+class VLOvenHistory
+{
+  public:
+    /*!
+     * \brief Constructor.
+    */
+    VLOvenHistory();
+
+    /*!
+     * \brief Locate the newest record.
+     * \param Offset EEPROM location of the record slots, #getStorageSize() bytes long.
+    */
+    void begin( int Offset );
+
+    /*!
+     * \brief Get the EEPROM space taken by the history.
+     * \return Returns the size in bytes of all the record slots.
+    */
+    static int getStorageSize() { return HISTORY_RUNS * sizeof(VLOvenRunRecord_t); }
+
+    /*!
+     * \brief Check whether a new record can be stored.
+     * \return Returns \c false while the previous record is being written, or the EEPROM write queue is full.
+    */
+    bool isReady() const;
+
+    /*!
+     * \brief Store a new record, replacing the oldest one.
+     * \param Record Record to store, its sequence number and CRC are set on the copy written.
+     * \return Returns \c true when the record is queued for writing, \c false when not #isReady().
+    */
+    bool append( const VLOvenRunRecord_t& Record );
+
+    /*!
+     * \brief Read a record back.
+     * \param Index Record index, \c 0 for the newest one.
+     * \param Record Variable receiving the record.
+     * \return Returns \c true when the record is valid.
+    */
+    bool get( uint8_t Index, VLOvenRunRecord_t& Record );
+
+  private:
+    int m_Offset;                             /*!< \brief EEPROM location of the record slots, \c -1 before #begin(). */
+    uint8_t m_Slot;                           /*!< \brief Slot holding the newest record. */
+    uint16_t m_Sequence;                      /*!< \brief Sequence number of the newest record. */
+    VLOvenRunRecord_t m_Record;               /*!< \brief Newest record, the copy being written. */
+    bool m_Writing;                           /*!< \brief The newest record is still being written. */
+
+    /*!
+     * \brief Compute the CRC of a record.
+    */
+    static uint16_t getCrc( const VLOvenRunRecord_t& Record );
+
+    /*!
+     * \brief EEPROM write completion callback.
+    */
+    static void onWritten( void* lpContext );
+
+    /*!
+     * \brief Read the record in a slot.
+     * \return Returns \c true when the record CRC matches.
+    */
+    bool read( uint8_t Slot, VLOvenRunRecord_t& Record );
+};
+
+
+#endif  /* _VLOvenHistory_h_ */
@@ -0,0 +1,185 @@
+/*! \file
+ *  \brief SPI thermocouple converter driver.
+ *  This file implements the class methods for the SPI thermocouple converter driver.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "VLOvenMAX31855.h"
+#include "VLOvenThermocouple.h"
+
+
+VLOvenMAX31855* volatile VLOvenMAX31855::s_lpBusOwner = NULL;
+
+
+ISR(SPI_STC_vect)
+{
+  VLOvenMAX31855::onTransferComplete();
+}
+
+
+VLOvenMAX31855::VLOvenMAX31855( uint8_t CSPin, uint8_t Device ) :
+  m_CSPin( CSPin ), m_Device( Device ),
+  m_Count( 0 ), m_Ready( false ), m_ReadTime( 0 ),
+  m_MockTemp( TC_MOCK_AMBIENT ), m_MockFault( TC_FAULT_NONE ), m_MockTime( 0 )
+{}
+
+
+void VLOvenMAX31855::begin()
+{
+  m_ReadTime = millis();
+  m_MockTime = m_ReadTime;
+
+  if (m_Device == TC_DEVICE_MOCK)
+    return;
+
+  digitalWrite( m_CSPin, HIGH );
+  pinMode( m_CSPin, OUTPUT );
+
+  // SPI master, mode 0, fosc/16, transfer complete interrupt. SS must be an output to stay master.
+  pinMode( SS, OUTPUT );
+  pinMode( SCK, OUTPUT );
+  pinMode( MOSI, OUTPUT );
+  pinMode( MISO, INPUT );
+  SPCR = _BV( SPIE ) | _BV( SPE ) | _BV( MSTR ) | _BV( SPR0 );
+}
+
+
+bool VLOvenMAX31855::startRead()
+{
+  unsigned long Now = millis();
+
+  // Lowering CS stops a MAX6675 conversion, and a MAX31855 would return the previous result anyway.
+  if (m_Ready || Now - m_ReadTime < ((m_Device == TC_DEVICE_MAX6675) ? MAX6675_CONVERSION_TIME : MAX31855_CONVERSION_TIME))
+    return false;
+
+  if (m_Device == TC_DEVICE_MOCK)
+  {
+    m_ReadTime = Now;
+    encodeMockFrame();
+    m_Ready = true;
+    return true;
+  }
+
+  if (s_lpBusOwner != NULL)
+    return false;
+
+  m_ReadTime = Now;
+  m_Count = 0;
+  s_lpBusOwner = this;
+  digitalWrite( m_CSPin, LOW );
+  SPDR = 0;
+  return true;
+}
+
+
+void VLOvenMAX31855::onTransferComplete()
+{
+  VLOvenMAX31855* lpOwner = s_lpBusOwner;
+
+  if (lpOwner == NULL)
+    return;
+
+  lpOwner->m_Frame[ lpOwner->m_Count++ ] = SPDR;
+  if (lpOwner->m_Count < lpOwner->frameLength())
+  {
+    SPDR = 0;
+    return;
+  }
+
+  digitalWrite( lpOwner->m_CSPin, HIGH );
+  lpOwner->m_Ready = true;
+  s_lpBusOwner = NULL;
+}
+
+
+int8_t VLOvenMAX31855::getReading( float* lpTemp, float* lpColdJunction )
+{
+  uint8_t Fault = TC_FAULT_NONE;
+
+  if (!m_Ready)
+    return -1;
+
+  if (m_Device == TC_DEVICE_MAX6675)
+  {
+    uint16_t Frame = ((uint16_t)m_Frame[ 0 ] << 8) | m_Frame[ 1 ];
+
+    // D15 is a dummy zero bit, all ones means MISO is floating.
+    if (Frame & 0x8000)
+      Fault = TC_FAULT_NO_DEVICE;
+    else if (Frame & 0x0004)
+      Fault = TC_FAULT_OPEN;
+
+    *lpTemp = (Fault == TC_FAULT_NONE) ? (float)(Frame >> 3) * 0.25 : NAN;
+    if (lpColdJunction != NULL)
+      *lpColdJunction = NAN;
+  }
+  else
+  {
+    uint32_t Frame = ((uint32_t)m_Frame[ 0 ] << 24) | ((uint32_t)m_Frame[ 1 ] << 16) | ((uint16_t)m_Frame[ 2 ] << 8) | m_Frame[ 3 ];
+    int32_t Reading;
+    int32_t Junction;
+
+    // D17 and D3 are reserved zero bits, set only when MISO is floating.
+    if (Frame & 0x00020008UL)
+      Fault = TC_FAULT_NO_DEVICE;
+    else if (Frame & 0x00010000UL)
+      Fault = Frame & (TC_FAULT_OPEN | TC_FAULT_SHORT_GND | TC_FAULT_SHORT_VCC);
+
+    // Signed 14-bit reading in 0.25 degrees C steps in D31..D18, signed 12-bit reading in 0.0625 degrees C in D15..D4.
+    Reading = (int32_t)((int16_t)(Frame >> 16) >> 2) * 25;
+    Junction = (int32_t)((int16_t)Frame >> 4) * 25 / 4;
+
+    // The converter assumes a linear thermocouple, undo it and linearise from the cold junction voltage.
+    *lpTemp = (Fault == TC_FAULT_NONE) ?
+      (float)typeKTemperature( (Reading - Junction) * TYPEK_SEEBECK_NUM / TYPEK_SEEBECK_DEN + typeKVoltage( Junction ) ) / 100.0 : NAN;
+    if (lpColdJunction != NULL)
+      *lpColdJunction = (Fault != TC_FAULT_NO_DEVICE) ? (float)Junction / 100.0 : NAN;
+  }
+
+  m_Ready = false;
+  return Fault;
+}
+
+
+void VLOvenMAX31855::updateMock( double HeaterPower, double CoolerPower )
+{
+  unsigned long Now = millis();
+  float Elapsed = (float)(Now - m_MockTime) / 1000.0;
+
+  m_MockTime = Now;
+  m_MockTemp += Elapsed * (HeaterPower * TC_MOCK_HEATING_RATE / 100.0 - (m_MockTemp - TC_MOCK_AMBIENT) * TC_MOCK_LOSS_RATE *
+    (1.0 + CoolerPower * TC_MOCK_COOLING_GAIN / 100.0));
+}
+
+
+void VLOvenMAX31855::encodeMockFrame()
+{
+  int32_t Junction = lround( TC_MOCK_AMBIENT * 100.0 );
+  int32_t Reading;
+  uint32_t Frame;
+
+  // What a real converter would report for the model temperature, including its linear thermocouple
+  // approximation, so that the decoding and linearisation are exercised too.
+  Reading = Junction + (typeKVoltage( lround( m_MockTemp * 100.0 ) ) - typeKVoltage( Junction )) * TYPEK_SEEBECK_DEN / TYPEK_SEEBECK_NUM;
+  Frame = (uint32_t)((uint16_t)(int16_t)((Reading + ((Reading < 0) ? -12 : 12)) / 25) << 2) << 16;
+  Frame |= (uint16_t)((int16_t)(Junction * 4 / 25) << 4);
+  if (m_MockFault != TC_FAULT_NONE)
+    Frame |= 0x00010000UL | (m_MockFault & (TC_FAULT_OPEN | TC_FAULT_SHORT_GND | TC_FAULT_SHORT_VCC | TC_FAULT_NO_DEVICE));
+
+  m_Frame[ 0 ] = Frame >> 24;
+  m_Frame[ 1 ] = Frame >> 16;
+  m_Frame[ 2 ] = Frame >> 8;
+  m_Frame[ 3 ] = Frame;
+}
@@ -0,0 +1,141 @@
+/*! \file
+ *  \brief SPI thermocouple converter driver.
+ *  This file declares the class implementing non-blocking access to MAX31855 and MAX6675 thermocouple converters.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenMAX31855_h_
+#define  _VLOvenMAX31855_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define TC_DEVICE_MAX31855        0         /*!< \brief MAX31855 converter, 32-bit frames, 14-bit readings with cold junction temperature. */
+#define TC_DEVICE_MAX6675         1         /*!< \brief MAX6675 converter, 16-bit frames, 12-bit readings. */
+#define TC_DEVICE_MOCK            2         /*!< \brief Simulated MAX31855 converter measuring a simple oven thermal model, no hardware access. */
+
+#define MAX31855_CONVERSION_TIME  (100)     /*!< \brief MAX31855 conversion time in <b>ms</b>. */
+#define MAX6675_CONVERSION_TIME   (220)     /*!< \brief MAX6675 conversion time in <b>ms</b>, reading earlier aborts the conversion. */
+
+#define TC_FAULT_NONE             0x00      /*!< \brief No fault detected. */
+#define TC_FAULT_OPEN             0x01      /*!< \brief Open thermocouple, or reading over range. */
+#define TC_FAULT_SHORT_GND        0x02      /*!< \brief Thermocouple shorted to GND, or reading under range. */
+#define TC_FAULT_SHORT_VCC        0x04      /*!< \brief Thermocouple shorted to VCC. */
+#define TC_FAULT_NO_DEVICE        0x08      /*!< \brief The converter is not responding. */
+
+#define TC_MOCK_AMBIENT           (25.0)    /*!< \brief Mock device oven model ambient temperature in degrees C. */
+#define TC_MOCK_HEATING_RATE      (2.5)     /*!< \brief Mock device oven model heating rate at full power in degrees C/second. */
+#define TC_MOCK_LOSS_RATE         (0.004)   /*!< \brief Mock device oven model heat loss rate, fraction of the excess temperature lost per second. */
+#define TC_MOCK_COOLING_GAIN      (4.0)     /*!< \brief Mock device oven model heat loss increase with the cooling actuator at full power. */
+
+
+/*!
+ * \brief SPI thermocouple converter driver.
+ * Readings are taken with interrupt driven SPI transfers started once per converter conversion time, so the
+ * main loop never waits for either the conversion or the transfer. Several instances can share the bus,
+ * only one transfer is in progress at any time.
+*/
+class VLOvenMAX31855
+{
+  public:
+    /*!
+     * \brief Constructor.
+     * \param CSPin Output pin connected to the converter chip select input.
+     * \param Device Converter type, one of the \c TC_DEVICE_xxx values.
+     * \remarks The default arguments only serve instance arrays, whose items are then assigned a configured instance.
+    */
+    VLOvenMAX31855( uint8_t CSPin = 0, uint8_t Device = TC_DEVICE_MOCK );
+
+    /*!
+     * \brief Instance initialization method. Configures the chip select pin and the SPI port.
+    */
+    void begin();
+
+    /*!
+     * \brief Start reading a new frame from the converter.
+     * \return Returns \c true when the transfer was started, \c false while the conversion is still in
+     * progress or the bus is busy.
+    */
+    bool startRead();
+
+    /*!
+     * \brief Get the converter reading.
+     * \param lpTemp Buffer receiving the thermocouple temperature in degrees C. MAX31855 readings are corrected
+     * for the type K thermocouple non-linearity.
+     * \param lpColdJunction Optional buffer receiving the cold junction temperature in degrees C, \c NAN when the
+     * converter does not report it.
+     * \return Returns \c -1 when no new frame was received since the previous call, or the \c TC_FAULT_xxx flags
+     * decoded from the frame otherwize.
+    */
+    int8_t getReading( float* lpTemp, float* lpColdJunction );
+
+    /*!
+     * \brief Check whether the instance is a mock device.
+     * \return Returns \c true for #TC_DEVICE_MOCK instances.
+    */
+    bool isMock() const { return m_Device == TC_DEVICE_MOCK; }
+
+    /*!
+     * \brief Mock device oven model update.
+     * \param HeaterPower Heater power applied since the previous call, in percent.
+     * \param CoolerPower Cooling actuator power applied since the previous call, in percent.
+    */
+    void updateMock( double HeaterPower, double CoolerPower = 0.0 );
+
+    /*!
+     * \brief Mock device temperature override.
+     * \param Temp New oven model temperature in degrees C.
+    */
+    void setMockTemperature( float Temp ) { m_MockTemp = Temp; }
+
+    /*!
+     * \brief Mock device fault injection.
+     * \param Fault Fault flags reported from now on, \c TC_FAULT_NONE for normal operation.
+    */
+    void setMockFault( uint8_t Fault ) { m_MockFault = Fault; }
+
+    /*!
+     * \brief SPI byte transfer completion handling.
+     * \remarks This function must be called from the SPI transfer complete interrupt.
+    */
+    static void onTransferComplete();
+
+  private:
+    uint8_t m_CSPin;                      /*!< \brief Chip select pin. */
+    uint8_t m_Device;                     /*!< \brief Converter type. */
+    uint8_t m_Frame[ 4 ];                 /*!< \brief Frame buffer, most significant byte first. */
+    volatile uint8_t m_Count;             /*!< \brief Number of frame bytes received so far. */
+    volatile bool m_Ready;                /*!< \brief A complete frame is waiting for #getReading(). */
+    unsigned long m_ReadTime;             /*!< \brief Time of previous frame transfer start. */
+    float m_MockTemp;                     /*!< \brief Mock device oven model temperature. */
+    uint8_t m_MockFault;                  /*!< \brief Mock device injected fault flags. */
+    unsigned long m_MockTime;             /*!< \brief Time of previous mock device oven model update. */
+    static VLOvenMAX31855* volatile s_lpBusOwner;   /*!< \brief Instance with a transfer in progress, if any. */
+
+    /*!
+     * \brief Get the frame length for the converter type.
+     * \return Returns the number of bytes in a frame.
+    */
+    uint8_t frameLength() const { return (m_Device == TC_DEVICE_MAX6675) ? 2 : 4; }
+
+    /*!
+     * \brief Encode a MAX31855 frame from the mock device oven model.
+    */
+    void encodeMockFrame();
+};
+
+
+#endif  /* _VLOvenMAX31855_h_ */
@@ -0,0 +1,85 @@
+/*! \file
+ *  \brief Burst-fire SSR driver.
+ *  This file implements the class methods for the burst-fire SSR driver.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "VLOvenSSR.h"
+
+
+VLOvenSSR* VLOvenSSR::s_lpFirst = NULL;
+
+
+VLOvenSSR::VLOvenSSR( uint8_t Pin ) :
+  m_Pin( Pin ),
+  m_Duty( 0 ), m_Accumulator( 0 ), m_On( false ),
+  m_lpNext( NULL )
+{}
+
+
+void VLOvenSSR::begin()
+{
+  digitalWrite( m_Pin, LOW );
+  pinMode( m_Pin, OUTPUT );
+
+  noInterrupts();
+  m_lpNext = s_lpFirst;
+  s_lpFirst = this;
+  interrupts();
+}
+
+
+void VLOvenSSR::setDutyCycle( double Duty )
+{
+  uint16_t Value;
+
+  // Written so that NAN disables the output.
+  if (!(Duty > 0.0))
+    Value = 0;
+  else if (Duty >= 100.0)
+    Value = SSR_DUTY_FULLSCALE;
+  else
+    Value = (uint16_t)(Duty * SSR_DUTY_FULLSCALE / 100.0 + 0.5);
+
+  // 16-bit value shared with the ISR.
+  noInterrupts();
+  m_Duty = Value;
+  interrupts();
+}
+
+
+void VLOvenSSR::step()
+{
+  // Bresenham style distribution: fire whenever the accumulated demand reaches one full half-cycle.
+  m_Accumulator += m_Duty;
+  if (m_Accumulator >= SSR_DUTY_FULLSCALE)
+  {
+    m_Accumulator -= SSR_DUTY_FULLSCALE;
+    m_On = true;
+  }
+  else
+    m_On = false;
+
+  digitalWrite( m_Pin, m_On ? HIGH : LOW );
+}
+
+
+void VLOvenSSR::onHalfCycle()
+{
+  for (VLOvenSSR* lpSSR = s_lpFirst; lpSSR != NULL; lpSSR = lpSSR->m_lpNext)
+  {
+    lpSSR->step();
+  }
+}
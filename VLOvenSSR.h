@@ -0,0 +1,90 @@
+/*! \file
+ *  \brief Burst-fire SSR driver.
+ *  This file declares the class implementing mains half-cycle burst-fire control for solid state relays.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenSSR_h_
+#define  _VLOvenSSR_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define SSR_DUTY_FULLSCALE      (1000)    /*!< \brief Internal duty cycle full scale value, gives 0.1% resolution. */
+
+
+/*!
+ * \brief Burst-fire SSR driver.
+ * Each instance drives one zero-crossing SSR, firing whole mains half-cycles. The half-cycles to fire are
+ * chosen by a first order sigma-delta modulator, so the ON half-cycles are evenly spread for any duty cycle.
+ *
+ * All instances are stepped together by #onHalfCycle(), which is expected to be called from an
+ * interrupt service routine once per mains half-cycle.
+*/
+class VLOvenSSR
+{
+  public:
+    /*!
+     * \brief Constructor.
+     * \param Pin Output pin connected to the SSR control input.
+    */
+    VLOvenSSR( uint8_t Pin );
+
+    /*!
+     * \brief Instance initialization method. Configures the output pin and registers the instance for half-cycle stepping.
+    */
+    void begin();
+
+    /*!
+     * \brief Duty cycle control.
+     * \param Duty Requested duty cycle in percent. \c 0.0 disables the SSR, \c 100.0 keeps it \b ON.
+    */
+    void setDutyCycle( double Duty );
+
+    /*!
+     * \brief Get the requested duty cycle.
+     * \return Returns the duty cycle in percent.
+    */
+    double getDutyCycle() const { return (double)m_Duty * 100.0 / SSR_DUTY_FULLSCALE; }
+
+    /*!
+     * \brief Get the output state.
+     * \return Returns \c true while the SSR is firing the current half-cycle.
+    */
+    bool isOn() const { return m_On; }
+
+    /*!
+     * \brief Half-cycle stepping for all the registered instances.
+     * \remarks This function must be called from interrupt context, once per mains half-cycle.
+    */
+    static void onHalfCycle();
+
+  private:
+    uint8_t m_Pin;                        /*!< \brief Output pin connected to the SSR. */
+    volatile uint16_t m_Duty;             /*!< \brief Requested duty cycle, scaled by #SSR_DUTY_FULLSCALE. */
+    uint16_t m_Accumulator;               /*!< \brief Sigma-delta modulator accumulator. */
+    volatile bool m_On;                   /*!< \brief Output state for current half-cycle. */
+    VLOvenSSR* m_lpNext;                  /*!< \brief Next registered instance. */
+    static VLOvenSSR* s_lpFirst;          /*!< \brief First registered instance. */
+
+    /*!
+     * \brief Sigma-delta modulator step, decides whether the next half-cycle is fired.
+    */
+    void step();
+};
+
+
+#endif  /* _VLOvenSSR_h_ */
@@ -0,0 +1,116 @@
+/*! \file
+ *  \brief Oven safety supervisor.
+ *  This file implements the class methods for the oven safety supervisor.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "VLOvenSafety.h"
+
+
+VLOvenSafety::VLOvenSafety()
+{
+  clear();
+}
+
+
+void VLOvenSafety::clear()
+{
+  m_Faults = SAFETY_FAULT_NONE;
+  restart();
+}
+
+
+void VLOvenSafety::restart()
+{
+  m_RateTemp = NAN;
+  m_RateTime = millis();
+  m_WatchTemp = NAN;
+  m_WatchTime = m_RateTime;
+  m_WatchHeating = false;
+  m_WatchSettling = false;
+}
+
+
+bool VLOvenSafety::check( float Temp, float Peak, double HeaterPower )
+{
+  unsigned long Now = millis();
+  bool Heating;
+
+  if (Peak > SAFETY_MAX_TEMPERATURE)
+    m_Faults |= SAFETY_FAULT_OVERTEMP;
+
+  // No reading yet, or the sensors are gone which the caller reports on its own.
+  if (isnan( Temp ))
+  {
+    m_RateTemp = NAN;
+    m_WatchTemp = NAN;
+    return m_Faults != SAFETY_FAULT_NONE;
+  }
+
+  // Rate over a fixed interval, the averaged reading is too smooth for anything faster.
+  if (SAFETY_RATE_INTERVAL <= (Now - m_RateTime))
+  {
+    if (!isnan( m_RateTemp ) && (fabs( Temp - m_RateTemp ) * 1000.0 > SAFETY_MAX_RATE * (float)(Now - m_RateTime)))
+      m_Faults |= SAFETY_FAULT_RATE;
+    m_RateTemp = Temp;
+    m_RateTime = Now;
+  }
+
+  // One window watches the heater: near full power the temperature must rise,
+  // when off it must not keep rising. Anything in between restarts the window.
+  Heating = (HeaterPower >= SAFETY_NORISE_DUTY);
+  if (!Heating && (HeaterPower > 0.0))
+    m_WatchTemp = NAN;
+  else if (isnan( m_WatchTemp ) || (Heating != m_WatchHeating))
+  {
+    m_WatchTemp = Temp;
+    m_WatchTime = Now;
+    m_WatchHeating = Heating;
+    m_WatchSettling = !Heating;
+  }
+  else if (Heating)
+  {
+    if (Temp - m_WatchTemp >= SAFETY_NORISE_RISE)
+    {
+      m_WatchTemp = Temp;
+      m_WatchTime = Now;
+    }
+    else if (SAFETY_NORISE_TIME <= (Now - m_WatchTime))
+      m_Faults |= SAFETY_FAULT_NORISE;
+  }
+  else if (m_WatchSettling)
+  {
+    // The elements keep heating the air a while after going off, the
+    // runaway window starts from the temperature reached by then.
+    if (SAFETY_RUNAWAY_DELAY <= (Now - m_WatchTime))
+    {
+      m_WatchTemp = Temp;
+      m_WatchTime = Now;
+      m_WatchSettling = false;
+    }
+  }
+  else
+  {
+    if (Temp - m_WatchTemp > SAFETY_RUNAWAY_RISE)
+      m_Faults |= SAFETY_FAULT_RUNAWAY;
+    else if (SAFETY_RUNAWAY_TIME <= (Now - m_WatchTime))
+    {
+      m_WatchTemp = Temp;
+      m_WatchTime = Now;
+    }
+  }
+
+  return m_Faults != SAFETY_FAULT_NONE;
+}
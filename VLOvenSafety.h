@@ -0,0 +1,101 @@
+/*! \file
+ *  \brief Oven safety supervisor.
+ *  This file declares the class watching for thermal runaway and sensor faults.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenSafety_h_
+#define  _VLOvenSafety_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define SAFETY_FAULT_NONE         0x00      /*!< \brief No fault latched. */
+#define SAFETY_FAULT_OVERTEMP     0x01      /*!< \brief A sensor sample exceeded #SAFETY_MAX_TEMPERATURE. */
+#define SAFETY_FAULT_RATE         0x02      /*!< \brief The temperature changed faster than #SAFETY_MAX_RATE. */
+#define SAFETY_FAULT_NORISE       0x04      /*!< \brief The heater ran near full power without the temperature rising. */
+#define SAFETY_FAULT_RUNAWAY      0x08      /*!< \brief The temperature kept rising with the heater off, a welded SSR. */
+#define SAFETY_FAULT_SENSOR       0x10      /*!< \brief No valid control temperature, open or shorted sensor. */
+#define SAFETY_FAULT_INJECTED     0x80      /*!< \brief Fault forced from the console. */
+
+#define SAFETY_MAX_TEMPERATURE    (280.0)   /*!< \brief Highest temperature sample tolerated, in degrees C. */
+#define SAFETY_MAX_RATE           (10.0)    /*!< \brief Highest temperature change rate tolerated, in degrees C/second. */
+#define SAFETY_RATE_INTERVAL      (1000)    /*!< \brief Interval in <b>ms</b> the change rate is measured over. */
+#define SAFETY_NORISE_DUTY        (90.0)    /*!< \brief Heater power in percent from which the temperature must rise. */
+#define SAFETY_NORISE_RISE        (5.0)     /*!< \brief Minimum rise in degrees C expected within #SAFETY_NORISE_TIME at full power. */
+#define SAFETY_NORISE_TIME        (60000)   /*!< \brief Time in <b>ms</b> the heater may run at full power before the rise is checked. */
+#define SAFETY_RUNAWAY_RISE       (20.0)    /*!< \brief Maximum rise in degrees C tolerated within #SAFETY_RUNAWAY_TIME with the heater off. */
+#define SAFETY_RUNAWAY_TIME       (60000)   /*!< \brief Time in <b>ms</b> the temperature is watched after the heater goes off. */
+#define SAFETY_RUNAWAY_DELAY      (30000)   /*!< \brief Time in <b>ms</b> the heater elements overshoot after going off, before the runaway watch starts. */
+
+
+/*!
+ * \brief Oven safety supervisor.
+ * Checks every acquisition pass, independently from the control loops, for conditions that make heating unsafe.
+ * Every check costs a constant time. Detected faults are latched until explicitly cleared.
+*/
+class VLOvenSafety
+{
+  public:
+    /*!
+     * \brief Constructor.
+    */
+    VLOvenSafety();
+
+    /*!
+     * \brief Run all the checks for one acquisition pass.
+     * \param Temp Control temperature in degrees C, \c NAN when not available, which skips the checks based on it.
+     * \param Peak Highest sensor sample from the pass in degrees C, \c NAN when there is none.
+     * \param HeaterPower Requested heater power in percent.
+     * \return Returns \c true when a fault is latched.
+    */
+    bool check( float Temp, float Peak, double HeaterPower );
+
+    /*!
+     * \brief Get the latched faults.
+     * \return Returns the \c SAFETY_FAULT_xxx flags latched so far.
+    */
+    uint8_t getFaults() const { return m_Faults; }
+
+    /*!
+     * \brief Clear the latched faults and restart the watch windows.
+    */
+    void clear();
+
+    /*!
+     * \brief Restart the watch windows, keeping the latched faults.
+     * Needed when the control temperature source changes, the step between two sensors is not a temperature change.
+    */
+    void restart();
+
+    /*!
+     * \brief Latch faults detected elsewhere, or injected for testing the shutdown path.
+     * \param Faults \c SAFETY_FAULT_xxx flags to latch.
+    */
+    void trip( uint8_t Faults ) { m_Faults |= Faults; }
+
+  private:
+    uint8_t m_Faults;                     /*!< \brief Latched fault flags. */
+    float m_RateTemp;                     /*!< \brief Temperature at the start of the rate interval. */
+    unsigned long m_RateTime;             /*!< \brief Start time of the rate interval. */
+    float m_WatchTemp;                    /*!< \brief Temperature at the start of the heater watch window, \c NAN when not watching. */
+    unsigned long m_WatchTime;            /*!< \brief Start time of the heater watch window. */
+    bool m_WatchHeating;                  /*!< \brief The heater watch window checks for a rise, otherwise for runaway. */
+    bool m_WatchSettling;                 /*!< \brief The heater just went off, the runaway watch waits for #SAFETY_RUNAWAY_DELAY. */
+};
+
+
+#endif  /* _VLOvenSafety_h_ */
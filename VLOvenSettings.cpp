@@ -0,0 +1,228 @@
+/*! \file
+ *  \brief Controller settings store.
+ *  This file implements the class methods for the controller settings store.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+#include <TextConsole.h>
+#include "VLOvenEEPROM.h"
+#include "VLOvenController.h"
+#include "VLOvenSettings.h"
+
+
+/*!
+ * \brief Setting description.
+*/
+typedef struct {
+  char Name[ SETTING_NAME_LENGTH ];         /*!< \brief Setting name. */
+  uint8_t Offset;                           /*!< \brief Location of the setting in #VLOvenSettings_t. */
+  uint8_t Type;                             /*!< \brief Setting type, one of the \c SETTING_TYPE_xxx values. */
+  uint8_t Flags;                            /*!< \brief \c SETTING_FLAG_xxx flags. */
+  float Min;                                /*!< \brief Lowest value accepted. */
+  float Max;                                /*!< \brief Highest value accepted. */
+  float Default;                            /*!< \brief Built-in default value. */
+} VLOvenSettingInfo_t;
+
+
+/*! \brief Settings descriptions, the defaults are the former compile-time values. */
+static const VLOvenSettingInfo_t SETTINGS[] PROGMEM =
+{
+  { "kp",   offsetof( VLOvenSettings_t, Kp ),                 SETTING_TYPE_FLOAT,  0,                  0.0,    10000.0,  PID_KP },
+  { "ki",   offsetof( VLOvenSettings_t, Ki ),                 SETTING_TYPE_FLOAT,  0,                  0.0,    100.0,    PID_KI },
+  { "kd",   offsetof( VLOvenSettings_t, Kd ),                 SETTING_TYPE_FLOAT,  0,                  0.0,    10000.0,  PID_KD },
+  { "pidt", offsetof( VLOvenSettings_t, PIDSampleTime ),      SETTING_TYPE_UINT16, 0,                  50.0,   5000.0,   PID_SAMPLE_TIME },
+  { "prft", offsetof( VLOvenSettings_t, ProfileSampleTime ),  SETTING_TYPE_UINT16, 0,                  10.0,   1000.0,   PROFILE_SAMPLING_TIME },
+  { "lead", offsetof( VLOvenSettings_t, LeadTime ),           SETTING_TYPE_UINT16, SETTING_FLAG_IDLE,  0.0,    30000.0,  PROFILE_SETPOINT_LEADTIME },
+  { "blnd", offsetof( VLOvenSettings_t, BlendTime ),          SETTING_TYPE_UINT16, SETTING_FLAG_IDLE,  0.0,    30000.0,  PROFILE_BLENDING_TIME },
+  { "maxr", offsetof( VLOvenSettings_t, MaxHeatingRate ),     SETTING_TYPE_FLOAT,  0,                  0.5,    20.0,     MAXIMUM_HEATING_RATE },
+  { "avg",  offsetof( VLOvenSettings_t, AveragingSamples ),   SETTING_TYPE_UINT8,  0,                  1.0,    TEMP_AVERAGING_SAMPLES, TEMP_AVERAGING_SAMPLES },
+  { "tlm",  offsetof( VLOvenSettings_t, TelemetryDivider ),   SETTING_TYPE_UINT8,  0,                  0.0,    100.0,    1 }
+};
+
+#define SETTINGS_COUNT            (sizeof(SETTINGS) / sizeof(SETTINGS[0]))
+
+
+VLOvenSettings::VLOvenSettings() :
+  m_Offset( -1 ), m_Modified( false ), m_Writing( false )
+{
+  setDefaults();
+  m_Modified = false;
+}
+
+
+uint16_t VLOvenSettings::getCrc( const VLOvenSettings_t& Settings )
+{
+  const uint8_t* lpData = (const uint8_t*)&Settings;
+  uint16_t Crc = 0xFFFF;
+
+  for (uint8_t Index = 0; Index < offsetof( VLOvenSettings_t, Crc ); Index++)
+  {
+    Crc = _crc_ccitt_update( Crc, lpData[ Index ] );
+  }
+  return Crc;
+}
+
+
+uint8_t VLOvenSettings::getCount()
+{
+  return SETTINGS_COUNT;
+}
+
+
+int8_t VLOvenSettings::find( const char* lpName )
+{
+  for (uint8_t Index = 0; Index < SETTINGS_COUNT; Index++)
+  {
+    if (strcmp_P( lpName, SETTINGS[ Index ].Name ) == 0)
+      return Index;
+  }
+  return -1;
+}
+
+
+void VLOvenSettings::getName( uint8_t Index, char* lpName )
+{
+  strcpy_P( lpName, SETTINGS[ Index ].Name );
+}
+
+
+uint8_t VLOvenSettings::getType( uint8_t Index )
+{
+  return pgm_read_byte( &SETTINGS[ Index ].Type );
+}
+
+
+uint8_t VLOvenSettings::getFlags( uint8_t Index )
+{
+  return pgm_read_byte( &SETTINGS[ Index ].Flags );
+}
+
+
+double VLOvenSettings::getValue( const VLOvenSettings_t& Settings, uint8_t Index )
+{
+  const uint8_t* lpField = (const uint8_t*)&Settings + pgm_read_byte( &SETTINGS[ Index ].Offset );
+
+  switch (pgm_read_byte( &SETTINGS[ Index ].Type ))
+  {
+    case SETTING_TYPE_FLOAT:
+      return *(const float*)lpField;
+
+    case SETTING_TYPE_UINT16:
+      return *(const uint16_t*)lpField;
+
+    default:
+      return *lpField;
+  }
+}
+
+
+double VLOvenSettings::getValue( uint8_t Index ) const
+{
+  return getValue( m_Settings, Index );
+}
+
+
+bool VLOvenSettings::setValue( uint8_t Index, double Value )
+{
+  VLOvenSettingInfo_t Info;
+  uint8_t* lpField;
+
+  memcpy_P( &Info, &SETTINGS[ Index ], sizeof(Info) );
+  if (Info.Type != SETTING_TYPE_FLOAT)
+    Value = round( Value );
+  if (isnan( Value ) || (Value < Info.Min) || (Value > Info.Max))
+    return false;
+
+  lpField = (uint8_t*)&m_Settings + Info.Offset;
+  switch (Info.Type)
+  {
+    case SETTING_TYPE_FLOAT:
+      *(float*)lpField = Value;
+      break;
+
+    case SETTING_TYPE_UINT16:
+      *(uint16_t*)lpField = Value;
+      break;
+
+    default:
+      *lpField = Value;
+      break;
+  }
+  m_Modified = true;
+  return true;
+}
+
+
+void VLOvenSettings::setDefaults()
+{
+  m_Settings.Version = SETTINGS_VERSION;
+  for (uint8_t Index = 0; Index < SETTINGS_COUNT; Index++)
+  {
+    setValue( Index, pgm_read_float( &SETTINGS[ Index ].Default ) );
+  }
+}
+
+
+bool VLOvenSettings::check( const VLOvenSettings_t& Settings )
+{
+  for (uint8_t Index = 0; Index < SETTINGS_COUNT; Index++)
+  {
+    double Value = getValue( Settings, Index );
+
+    if (isnan( Value ) || (Value < pgm_read_float( &SETTINGS[ Index ].Min )) || (Value > pgm_read_float( &SETTINGS[ Index ].Max )))
+      return false;
+  }
+  return true;
+}
+
+
+bool VLOvenSettings::begin( int Offset )
+{
+  VLOvenSettings_t Settings;
+
+  m_Offset = Offset;
+  VLOvenEEPROM::get( m_Offset, Settings );
+
+  // A record from another layout version, or with a value a newer range no longer accepts, is dropped whole.
+  if ((Settings.Version != SETTINGS_VERSION) || (Settings.Crc != getCrc( Settings )) || !check( Settings ))
+    return false;
+
+  m_Settings = Settings;
+  m_Modified = false;
+  return true;
+}
+
+
+void VLOvenSettings::onWritten( void* lpContext )
+{
+  ((VLOvenSettings*)lpContext)->m_Writing = false;
+}
+
+
+bool VLOvenSettings::commit()
+{
+  if ((m_Offset < 0) || m_Writing || (VLOvenEEPROM::getFree() == 0))
+    return false;
+
+  m_Record = m_Settings;
+  m_Record.Crc = getCrc( m_Record );
+  m_Writing = true;
+  m_Modified = false;
+  VLOvenEEPROM::write( m_Offset, &m_Record, sizeof(m_Record), onWritten, this );
+  return true;
+}
@@ -0,0 +1,188 @@
+/*! \file
+ *  \brief Controller settings store.
+ *  This file declares the class keeping the tunable controller settings in EEPROM.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenSettings_h_
+#define  _VLOvenSettings_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define SETTINGS_VERSION          (1)           /*!< \brief Settings record layout version, increased on every layout change. */
+#define SETTING_NAME_LENGTH       (5)           /*!< \brief Number of chars for storing setting names, terminating null included. */
+
+#define SETTING_TYPE_FLOAT        0             /*!< \brief Setting stored as a \c float. */
+#define SETTING_TYPE_UINT16       1             /*!< \brief Setting stored as an \c uint16_t. */
+#define SETTING_TYPE_UINT8        2             /*!< \brief Setting stored as an \c uint8_t. */
+
+#define SETTING_FLAG_IDLE         0x01          /*!< \brief Setting flag: it may only change while the controller is not running. */
+
+/*! \brief Default KP parameter (proportional gain) for the PID controller */
+#define PID_KP  300
+/*! \brief Default KI parameter (integral gain) for the PID controller */
+#define PID_KI  0.05
+/*! \brief Default KD parameter (derivative gain) for the PID controller */
+#define PID_KD  250
+
+
+/*!
+ * \brief Controller settings record, as stored in EEPROM.
+ * Times are in <b>ms</b>.
+*/
+typedef struct {
+  uint8_t Version;                          /*!< \brief Record layout version, see #SETTINGS_VERSION. */
+  float Kp;                                 /*!< \brief PID proportional gain. */
+  float Ki;                                 /*!< \brief PID integral gain. */
+  float Kd;                                 /*!< \brief PID derivative gain. */
+  float MaxHeatingRate;                     /*!< \brief Measured heating rate in degrees C/second above which the heater duty is throttled. */
+  uint16_t PIDSampleTime;                   /*!< \brief PID sampling time. */
+  uint16_t ProfileSampleTime;               /*!< \brief Temperature profile generator sampling time. */
+  uint16_t LeadTime;                        /*!< \brief Look-ahead time for the setpoint handed to the PID. */
+  uint16_t BlendTime;                       /*!< \brief Width of the window blending the setpoint at phase boundaries. */
+  uint8_t AveragingSamples;                 /*!< \brief Number of analog sensor reading samples to average. */
+  uint8_t TelemetryDivider;                 /*!< \brief A \c pid event is sent every that many PID computations, \c 0 for none. */
+  uint16_t Crc;                             /*!< \brief CRC-16 over the previous fields. */
+} VLOvenSettings_t;
+
+
+/*!
+ * \brief Controller settings store.
+ * Holds the settings in use, each one addressed by a short name and checked against its range when set. They
+ * start from built-in defaults, replaced by the EEPROM record when it is valid. Changes only reach the EEPROM
+ * when committed, through the EEPROM write queue.
+*/
+class VLOvenSettings
+{
+  public:
+    /*!
+     * \brief Constructor, loading the defaults.
+    */
+    VLOvenSettings();
+
+    /*!
+     * \brief Load the settings record, keeping the defaults when it is not valid.
+     * \param Offset EEPROM location of the settings record, #getStorageSize() bytes long.
+     * \return Returns \c true when the record was valid.
+    */
+    bool begin( int Offset );
+
+    /*!
+     * \brief Get the EEPROM space taken by the settings.
+     * \return Returns the size in bytes of the settings record.
+    */
+    static int getStorageSize() { return sizeof(VLOvenSettings_t); }
+
+    /*!
+     * \brief Get the settings in use.
+    */
+    const VLOvenSettings_t& get() const { return m_Settings; }
+
+    /*!
+     * \brief Get the number of settings.
+    */
+    static uint8_t getCount();
+
+    /*!
+     * \brief Look a setting up by name.
+     * \param lpName Setting name.
+     * \return Returns the setting index, \c -1 when there is no such setting.
+    */
+    static int8_t find( const char* lpName );
+
+    /*!
+     * \brief Get a setting name.
+     * \param Index Setting index.
+     * \param lpName Buffer receiving the name, #SETTING_NAME_LENGTH chars long.
+    */
+    static void getName( uint8_t Index, char* lpName );
+
+    /*!
+     * \brief Get a setting type.
+     * \param Index Setting index.
+     * \return Returns the \c SETTING_TYPE_xxx value of the setting.
+    */
+    static uint8_t getType( uint8_t Index );
+
+    /*!
+     * \brief Get a setting flags.
+     * \param Index Setting index.
+     * \return Returns the \c SETTING_FLAG_xxx flags of the setting.
+    */
+    static uint8_t getFlags( uint8_t Index );
+
+    /*!
+     * \brief Get a setting value.
+     * \param Index Setting index.
+     * \return Returns the value in use.
+    */
+    double getValue( uint8_t Index ) const;
+
+    /*!
+     * \brief Change a setting value.
+     * \param Index Setting index.
+     * \param Value New value, rounded for the integer settings.
+     * \return Returns \c true when changed, \c false when out of the setting range.
+    */
+    bool setValue( uint8_t Index, double Value );
+
+    /*!
+     * \brief Go back to the built-in defaults.
+    */
+    void setDefaults();
+
+    /*!
+     * \brief Check whether the settings in use differ from the last ones loaded or committed.
+    */
+    bool isModified() const { return m_Modified; }
+
+    /*!
+     * \brief Queue the write of the settings in use.
+     * \return Returns \c false while the previous commit is being written, or the EEPROM write queue is full.
+    */
+    bool commit();
+
+  private:
+    VLOvenSettings_t m_Settings;              /*!< \brief Settings in use. */
+    VLOvenSettings_t m_Record;                /*!< \brief Settings record, the copy being written. */
+    int m_Offset;                             /*!< \brief EEPROM location of the settings record, \c -1 before #begin(). */
+    bool m_Modified;                          /*!< \brief The settings in use differ from the EEPROM record. */
+    bool m_Writing;                           /*!< \brief The settings record is still being written. */
+
+    /*!
+     * \brief Compute the CRC of a settings record.
+    */
+    static uint16_t getCrc( const VLOvenSettings_t& Settings );
+
+    /*!
+     * \brief Check every setting of a record against its range.
+    */
+    static bool check( const VLOvenSettings_t& Settings );
+
+    /*!
+     * \brief Get a setting value from a record.
+    */
+    static double getValue( const VLOvenSettings_t& Settings, uint8_t Index );
+
+    /*!
+     * \brief EEPROM write completion callback.
+    */
+    static void onWritten( void* lpContext );
+};
+
+
+#endif  /* _VLOvenSettings_h_ */
@@ -19,22 +19,198 @@
 #include "VLOvenShield.h"
 
 
+/*! \brief Analog inputs for the temperature sensor channels. */
+static const uint8_t TC_PINS[ TC_CHANNELS ] = { TC_CHANNEL_PINS };
+
+/*! \brief Front-end types for the temperature sensor channels. */
+static const uint8_t TC_TYPES[ TC_CHANNELS ] = { TC_CHANNEL_TYPES };
+
+/*! \brief Roles for the temperature sensor channels. */
+static const uint8_t TC_ROLES[ TC_CHANNELS ] = { TC_CHANNEL_ROLES };
+
+/*! \brief Fusion weights for the temperature sensor channels. */
+static const float TC_WEIGHTS[ TC_CHANNELS ] = { TC_CHANNEL_WEIGHTS };
+
+/*! \brief Input pins readable by the profile exit rules. */
+static const uint8_t EXIT_INPUTS[] = { EXIT_INPUT_PINS };
+
+/*! \brief Number of analog conversions slots in an acquisition pass, the cold junction sensor takes the last one. */
+#if defined(TC_COLD_JUNCTION_PIN)
+# define TC_SCAN_SLOTS          (TC_CHANNELS + 1)
+#else
+# define TC_SCAN_SLOTS          (TC_CHANNELS)
+#endif
+
+static volatile uint16_t s_ScanResults[ TC_SCAN_SLOTS ];  /*!< \brief ADC readings from the last acquisition pass. */
+static volatile uint8_t s_ScanChannel;                  /*!< \brief Sensor channel being converted. */
+static volatile bool s_Scanning = false;                /*!< \brief Acquisition pass in progress. */
+static volatile bool s_ScanDone = false;                /*!< \brief Acquisition pass completed, results pending processing. */
+
+
+/*!
+ * \brief Calculate the ADC multiplexer selection for an analog input.
+ * \param Pin Analog input pin.
+ * \return Returns the ADMUX register value selecting the input and the configured reference.
+*/
+static inline uint8_t adcMux( uint8_t Pin )
+{
+  if (Pin >= A0)
+    Pin -= A0;
+  return (ADC_REFERENCE << 6) | (Pin & 0x07);
+}
+
+
+/*!
+ * \brief Get the analog input for an acquisition pass slot.
+ * \param Slot Sensor channel index, or #TC_CHANNELS for the cold junction sensor.
+ * \return Returns the analog input pin.
+*/
+static inline uint8_t scanPin( uint8_t Slot )
+{
+#if defined(TC_COLD_JUNCTION_PIN)
+  if (Slot >= TC_CHANNELS)
+    return TC_COLD_JUNCTION_PIN;
+#endif
+  return TC_PINS[ Slot ];
+}
+
+
+/*!
+ * \brief Find the next analog sensor channel.
+ * \param Channel First sensor channel to consider.
+ * \return Returns the index of the first analog channel from \p Channel on, or #TC_CHANNELS when there is none.
+ * With a cold junction sensor, #TC_CHANNELS is the slot converting it.
+*/
+static inline uint8_t nextAnalogChannel( uint8_t Channel )
+{
+  while ((Channel < TC_CHANNELS) && (TC_TYPES[ Channel ] != TC_TYPE_ANALOG))
+    Channel++;
+  return Channel;
+}
+
+
+/*!
+ * \brief ADC conversion complete interrupt, chains the conversions for all the analog sensor channels.
+*/
+ISR(ADC_vect)
+{
+  s_ScanResults[ s_ScanChannel ] = ADC;
+
+  s_ScanChannel = nextAnalogChannel( s_ScanChannel + 1 );
+  if (s_ScanChannel < TC_SCAN_SLOTS)
+  {
+    ADMUX = adcMux( scanPin( s_ScanChannel ) );
+    ADCSRA |= _BV(ADSC);
+  }
+  else
+  {
+    ADCSRA &= ~_BV(ADIE);
+    s_Scanning = false;
+    s_ScanDone = true;
+  }
+}
+
+
 VLOvenShield::VLOvenShield() : 
   m_Led1( PIN_LED1 ), //m_Led2( PIN_LED2 ),
   m_Lcd( PORT_LCD_PIN_RS, PORT_LCD_PIN_RW, PORT_LCD_PIN_EN, PORT_LCD_PIN_DB4, PORT_LCD_PIN_DB5, PORT_LCD_PIN_DB6, PORT_LCD_PIN_DB7 ),
   m_Keys( { GPIOKey(PIN_KEY_OK, (uint8_t)KEYPRESS_OK ), GPIOKey( PIN_KEY_CANCEL, (uint8_t)KEYPRESS_CANCEL ), GPIOKey( PIN_KEY_UP, (uint8_t)KEYPRESS_UP ), GPIOKey( PIN_KEY_DOWN, (uint8_t)KEYPRESS_DOWN ) } ),
-  m_SSR( PIN_SSR, HEATER_PERIODE ),
-  m_Average( TEMP_AVERAGING_SAMPLES )
+  m_SSR{ HEATER_CHANNEL_PINS },
+#if defined(PIN_FAN)
+  m_Fan( PIN_FAN ),
+#endif
+#if defined(PIN_COOLER)
+  m_Cooler( PIN_COOLER ),
+#endif
+  m_TempSampleTime( 0 )
 {
   m_Lcd.begin( 20, 4 );
   m_Led1.off();
   //m_Led2.off();
   m_TempSampleTime = millis();
-  m_Average.clear();
+  m_FailedChannels = 0;
+  for (uint8_t Channel = 0; Channel < TC_CHANNELS; Channel++)
+  {
+    if (TC_TYPES[ Channel ] == TC_TYPE_ANALOG)
+    {
+      m_Average[ Channel ].setLength( TEMP_AVERAGING_SAMPLES );
+    }
+    else
+    {
+      m_Average[ Channel ].setLength( TC_SPI_AVERAGING_SAMPLES );
+      m_Converter[ Channel ] = VLOvenMAX31855( TC_PINS[ Channel ], TC_TYPES[ Channel ] );
+    }
+    m_Sample[ Channel ] = NAN;
+    m_Reading[ Channel ] = NAN;
+    m_FaultSamples[ Channel ] = 0;
+    m_Fault[ Channel ] = TC_FAULT_NONE;
+  }
+  m_Estimate[ TC_ROLE_AIR ] = m_Estimate[ TC_ROLE_PCB ] = NAN;
+  m_Variance[ TC_ROLE_AIR ] = m_Variance[ TC_ROLE_PCB ] = 0.0;
   analogReference( ADC_REFERENCE );
 }
 
 
+/*!
+ * \brief Timer1 compare match interrupt, fires once per mains half-cycle.
+*/
+ISR(TIMER1_COMPA_vect)
+{
+  VLOvenSSR::onHalfCycle();
+}
+
+
+#if defined(PIN_ZEROCROSS)
+/*!
+ * \brief Zero-cross detector interrupt, aligns the SSR stepping with the mains zero crossings.
+*/
+static void onZeroCross()
+{
+  // Restart the backup timer, it only fires when detector pulses go missing.
+  TCNT1 = 0;
+  VLOvenSSR::onHalfCycle();
+}
+#endif
+
+
+void VLOvenShield::begin()
+{
+  for (uint8_t Channel = 0; Channel < HEATER_CHANNELS; Channel++)
+  {
+    m_SSR[ Channel ].begin();
+  }
+#if defined(PIN_FAN)
+  m_Fan.begin();
+#endif
+#if defined(PIN_COOLER)
+  m_Cooler.begin();
+#endif
+  for (uint8_t Channel = 0; Channel < TC_CHANNELS; Channel++)
+  {
+    if (TC_TYPES[ Channel ] != TC_TYPE_ANALOG)
+      m_Converter[ Channel ].begin();
+  }
+
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS11);    // CTC mode, clk/8.
+  OCR1A = HALFCYCLE_TIMER_COUNT;
+  TCNT1 = 0;
+  TIMSK1 |= _BV(OCIE1A);
+  interrupts();
+
+#if defined(PIN_ZEROCROSS)
+  pinMode( PIN_ZEROCROSS, INPUT );
+  attachPinChangeInterrupt( PIN_ZEROCROSS, onZeroCross, RISING );
+#endif
+
+  for (uint8_t Index = 0; Index < sizeof(EXIT_INPUTS); Index++)
+  {
+    pinMode( EXIT_INPUTS[ Index ], INPUT_PULLUP );
+  }
+}
+
+
 PressedKeyCode_t VLOvenShield::checkKeys()
 {
   for (int Index = 0; Index < sizeof(m_Keys) / sizeof(m_Keys[0]); Index++)
@@ -52,36 +228,299 @@ PressedKeyCode_t VLOvenShield::checkKeys()
 }
 
 
+void VLOvenShield::setHeaterDuty( uint8_t Channel, double Duty )
+{
+  if (m_Safety.getFaults() != SAFETY_FAULT_NONE)
+    Duty = 0.0;
+  if (Channel < HEATER_CHANNELS)
+    m_SSR[ Channel ].setDutyCycle( Duty );
+}
+
+
 void VLOvenShield::setHeaterDuty( double Duty )
 {
-  m_SSR.setDutyCycle( Duty );
+  if (m_Safety.getFaults() != SAFETY_FAULT_NONE)
+    Duty = 0.0;
+  for (uint8_t Channel = 0; Channel < HEATER_CHANNELS; Channel++)
+  {
+    m_SSR[ Channel ].setDutyCycle( Duty );
+  }
+}
+
+
+VLOvenMAX31855* VLOvenShield::getConverter( uint8_t Channel )
+{
+  return ((Channel < TC_CHANNELS) && (TC_TYPES[ Channel ] != TC_TYPE_ANALOG)) ? &m_Converter[ Channel ] : NULL;
+}
+
+
+bool VLOvenShield::isInputPin( uint8_t Pin )
+{
+  for (uint8_t Index = 0; Index < sizeof(EXIT_INPUTS); Index++)
+  {
+    if (EXIT_INPUTS[ Index ] == Pin)
+      return true;
+  }
+  return false;
+}
+
+
+bool VLOvenShield::readInput( uint8_t Pin )
+{
+  // Profiles come from the console, their pin numbers are not trusted.
+  return isInputPin( Pin ) && (digitalRead( Pin ) == LOW);
+}
+
+
+double VLOvenShield::getHeaterPower()
+{
+  double Power = 0.0;
+
+  for (uint8_t Channel = 0; Channel < HEATER_CHANNELS; Channel++)
+  {
+    Power += m_SSR[ Channel ].getDutyCycle();
+  }
+  return Power / HEATER_CHANNELS;
+}
+
+
+void VLOvenShield::setFanDuty( double Duty )
+{
+#if defined(PIN_FAN)
+  m_Fan.setDutyCycle( Duty );
+#endif
+}
+
+
+void VLOvenShield::setCoolerDuty( double Duty )
+{
+#if defined(PIN_COOLER)
+  m_Cooler.setDutyCycle( Duty );
+#endif
+}
+
+
+double VLOvenShield::getCoolerDuty()
+{
+#if defined(PIN_COOLER)
+  return m_Cooler.getDutyCycle();
+#else
+  return 0.0;
+#endif
 }
 
 
 void VLOvenShield::doCycle()
 {
   m_Led1.update();
-  m_SSR.update();
   //m_Led2.update();
 
-  if (TEMP_SAMPLING_TIME <= (millis() - m_TempSampleTime))
+  // Converter transfers start as soon as their conversion time elapses and complete in the background.
+  for (uint8_t Channel = 0; Channel < TC_CHANNELS; Channel++)
+  {
+    if (TC_TYPES[ Channel ] == TC_TYPE_ANALOG)
+      continue;
+    if (TC_TYPES[ Channel ] == TC_DEVICE_MOCK)
+      m_Converter[ Channel ].updateMock( getHeaterPower(), getCoolerDuty() );
+    m_Converter[ Channel ].startRead();
+  }
+
+  if (s_ScanDone)
+  {
+    s_ScanDone = false;
+    processScan();
+  }
+
+  if (!s_Scanning && (TEMP_SAMPLING_TIME <= (millis() - m_TempSampleTime)))
   {
-    m_Average.addValue( (float)(analogRead( PORT_TEMP_SONDE ) & (~AD_READINGMASK)) * (float)ADC_REFVOLTAGE / (float)(ADC_FULLSCALE) / 5e-3 );
     m_TempSampleTime = millis();
+    startScan();
+  }
+}
+
+
+void VLOvenShield::startScan()
+{
+  s_ScanChannel = nextAnalogChannel( 0 );
+  if (s_ScanChannel >= TC_SCAN_SLOTS)
+  {
+    // Converter channels only, nothing to convert.
+    s_ScanDone = true;
+    return;
   }
 
-  m_TempAccumulator += analogRead( PORT_TEMP_SONDE );
-  m_TempSamplesCount++;
+  s_Scanning = true;
+  ADMUX = adcMux( scanPin( s_ScanChannel ) );
+  ADCSRA |= _BV(ADIE) | _BV(ADSC);
 }
 
 
-float VLOvenShield::readTC()
+void VLOvenShield::processScan()
 {
-  //return m_TempSample;
-  
-  float Result = 0.0;
-  int Count;
+  uint16_t Counts;
+  float Value;
+  int8_t Fault;
+  int32_t JunctionVoltage = 0;
+  float Peak = NAN;
+  uint8_t FailedChannels = m_FailedChannels;
+
+#if defined(TC_COLD_JUNCTION_PIN)
+  JunctionVoltage = typeKVoltage( ((int32_t)s_ScanResults[ TC_CHANNELS ] * TC_COLD_JUNCTION_COUNTS) >> 16 );
+#endif
+
+  for (uint8_t Channel = 0; Channel < TC_CHANNELS; Channel++)
+  {
+    if (TC_TYPES[ Channel ] != TC_TYPE_ANALOG)
+    {
+      Fault = m_Converter[ Channel ].getReading( &Value, NULL );
 
-  return m_Average.getAverage();
+      // No new frame since the previous pass.
+      if (Fault < 0)
+      {
+        m_Sample[ Channel ] = NAN;
+        continue;
+      }
+    }
+    else
+    {
+      Counts = s_ScanResults[ Channel ] & (~AD_READINGMASK);
+      if (Counts < TC_VALID_MIN_COUNTS)
+        Fault = TC_FAULT_SHORT_GND;
+      else if (Counts > TC_VALID_MAX_COUNTS)
+        Fault = TC_FAULT_OPEN;
+      else
+        Fault = TC_FAULT_NONE;
+      Value = (float)typeKTemperature( (((int32_t)Counts * TC_VOLTAGE_SCALE) >> 16) + JunctionVoltage ) / 100.0;
+    }
+
+    m_Fault[ Channel ] = Fault;
+    if (Fault != TC_FAULT_NONE)
+    {
+      // Invalid samples never reach the average, the channel is
+      // rejected after enough of them in a row.
+      m_Sample[ Channel ] = NAN;
+      if (m_FaultSamples[ Channel ] < TC_FAULT_SAMPLES)
+        m_FaultSamples[ Channel ]++;
+      else if (!(m_FailedChannels & (1 << Channel)))
+      {
+        m_FailedChannels |= (1 << Channel);
+        m_Reading[ Channel ] = NAN;
+        m_Average[ Channel ].clear();
+      }
+      continue;
+    }
+
+    m_FaultSamples[ Channel ] = 0;
+    m_FailedChannels &= ~(1 << Channel);
+    m_Sample[ Channel ] = Value;
+    m_Average[ Channel ].addValue( m_Sample[ Channel ] );
+    m_Reading[ Channel ] = m_Average[ Channel ].getAverage();
+    if (!(Value <= Peak))
+      Peak = Value;
+  }
+
+  fuse();
+
+  // Supervision runs on every pass, whatever the control loops are doing. Sensors
+  // rejected after having worked are a fault, as opposed to not being read yet.
+  // Falling back to other sensors steps the control temperature, which must not
+  // look like a change rate or a runaway.
+  if (m_FailedChannels && isnan( readTC() ))
+    m_Safety.trip( SAFETY_FAULT_SENSOR );
+  else if (m_FailedChannels != FailedChannels)
+    m_Safety.restart();
+  if (m_Safety.check( readTC(), Peak, getHeaterPower() ))
+  {
+    for (uint8_t Channel = 0; Channel < HEATER_CHANNELS; Channel++)
+    {
+      m_SSR[ Channel ].setDutyCycle( 0.0 );
+    }
+  }
+}
+
+
+void VLOvenShield::fuse()
+{
+  for (uint8_t Role = TC_ROLE_AIR; Role <= TC_ROLE_PCB; Role++)
+  {
+    float Sum = 0.0;
+    float Weights = 0.0;
+    uint8_t Available = 0;
+
+#if (TC_FUSION == TC_FUSION_KALMAN)
+    m_Variance[ Role ] += TC_KALMAN_PROCESS_NOISE;
+#endif
+
+    for (uint8_t Channel = 0; Channel < TC_CHANNELS; Channel++)
+    {
+      if ((TC_ROLES[ Channel ] != Role) || (m_FailedChannels & (1 << Channel)))
+        continue;
+
+      Available++;
+#if (TC_FUSION == TC_FUSION_KALMAN)
+      // Sequential scalar updates, one per channel sample.
+      if (!isnan( m_Sample[ Channel ] ))
+      {
+        float Noise = TC_KALMAN_SENSOR_NOISE / TC_WEIGHTS[ Channel ];
+
+        if (isnan( m_Estimate[ Role ] ))
+        {
+          m_Estimate[ Role ] = m_Sample[ Channel ];
+          m_Variance[ Role ] = Noise;
+        }
+        else
+        {
+          float Gain = m_Variance[ Role ] / (m_Variance[ Role ] + Noise);
+
+          m_Estimate[ Role ] += Gain * (m_Sample[ Channel ] - m_Estimate[ Role ]);
+          m_Variance[ Role ] *= (1.0 - Gain);
+        }
+      }
+#else
+      if (!isnan( m_Reading[ Channel ] ))
+      {
+        Sum += TC_WEIGHTS[ Channel ] * m_Reading[ Channel ];
+        Weights += TC_WEIGHTS[ Channel ];
+      }
+#endif
+    }
+
+    if (Available == 0)
+      m_Estimate[ Role ] = NAN;
+#if (TC_FUSION != TC_FUSION_KALMAN)
+    else if (Weights > 0.0)
+      m_Estimate[ Role ] = Sum / Weights;
+#endif
+  }
+}
+
+
+float VLOvenShield::readTC( uint8_t Source )
+{
+  float Result;
+
+  if (Source < TC_CHANNELS)
+    return m_Reading[ Source ];
+
+  if ((Source == TC_SOURCE_AIR) || (Source == TC_SOURCE_PCB))
+  {
+    Result = m_Estimate[ Source - TC_SOURCE_AIR ];
+
+    // No sensor for the requested estimate, the other one is the best guess.
+    if (isnan( Result ))
+      Result = m_Estimate[ TC_SOURCE_PCB - Source ];
+    return Result;
+  }
+
+  return NAN;
 }
 
+
+void VLOvenShield::setAveragingSamples( uint8_t Samples )
+{
+  for (uint8_t Channel = 0; Channel < TC_CHANNELS; Channel++)
+  {
+    if (TC_TYPES[ Channel ] == TC_TYPE_ANALOG)
+      m_Average[ Channel ].setLength( Samples );
+  }
+}
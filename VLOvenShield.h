@@ -26,8 +26,11 @@
 #include <PinChangeInt.h>
 #include <GPIOKey.h>
 #include <GPIOLed.h>
-#include <GPIOToggler.h>
-#include "RunningAverage.h"
+#include "VLOvenStatistics.h"
+#include "VLOvenSSR.h"
+#include "VLOvenMAX31855.h"
+#include "VLOvenThermocouple.h"
+#include "VLOvenSafety.h"
 
 
 
@@ -42,11 +45,15 @@
 
 #define AD_READINGMASK          0         /*!< \brief Number of bits to mask from the resulting digital ADC reading. */
 
-#define LINE_FREQUENCY          50
-#define TEMP_SAMPLING_TIME      10
-#define TEMP_AVERAGING_SAMPLES  100       /*!< \brief Number of temperature sensor reading samples to average. */
+#define LINE_FREQUENCY          50        /*!< \brief Mains frequency in Hz, the SSR is fired in whole mains half-cycles. */
+#define TEMP_SAMPLING_TIME      10        /*!< \brief Periode in <b>ms</b> for scanning all the temperature sensor channels. */
+#define TEMP_AVERAGING_SAMPLES  100       /*!< \brief Default, and highest, number of analog temperature sensor reading samples to average. */
+#define TC_SPI_AVERAGING_SAMPLES 4        /*!< \brief Number of SPI converter reading samples to average, they come once per conversion time. */
+#define TC_AVERAGING_CAPACITY   TEMP_AVERAGING_SAMPLES  /*!< \brief Averaging buffer size per sensor channel, may go down to #TC_SPI_AVERAGING_SAMPLES when no channel is analog. */
+#define TC_AVERAGING_OPTIONS    0         /*!< \brief \c STATISTICS_xxx options of the sensor channels averaging, each one takes 4 bytes per buffer element. */
 
 #define PORT_TEMP_SONDE         A0        /*!< \brief Pin connected to the temperature sonde amplifier's output. */
+//#define PORT_TEMP_SONDE2      A1        /*!< \brief Pin connected to the second temperature sonde amplifier's output. */
 #define PORT_LCD_PIN_DB7        A2        /*!< \brief LCD data bus bit 7. */
 #define PORT_LCD_PIN_DB6        A3        /*!< \brief LCD data bus bit 6. */
 #define PORT_LCD_PIN_DB5        A4        /*!< \brief LCD data bus bit 5. */
@@ -61,12 +68,83 @@
 #define PIN_KEY_UP              7         /*!< \brief Input pin for the UP key switch. */
 #define PIN_KEY_DOWN            6         /*!< \brief Input pin for the DOWN key switch. */
 
-#define PIN_LED1                9         /*!< \brief Output pin for the status indicator LED (1) */
+/* Pins 9 and 10 are the Timer1 outputs OC1A and OC1B. Timer1 runs in CTC mode stepping the SSR (see #begin()), so
+ * both pins are only switched with digitalWrite(), analogWrite() on them would not produce any PWM. */
+#define PIN_LED1                9         /*!< \brief Output pin for the status indicator LED (1), on/off only. */
 //#define PIN_LED2              10        /*!< \brief Output pin for the status indicator LED (2). */
 
-#define PIN_SSR                 10        /*!< \brief Output pin for the SSR control input. */
+#define PIN_SSR                 10        /*!< \brief Output pin for the SSR control input, switched by the Timer1 interrupt. */
+//#define PIN_SSR2              A1        /*!< \brief Output pin for the second heater element SSR control input. */
+//#define PIN_FAN               13        /*!< \brief Optional output pin for the convection fan SSR control input. */
+//#define PIN_COOLER            A1        /*!< \brief Optional output pin for the cooling actuator, an exhaust fan or a door opening solenoid. */
+/* Without #PIN_ZEROCROSS the half-cycles are timed by Timer1 alone and are not aligned to the mains, the SSR
+ * switches anywhere in the half-cycle and the timer slowly drifts from the line frequency. Zero-cross SSRs hide it. */
+//#define PIN_ZEROCROSS         11        /*!< \brief Optional input pin for the mains zero-cross detector. */
+/*! \brief Comma separated list of input pins profile exit rules may read, configured with their pull-up enabled.
+ * No pin taken by another function may be listed, SPI converters take pin 12. */
+#define EXIT_INPUT_PINS         12
 
-#define HEATER_PERIODE          250       /*!< \brief Periode for SSR duty cicle control. */
+/*! \brief Number of independent heater channels (zones). 
+ * For ovens with separate top and bottom elements set it to \c 2 and list both SSR pins in #HEATER_CHANNEL_PINS. */
+#define HEATER_CHANNELS         1
+#define HEATER_CHANNEL_PINS     PIN_SSR   /*!< \brief Comma separated list of SSR output pins, one per heater channel. */
+#define HEATER_CHANNEL_SENSORS  TC_SOURCE_CONTROL /*!< \brief Comma separated list of temperature sources regulating each heater channel. */
+
+/* The sensor channels may be given on the build command line instead, the host tests run on mock converters. */
+#if !defined(TC_CHANNELS)
+# define TC_CHANNELS            1         /*!< \brief Number of temperature sensor channels, up to \c 8. */
+# define TC_CHANNEL_PINS        PORT_TEMP_SONDE /*!< \brief Comma separated list of analog inputs or converter chip select pins, one per sensor channel. */
+/*! \brief Comma separated list of sensor channel front-ends, #TC_TYPE_ANALOG or one of the \c TC_DEVICE_xxx converter types.
+ * SPI converters take pins 11 to 13, so #PIN_FAN and #PIN_ZEROCROSS must be moved elsewhere when using them. */
+# define TC_CHANNEL_TYPES       TC_TYPE_ANALOG
+# define TC_CHANNEL_ROLES       TC_ROLE_AIR     /*!< \brief Comma separated list of sensor channel roles, see #TC_ROLE_AIR and #TC_ROLE_PCB. */
+# define TC_CHANNEL_WEIGHTS     1.0       /*!< \brief Comma separated list of sensor channel weights (inverse relative noise variance). */
+#endif
+
+#define TC_TYPE_ANALOG          0x10      /*!< \brief Sensor front-end: type K thermocouple amplifier connected to an analog input. */
+
+/*! \brief Analog thermocouple amplifier gain.
+ * The default matches the AD8495 (about 5 mV/C), which compensates the cold junction itself. */
+#define TC_AMPLIFIER_GAIN       (122.4)
+//#define TC_COLD_JUNCTION_PIN  A1        /*!< \brief Optional analog input for a cold junction sensor, for amplifiers without cold junction compensation. */
+#define TC_COLD_JUNCTION_SCALE  (10.0)    /*!< \brief Cold junction sensor output in mV per degree C, \c 10.0 for a LM35. */
+
+/*! \brief Thermocouple voltage per ADC count in uV, 16.16 fixed point. */
+#define TC_VOLTAGE_SCALE        ((int32_t)(ADC_REFVOLTAGE * 1e6 * 65536.0 / ADC_FULLSCALE / TC_AMPLIFIER_GAIN + 0.5))
+/*! \brief Cold junction temperature per ADC count in 1/100 degrees C, 16.16 fixed point. */
+#define TC_COLD_JUNCTION_COUNTS ((int32_t)(ADC_REFVOLTAGE * 1e5 * 65536.0 / ADC_FULLSCALE / TC_COLD_JUNCTION_SCALE + 0.5))
+
+#define TC_ROLE_AIR             0         /*!< \brief The sensor measures the oven air temperature. */
+#define TC_ROLE_PCB             1         /*!< \brief The sensor is attached to the board being processed. */
+
+#define TC_SOURCE_AIR           0x80      /*!< \brief Temperature source: fused oven air temperature estimate. */
+#define TC_SOURCE_PCB           0x81      /*!< \brief Temperature source: fused board temperature estimate, falls back to air when no board sensor is available. */
+#define TC_SOURCE_CONTROL       TC_SOURCE_PCB   /*!< \brief Temperature source the controller regulates on. */
+
+#define TC_FUSION_WEIGHTED      0         /*!< \brief Sensor fusion: weighted average of the channel readings. */
+#define TC_FUSION_KALMAN        1         /*!< \brief Sensor fusion: scalar Kalman filter over the channel samples. */
+#define TC_FUSION               TC_FUSION_WEIGHTED  /*!< \brief Sensor fusion combiner. */
+#define TC_KALMAN_PROCESS_NOISE (0.01)    /*!< \brief Kalman combiner temperature variance growth per scan, in degrees C squared. */
+#define TC_KALMAN_SENSOR_NOISE  (4.0)     /*!< \brief Kalman combiner measurement variance for a weight \c 1.0 channel, in degrees C squared. */
+
+#define TC_VALID_MIN_COUNTS     2         /*!< \brief Lowest ADC reading accepted as valid, lower values mean a shorted sensor. */
+#define TC_VALID_MAX_COUNTS     (ADC_FULLSCALE - 1) /*!< \brief Highest ADC reading accepted as valid, higher values mean an open or over range sensor. */
+/*! \brief Consecutive invalid readings before a sensor channel is rejected.
+ * The MAX31855 reports spurious fault frames on noisy lines while the SSR switches, single ones must not stop a run.
+ * Until then the channel holds its last average, for up to 100 ms on analog channels and 1 s on converter channels. */
+#define TC_FAULT_SAMPLES        10
+
+/*! \brief Total heater power budget, in percent of one heater element full power.
+ * When the heater channels together request more than this, all of them are scaled down proportionally. */
+#define HEATER_POWER_BUDGET     (100.0 * HEATER_CHANNELS)
+
+/*! \brief Timer1 compare value for one mains half-cycle (prescaler 8).
+ * With a zero-cross detector the timer just backs up missing detector pulses, so its periode is made 25% longer. */
+#if defined(PIN_ZEROCROSS)
+# define HALFCYCLE_TIMER_COUNT  ((F_CPU / 8UL / (2UL * LINE_FREQUENCY)) * 5UL / 4UL - 1UL)
+#else
+# define HALFCYCLE_TIMER_COUNT  (F_CPU / 8UL / (2UL * LINE_FREQUENCY) - 1UL)
+#endif
 
 
 /*! 
@@ -89,6 +167,12 @@ typedef enum {
 } PressedKeyCode_t;
 
 
+/*!
+ * \brief Temperature sensor channel samples statistics.
+*/
+typedef VLOvenStatistics<float, TC_AVERAGING_CAPACITY, TC_AVERAGING_OPTIONS> VLOvenChannelAverage_t;
+
+
 /*!
  * \brief Oven controller shield hardware abstraction.
  * This class creates the abstraction layer for accessing the oven controller shield from the application.
@@ -100,6 +184,13 @@ class VLOvenShield
      * \brief Constructor.
     */
     VLOvenShield();
+
+    /*!
+     * \brief Instance initialization method. Should be called once at startup from function #setup().
+     * \remarks Configures Timer1 for stepping the SSR once per mains half-cycle. The timer can't be
+     * configured from the constructor, as the Arduino core initialization reprograms it afterwards.
+    */
+    void begin();
     
     /*!
      * \brief Method for accessing the LCD control instance.
@@ -121,18 +212,114 @@ class VLOvenShield
 
     /*!
      * \brief Temperature sensor reading function.
-     * \return Returns the temperature measurement result. Results are expected in Degree Celsius.
+     * \param Source Sensor channel index, from \c 0 to #TC_CHANNELS - 1, or one of the fused estimates #TC_SOURCE_AIR
+     * and #TC_SOURCE_PCB.
+     * \return Returns the temperature measurement result. Results are expected in Degree Celsius. The function returns
+     * \c NAN for rejected sensor channels and when no sensor is available for the requested estimate.
+    */
+    float readTC( uint8_t Source = TC_SOURCE_CONTROL );
+
+    /*!
+     * \brief Get the rejected sensor channels.
+     * \return Returns a bit mask with one bit set for every sensor channel currently rejected as failed.
+    */
+    uint8_t getFailedChannels() { return m_FailedChannels; }
+
+    /*!
+     * \brief Change the number of analog temperature sensor reading samples to average.
+     * \param Samples Number of samples, from \c 1 to #TEMP_AVERAGING_SAMPLES.
+     * \remarks The averages of the analog channels go on with the newest samples, it may change at any time.
+    */
+    void setAveragingSamples( uint8_t Samples );
+
+    /*!
+     * \brief Get the latest fault detected on a sensor channel.
+     * \param Channel Sensor channel index, from \c 0 to #TC_CHANNELS - 1.
+     * \return Returns the \c TC_FAULT_xxx flags from the latest sample, \c TC_FAULT_NONE for a valid sample.
     */
-    float readTC();
+    uint8_t getChannelFault( uint8_t Channel ) { return (Channel < TC_CHANNELS) ? m_Fault[ Channel ] : TC_FAULT_NONE; }
+
+    /*!
+     * \brief Method for accessing a sensor channel converter driver instance.
+     * \param Channel Sensor channel index, from \c 0 to #TC_CHANNELS - 1.
+     * \return Returns the driver instance, or \c NULL for analog channels.
+    */
+    VLOvenMAX31855* getConverter( uint8_t Channel );
+
+    /*!
+     * \brief Get the statistics of the valid samples of a temperature sensor channel.
+     * Sliding min, max and median are available when enabled through #TC_AVERAGING_OPTIONS.
+     * \param Channel Sensor channel index, from \c 0 to #TC_CHANNELS - 1.
+    */
+    const VLOvenChannelAverage_t& getChannelAverage( uint8_t Channel ) { return m_Average[ Channel ]; }
+
+    /*!
+     * \brief External input reading function.
+     * \param Pin Input pin, one of #EXIT_INPUT_PINS.
+     * \return Returns \c true while the input is pulled low, always \c false for a pin not in #EXIT_INPUT_PINS.
+    */
+    bool readInput( uint8_t Pin );
+
+    /*!
+     * \brief Check whether a pin may be read by #readInput().
+     * \param Pin Pin number.
+     * \return Returns \c true when the pin is one of #EXIT_INPUT_PINS.
+    */
+    static bool isInputPin( uint8_t Pin );
+
+    /*!
+     * \brief Method for accessing the safety supervisor instance.
+     * \return Returns a reference to the safety supervisor checking every acquisition pass.
+    */
+    VLOvenSafety& getSafety() { return m_Safety; }
 
     /*!
      * \brief Heater SSR duty cycle control.
      * This functions controls the activation, deactivation and duty cycle of the SSR controlling the heater.
      * \b Minimum value \c 0.0 disables the heater. \b Maximum value \c 100.0 puts the heater in \b ON mode. 
      * Any value above \c 0.0 and below \c 100.0 activates the heater with the corresponding duty cycle.
+     * The heater is fired in whole mains half-cycles evenly distributed over time (burst-fire).
+     * While the safety supervisor has a fault latched the heater stays disabled.
+     * \param Channel Heater channel index, from \c 0 to #HEATER_CHANNELS - 1.
+     * \param Duty Duty cycle in percent.
+    */
+    void setHeaterDuty( uint8_t Channel, double Duty );
+
+    /*!
+     * \brief Duty cycle control for all heater channels at once.
+     * \param Duty Duty cycle in percent, see #setHeaterDuty(uint8_t,double).
     */
     void setHeaterDuty( double Duty );
 
+    /*!
+     * \brief Get the duty cycle applied to a heater channel.
+     * \param Channel Heater channel index, from \c 0 to #HEATER_CHANNELS - 1.
+     * \return Returns the duty cycle in percent.
+    */
+    double getHeaterDuty( uint8_t Channel ) { return m_SSR[ Channel ].getDutyCycle(); }
+
+    /*!
+     * \brief Convection fan control.
+     * \param Duty Fan duty cycle in percent, \c 0.0 stops the fan.
+     * \remarks Does nothing when #PIN_FAN is not defined.
+    */
+    void setFanDuty( double Duty );
+
+    /*!
+     * \brief Cooling actuator control.
+     * The actuator is driven like the heaters, in whole mains half-cycles, so an exhaust fan or a solenoid
+     * pulling the door open get a proportional share of the time.
+     * \param Duty Cooling actuator duty cycle in percent, \c 0.0 stops it.
+     * \remarks Does nothing when #PIN_COOLER is not defined.
+    */
+    void setCoolerDuty( double Duty );
+
+    /*!
+     * \brief Get the cooling actuator duty cycle.
+     * \return Returns the cooling actuator duty cycle in percent, always \c 0.0 when #PIN_COOLER is not defined.
+    */
+    double getCoolerDuty();
+
     /*!
      * \brief Method for accessing the Led (1) indicator control instance.
      * \return Returns a reference to the instance of the class that controls the Led indicator (1).
@@ -150,12 +337,45 @@ class VLOvenShield
     GPIOLed m_Led1;                 /*!< \brief Led (1) managing instance. */
     //GPIOLed m_Led2;                 /*!< \brief Led (2) managing instance. */
     LiquidCrystal m_Lcd;            /*!< \brief LCD managing instance. */
-    GPIOToggler m_SSR;              /*!< \brief SSR managing instance. */
-    unsigned long m_TempSampleTime;
-    long m_TempAccumulator;
-    int m_TempSamplesCount;
-    float m_TempSample;
-    RunningAverage m_Average;
+    VLOvenSSR m_SSR[ HEATER_CHANNELS ];   /*!< \brief Heater channels SSR managing instances. */
+#if defined(PIN_FAN)
+    VLOvenSSR m_Fan;                /*!< \brief Convection fan SSR managing instance. */
+#endif
+#if defined(PIN_COOLER)
+    VLOvenSSR m_Cooler;             /*!< \brief Cooling actuator managing instance. */
+#endif
+    unsigned long m_TempSampleTime;                 /*!< \brief Time of previous sensor channels scan start. */
+    VLOvenChannelAverage_t m_Average[ TC_CHANNELS ];  /*!< \brief Readings averaging, one instance per sensor channel. */
+    VLOvenMAX31855 m_Converter[ TC_CHANNELS ];      /*!< \brief SPI converter drivers, unused for analog channels. */
+    float m_Sample[ TC_CHANNELS ];                  /*!< \brief Latest sample per sensor channel, \c NAN when invalid. */
+    float m_Reading[ TC_CHANNELS ];                 /*!< \brief Averaged reading per sensor channel, \c NAN when rejected. */
+    uint8_t m_FaultSamples[ TC_CHANNELS ];          /*!< \brief Consecutive invalid samples count per sensor channel. */
+    uint8_t m_Fault[ TC_CHANNELS ];                 /*!< \brief Latest sample fault flags per sensor channel. */
+    uint8_t m_FailedChannels;                       /*!< \brief Rejected sensor channels bit mask. */
+    float m_Estimate[ 2 ];                          /*!< \brief Fused temperature estimates, indexed by sensor role. */
+    float m_Variance[ 2 ];                          /*!< \brief Kalman combiner estimate variances, indexed by sensor role. */
+    VLOvenSafety m_Safety;                          /*!< \brief Safety supervisor. */
+
+    /*!
+     * \brief Start one acquisition pass converting all the sensor channels back to back.
+    */
+    void startScan();
+
+    /*!
+     * \brief Process the results from a completed acquisition pass.
+    */
+    void processScan();
+
+    /*!
+     * \brief Get the heater power feeding the mock converter oven model.
+     * \return Returns the mean heater channels duty cycle in percent.
+    */
+    double getHeaterPower();
+
+    /*!
+     * \brief Fuse the sensor channel readings into the air and board temperature estimates.
+    */
+    void fuse();
 };
 
 
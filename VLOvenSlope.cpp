@@ -0,0 +1,75 @@
+/*! \file
+ *  \brief Temperature slope estimator.
+ *  This file implements the class methods for the temperature slope estimator.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "VLOvenSlope.h"
+
+
+#define SLOPE_SUM_X     ((int32_t)SLOPE_WINDOW_SAMPLES * (SLOPE_WINDOW_SAMPLES - 1) / 2)      /*!< \brief Sum of the sample positions. */
+#define SLOPE_SUM_XX    ((int32_t)SLOPE_WINDOW_SAMPLES * (SLOPE_WINDOW_SAMPLES - 1) * (2 * SLOPE_WINDOW_SAMPLES - 1) / 6) /*!< \brief Sum of the squared sample positions. */
+#define SLOPE_DIVISOR   ((int32_t)SLOPE_WINDOW_SAMPLES * SLOPE_SUM_XX - SLOPE_SUM_X * SLOPE_SUM_X)  /*!< \brief Least squares slope divisor. */
+
+
+VLOvenSlope::VLOvenSlope( unsigned int SampleTime ) :
+  m_SampleTime( SampleTime )
+{
+  clear();
+}
+
+
+void VLOvenSlope::clear()
+{
+  m_Index = 0;
+  m_Count = 0;
+  m_Sum = 0;
+  m_WeightedSum = 0;
+}
+
+
+void VLOvenSlope::addSample( int16_t Temp )
+{
+  if (m_Count < SLOPE_WINDOW_SAMPLES)
+  {
+    m_WeightedSum += (int32_t)m_Count * Temp;
+    m_Count++;
+  }
+  else
+  {
+    // Every sample moves one position back, which takes the plain sum off the
+    // weighted sum. The oldest one was at position 0 and goes away.
+    m_Sum -= m_Samples[ m_Index ];
+    m_WeightedSum -= m_Sum;
+    m_WeightedSum += (int32_t)(SLOPE_WINDOW_SAMPLES - 1) * Temp;
+  }
+
+  m_Sum += Temp;
+  m_Samples[ m_Index ] = Temp;
+  if (++m_Index >= SLOPE_WINDOW_SAMPLES)
+    m_Index = 0;
+}
+
+
+int16_t VLOvenSlope::getSlope() const
+{
+  int32_t Numerator;
+
+  if (!isValid())
+    return 0;
+
+  Numerator = SLOPE_WINDOW_SAMPLES * m_WeightedSum - SLOPE_SUM_X * m_Sum;
+  return (int16_t)lround( (float)Numerator * (1000.0 / (float)m_SampleTime) / (float)SLOPE_DIVISOR );
+}
@@ -0,0 +1,77 @@
+/*! \file
+ *  \brief Temperature slope estimator.
+ *  This file declares the class estimating the measured temperature rate of change.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenSlope_h_
+#define  _VLOvenSlope_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define SLOPE_WINDOW_SAMPLES    (20)      /*!< \brief Number of samples in the regression window. */
+
+
+/*!
+ * \brief Temperature slope estimator.
+ * Least squares line fit over a sliding window of equally spaced temperature samples. The sums the fit
+ * needs are updated incrementally in integer math, so each sample costs a constant time and the sums
+ * never drift, however long the estimator runs.
+*/
+class VLOvenSlope
+{
+  public:
+    /*!
+     * \brief Constructor.
+     * \param SampleTime Time between samples in <b>ms</b>.
+    */
+    VLOvenSlope( unsigned int SampleTime );
+
+    /*!
+     * \brief Discard all the samples.
+    */
+    void clear();
+
+    /*!
+     * \brief Add a new sample, dropping the oldest one once the window is full.
+     * \param Temp Temperature in 1/100 degrees C.
+    */
+    void addSample( int16_t Temp );
+
+    /*!
+     * \brief Check whether the window is full.
+     * \return Returns \c true when the estimate covers a whole window.
+    */
+    bool isValid() const { return m_Count == SLOPE_WINDOW_SAMPLES; }
+
+    /*!
+     * \brief Get the estimated slope.
+     * \return Returns the slope in 1/100 degrees C per second, \c 0 until the window is full.
+    */
+    int16_t getSlope() const;
+
+  private:
+    unsigned int m_SampleTime;                    /*!< \brief Time between samples in ms. */
+    int16_t m_Samples[ SLOPE_WINDOW_SAMPLES ];    /*!< \brief Sample ring buffer. */
+    uint8_t m_Index;                              /*!< \brief Ring buffer slot for the next sample. */
+    uint8_t m_Count;                              /*!< \brief Number of samples in the window. */
+    int32_t m_Sum;                                /*!< \brief Sum of the samples. */
+    int32_t m_WeightedSum;                        /*!< \brief Sum of the samples weighted by their position, oldest at \c 0. */
+};
+
+
+#endif  /* _VLOvenSlope_h_ */
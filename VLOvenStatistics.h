@@ -0,0 +1,482 @@
+/*! \file
+ *  \brief Sliding window statistics.
+ *  This file declares and implements the class template keeping the statistics of the last values of a series.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenStatistics_h_
+#define  _VLOvenStatistics_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+#include <math.h>
+
+
+#define STATISTICS_MINMAX       0x01      /*!< \brief Option: O(1) sliding min and max, 4 bytes per element. */
+#define STATISTICS_MEDIAN       0x02      /*!< \brief Option: O(log N) sliding median, 4 bytes per element. */
+
+
+/*!
+ * \brief Sliding window statistics.
+ * Ring buffer with static storage keeping the mean, variance and optionally the min, max and median of the last
+ * values added. The window length can change at any time up to the buffer capacity.
+ *
+ * Mean and variance are updated with each value (Welford), reading them is O(1). The sum behind the mean is
+ * Kahan compensated, but taking the old values out still leaves rounding errors behind. So a second, add-only
+ * sum and M2 are built from the values added since the last resync, and replace the sliding ones each time they
+ * cover the whole window: the error stays bounded however long the run, without any O(N) pass.
+ *
+ * With #STATISTICS_MINMAX the min and max come from two monotonic deques of buffer positions, amortised O(1) per
+ * value. With #STATISTICS_MEDIAN a max-heap of the lower half and a min-heap of the upper half are kept, each
+ * position knowing its heap slot so the element leaving the window is taken out in O(log N).
+ *
+ * \tparam T Element type.
+ * \tparam CAPACITY Largest window length.
+ * \tparam OPTIONS \c STATISTICS_xxx options, each one takes extra RAM.
+*/
+template <typename T, uint16_t CAPACITY, uint8_t OPTIONS = 0>
+class VLOvenStatistics
+{
+  public:
+    /*!
+     * \brief Constructor.
+     * \param Length Window length, from 1 to \a CAPACITY.
+    */
+    explicit VLOvenStatistics( uint16_t Length = CAPACITY )
+    {
+      m_Length = (Length == 0) ? 1 : min( Length, CAPACITY );
+      clear();
+    }
+
+    /*!
+     * \brief Discard all the values.
+    */
+    void clear()
+    {
+      m_Count = 0;
+      m_Index = 0;
+      m_Sum = m_SumError = 0.0;
+      m_M2 = 0.0;
+      m_FreshCount = 0;
+      m_MinHead = m_MinCount = 0;
+      m_MaxHead = m_MaxCount = 0;
+      m_LowCount = m_HighCount = 0;
+    }
+
+    /*!
+     * \brief Add a new value, dropping the oldest one once the window is full.
+     * \param Value Value to add.
+    */
+    void addValue( T Value )
+    {
+      double Previous = (m_Count == 0) ? 0.0 : mean();
+
+      if (m_Count < m_Length)
+      {
+        m_Count++;
+        kahanAdd( m_Sum, m_SumError, Value );
+        m_M2 += (Value - Previous) * (Value - mean());
+      }
+      else
+      {
+        uint16_t Position = oldest();
+        T Old = m_Buffer[ Position ];
+
+        kahanAdd( m_Sum, m_SumError, Value );
+        kahanAdd( m_Sum, m_SumError, -(double)Old );
+        m_M2 += ((double)Value - Old) * ((Value - mean()) + (Old - Previous));
+        if (m_M2 < 0.0)
+          m_M2 = 0.0;
+        forget( Position );
+      }
+      resync( Value );
+      m_Buffer[ m_Index ] = Value;
+      remember( m_Index );
+      if (++m_Index == CAPACITY)
+        m_Index = 0;
+    }
+
+    /*!
+     * \brief Discard all the values and add the same value several times.
+     * \param Value Value to add.
+     * \param Number Number of times to add it.
+    */
+    void fillValue( T Value, uint16_t Number )
+    {
+      clear();
+      for (uint16_t Index = 0; Index < Number; Index++)
+        addValue( Value );
+    }
+
+    /*!
+     * \brief Change the window length, keeping the newest values.
+     * \param Length Window length, from 1 to \a CAPACITY.
+    */
+    void setLength( uint16_t Length )
+    {
+      m_Length = (Length == 0) ? 1 : min( Length, CAPACITY );
+      if (m_Count <= m_Length)
+        return;
+
+      while (m_Count > m_Length)
+      {
+        forget( oldest() );
+        m_Count--;
+      }
+
+      // the dropped values cannot be taken out one by one, start over from the ones left
+      m_FreshCount = 0;
+      for (uint16_t Index = 0; Index < m_Count; Index++)
+        resync( getElement( Index ) );
+    }
+
+    /*!
+     * \brief Get the window length.
+     * \return Returns the largest number of values held.
+    */
+    uint16_t getLength() const { return m_Length; }
+
+    /*!
+     * \brief Get the number of values held.
+     * \return Returns the number of values, up to the window length.
+    */
+    uint16_t getCount() const { return m_Count; }
+
+    /*!
+     * \brief Get the buffer capacity.
+     * \return Returns the largest window length.
+    */
+    static uint16_t getCapacity() { return CAPACITY; }
+
+    /*!
+     * \brief Get the mean of the values held.
+     * \return Returns the mean, \c NAN when there are no values.
+    */
+    double getAverage() const { return (m_Count == 0) ? NAN : mean(); }
+
+    /*!
+     * \brief Get the sample variance of the values held.
+     * \return Returns the variance, \c NAN with less than 2 values.
+    */
+    double getVariance() const { return (m_Count < 2) ? NAN : m_M2 / (m_Count - 1); }
+
+    /*!
+     * \brief Get the sample standard deviation of the values held.
+     * \return Returns the standard deviation, \c NAN with less than 2 values.
+    */
+    double getStandardDeviation() const { return sqrt( getVariance() ); }
+
+    /*!
+     * \brief Get the smallest value held.
+     * O(1) with #STATISTICS_MINMAX, a scan of the window otherwise.
+     * \return Returns the min, \c NAN when there are no values.
+    */
+    double getMin() const
+    {
+      if (m_Count == 0)
+        return NAN;
+      if (OPTIONS & STATISTICS_MINMAX)
+        return m_Buffer[ m_MinQueue[ m_MinHead ] ];
+
+      T Min = getElement( 0 );
+      for (uint16_t Index = 1; Index < m_Count; Index++)
+        if (Min > getElement( Index ))
+          Min = getElement( Index );
+      return Min;
+    }
+
+    /*!
+     * \brief Get the largest value held.
+     * O(1) with #STATISTICS_MINMAX, a scan of the window otherwise.
+     * \return Returns the max, \c NAN when there are no values.
+    */
+    double getMax() const
+    {
+      if (m_Count == 0)
+        return NAN;
+      if (OPTIONS & STATISTICS_MINMAX)
+        return m_Buffer[ m_MaxQueue[ m_MaxHead ] ];
+
+      T Max = getElement( 0 );
+      for (uint16_t Index = 1; Index < m_Count; Index++)
+        if (Max < getElement( Index ))
+          Max = getElement( Index );
+      return Max;
+    }
+
+    /*!
+     * \brief Get the median of the values held.
+     * \return Returns the median, \c NAN when there are no values or without #STATISTICS_MEDIAN.
+    */
+    double getMedian() const
+    {
+      if (!(OPTIONS & STATISTICS_MEDIAN) || (m_Count == 0))
+        return NAN;
+      if (m_LowCount > m_HighCount)
+        return m_Buffer[ heapAt( 0, 0 ) ];
+      return ((double)m_Buffer[ heapAt( 0, 0 ) ] + m_Buffer[ heapAt( 1, 0 ) ]) / 2;
+    }
+
+    /*!
+     * \brief Get a value held.
+     * \param Index Value index, \c 0 being the oldest one.
+     * \return Returns the value.
+    */
+    T getElement( uint16_t Index ) const
+    {
+      uint16_t Position = oldest() + Index;
+
+      if (Position >= CAPACITY)
+        Position -= CAPACITY;
+      return m_Buffer[ Position ];
+    }
+
+  private:
+    static const uint16_t MINMAX_SIZE = (OPTIONS & STATISTICS_MINMAX) ? CAPACITY : 1;   /*!< \brief Size of the min and max deques. */
+    static const uint16_t MEDIAN_SIZE = (OPTIONS & STATISTICS_MEDIAN) ? CAPACITY : 1;   /*!< \brief Size of the median heaps. */
+
+    T m_Buffer[ CAPACITY ];             /*!< \brief Value ring buffer. */
+    uint16_t m_Length;                  /*!< \brief Window length. */
+    uint16_t m_Count;                   /*!< \brief Number of values held. */
+    uint16_t m_Index;                   /*!< \brief Ring buffer position for the next value. */
+    double m_Sum;                       /*!< \brief Kahan sum of the values held. */
+    double m_SumError;                  /*!< \brief Kahan compensation of #m_Sum. */
+    double m_M2;                        /*!< \brief Sum of the squared differences from the mean. */
+
+    uint16_t m_FreshCount;              /*!< \brief Number of values added since the last resync. */
+    double m_FreshSum;                  /*!< \brief Kahan sum of the values added since the last resync. */
+    double m_FreshSumError;             /*!< \brief Kahan compensation of #m_FreshSum. */
+    double m_FreshMean;                 /*!< \brief Mean of the values added since the last resync. */
+    double m_FreshM2;                   /*!< \brief M2 of the values added since the last resync. */
+
+    uint16_t m_MinQueue[ MINMAX_SIZE ]; /*!< \brief Deque of positions with increasing values, the front is the oldest one. */
+    uint16_t m_MaxQueue[ MINMAX_SIZE ]; /*!< \brief Deque of positions with decreasing values, the front is the oldest one. */
+    uint16_t m_MinHead;                 /*!< \brief Front of #m_MinQueue. */
+    uint16_t m_MinCount;                /*!< \brief Number of positions in #m_MinQueue. */
+    uint16_t m_MaxHead;                 /*!< \brief Front of #m_MaxQueue. */
+    uint16_t m_MaxCount;                /*!< \brief Number of positions in #m_MaxQueue. */
+
+    uint16_t m_Heap[ MEDIAN_SIZE ];     /*!< \brief Lower half max-heap from the start, upper half min-heap from the end. */
+    uint16_t m_Slot[ MEDIAN_SIZE ];     /*!< \brief Heap slot of each position, \a CAPACITY added for the upper half. */
+    uint16_t m_LowCount;                /*!< \brief Number of positions in the lower half heap. */
+    uint16_t m_HighCount;               /*!< \brief Number of positions in the upper half heap. */
+
+    /*! \brief Ring buffer position of the oldest value. */
+    uint16_t oldest() const { return (m_Index >= m_Count) ? m_Index - m_Count : m_Index + CAPACITY - m_Count; }
+
+    /*! \brief Mean of the values held, there must be some. */
+    double mean() const { return (m_Sum - m_SumError) / m_Count; }
+
+    /*!
+     * \brief Kahan compensated addition.
+     * \param Sum Sum to add to.
+     * \param Error Compensation of \a Sum.
+     * \param Value Value to add.
+    */
+    static void kahanAdd( double& Sum, double& Error, double Value )
+    {
+      double Corrected = Value - Error;
+      double Total = Sum + Corrected;
+
+      Error = (Total - Sum) - Corrected;
+      Sum = Total;
+    }
+
+    /*!
+     * \brief Add the newest value to the add-only statistics, and hand them over once they cover the window.
+     * \param Value Value added.
+    */
+    void resync( T Value )
+    {
+      double Delta;
+
+      if (m_FreshCount == 0)
+      {
+        m_FreshSum = m_FreshSumError = 0.0;
+        m_FreshMean = m_FreshM2 = 0.0;
+      }
+      m_FreshCount++;
+      kahanAdd( m_FreshSum, m_FreshSumError, Value );
+      Delta = Value - m_FreshMean;
+      m_FreshMean += Delta / m_FreshCount;
+      m_FreshM2 += Delta * (Value - m_FreshMean);
+      if (m_FreshCount < m_Count)
+        return;
+
+      m_Sum = m_FreshSum;
+      m_SumError = m_FreshSumError;
+      m_M2 = m_FreshM2;
+      m_FreshCount = 0;
+    }
+
+    /*!
+     * \brief Take the oldest value out of the optional statistics.
+     * \param Position Ring buffer position of the value.
+    */
+    void forget( uint16_t Position )
+    {
+      if (OPTIONS & STATISTICS_MINMAX)
+      {
+        if (m_MinQueue[ m_MinHead ] == Position)
+        {
+          m_MinHead = next( m_MinHead );
+          m_MinCount--;
+        }
+        if (m_MaxQueue[ m_MaxHead ] == Position)
+        {
+          m_MaxHead = next( m_MaxHead );
+          m_MaxCount--;
+        }
+      }
+      if (OPTIONS & STATISTICS_MEDIAN)
+      {
+        heapRemove( Position );
+        balance();
+      }
+    }
+
+    /*!
+     * \brief Put the newest value into the optional statistics.
+     * \param Position Ring buffer position of the value.
+    */
+    void remember( uint16_t Position )
+    {
+      if (OPTIONS & STATISTICS_MINMAX)
+      {
+        // values that can no longer be the min or max are dropped
+        while ((m_MinCount > 0) && !(m_Buffer[ m_MinQueue[ back( m_MinHead, m_MinCount ) ] ] < m_Buffer[ Position ]))
+          m_MinCount--;
+        m_MinQueue[ back( m_MinHead, ++m_MinCount ) ] = Position;
+        while ((m_MaxCount > 0) && !(m_Buffer[ m_MaxQueue[ back( m_MaxHead, m_MaxCount ) ] ] > m_Buffer[ Position ]))
+          m_MaxCount--;
+        m_MaxQueue[ back( m_MaxHead, ++m_MaxCount ) ] = Position;
+      }
+      if (OPTIONS & STATISTICS_MEDIAN)
+      {
+        uint8_t High = ((m_LowCount == 0) || !(m_Buffer[ Position ] > m_Buffer[ heapAt( 0, 0 ) ])) ? 0 : 1;
+        uint16_t Slot = High ? m_HighCount++ : m_LowCount++;
+
+        heapSet( High, Slot, Position );
+        heapUp( High, Slot );
+        balance();
+      }
+    }
+
+    /*! \brief Deque index following \a Index. */
+    static uint16_t next( uint16_t Index ) { return (Index + 1 == CAPACITY) ? 0 : Index + 1; }
+
+    /*! \brief Deque index of the last of \a Count positions starting at \a Head. */
+    static uint16_t back( uint16_t Head, uint16_t Count )
+    {
+      uint16_t Index = Head + Count - 1;
+
+      return (Index >= CAPACITY) ? Index - CAPACITY : Index;
+    }
+
+    /*! \brief Position in slot \a Slot of the lower (\a High \c 0) or upper (\a High \c 1) half heap. */
+    uint16_t heapAt( uint8_t High, uint16_t Slot ) const { return m_Heap[ High ? CAPACITY - 1 - Slot : Slot ]; }
+
+    /*! \brief Put \a Position in slot \a Slot of a heap. */
+    void heapSet( uint8_t High, uint16_t Slot, uint16_t Position )
+    {
+      m_Heap[ High ? CAPACITY - 1 - Slot : Slot ] = Position;
+      m_Slot[ Position ] = High ? CAPACITY + Slot : Slot;
+    }
+
+    /*! \brief Check whether slot \a Slot must be above slot \a Other in a heap. */
+    bool heapBefore( uint8_t High, uint16_t Slot, uint16_t Other ) const
+    {
+      return High ? (m_Buffer[ heapAt( High, Slot ) ] < m_Buffer[ heapAt( High, Other ) ])
+                  : (m_Buffer[ heapAt( High, Slot ) ] > m_Buffer[ heapAt( High, Other ) ]);
+    }
+
+    /*! \brief Swap two slots of a heap. */
+    void heapSwap( uint8_t High, uint16_t Slot, uint16_t Other )
+    {
+      uint16_t Position = heapAt( High, Slot );
+
+      heapSet( High, Slot, heapAt( High, Other ) );
+      heapSet( High, Other, Position );
+    }
+
+    /*! \brief Move a heap slot up to its place. */
+    void heapUp( uint8_t High, uint16_t Slot )
+    {
+      while ((Slot > 0) && heapBefore( High, Slot, (Slot - 1) / 2 ))
+      {
+        heapSwap( High, Slot, (Slot - 1) / 2 );
+        Slot = (Slot - 1) / 2;
+      }
+    }
+
+    /*! \brief Move a heap slot down to its place. */
+    void heapDown( uint8_t High, uint16_t Slot )
+    {
+      uint16_t Count = High ? m_HighCount : m_LowCount;
+
+      for (;;)
+      {
+        uint16_t Top = Slot;
+        uint16_t Child = 2 * Slot + 1;
+
+        if ((Child < Count) && heapBefore( High, Child, Top ))
+          Top = Child;
+        if ((Child + 1 < Count) && heapBefore( High, Child + 1, Top ))
+          Top = Child + 1;
+        if (Top == Slot)
+          return;
+        heapSwap( High, Slot, Top );
+        Slot = Top;
+      }
+    }
+
+    /*! \brief Take \a Position out of its heap. */
+    void heapRemove( uint16_t Position )
+    {
+      uint8_t High = (m_Slot[ Position ] >= CAPACITY) ? 1 : 0;
+      uint16_t Slot = High ? m_Slot[ Position ] - CAPACITY : m_Slot[ Position ];
+      uint16_t Last = High ? --m_HighCount : --m_LowCount;
+
+      if (Slot == Last)
+        return;
+      heapSet( High, Slot, heapAt( High, Last ) );
+      heapUp( High, Slot );
+      heapDown( High, Slot );
+    }
+
+    /*! \brief Balance the heaps, the lower half holds the extra value of an odd count. */
+    void balance()
+    {
+      while (m_LowCount > m_HighCount + 1)
+      {
+        uint16_t Position = heapAt( 0, 0 );
+
+        heapRemove( Position );
+        heapSet( 1, m_HighCount, Position );
+        heapUp( 1, m_HighCount++ );
+      }
+      while (m_HighCount > m_LowCount)
+      {
+        uint16_t Position = heapAt( 1, 0 );
+
+        heapRemove( Position );
+        heapSet( 0, m_LowCount, Position );
+        heapUp( 0, m_LowCount++ );
+      }
+    }
+};
+
+
+#endif  /* _VLOvenStatistics_h_ */
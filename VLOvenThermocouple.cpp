@@ -0,0 +1,84 @@
+/*! \file
+ *  \brief Type K thermocouple linearisation.
+ *  This file implements the functions converting between type K thermocouple voltages and temperatures.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "VLOvenThermocouple.h"
+#include <avr/pgmspace.h>
+
+
+/*!
+ * \brief Type K thermocouple voltages in uV, from #TYPEK_TABLE_MIN every #TYPEK_TABLE_STEP degrees C.
+ * Values from the NIST ITS-90 reference functions. Linear interpolation between entries stays within 0.04 degrees C.
+*/
+static const int16_t TYPEK_TABLE[ TYPEK_TABLE_SIZE ] PROGMEM =
+{
+  -1889, -1527, -1156,  -778,  -392,     0,   397,   798,  1203,  1612,
+   2023,  2436,  2851,  3267,  3682,  4096,  4509,  4920,  5328,  5735,
+   6138,  6540,  6941,  7340,  7739,  8138,  8539,  8940,  9343,  9747,
+  10153, 10561, 10971, 11382, 11795, 12209, 12624, 13040, 13457, 13874,
+  14293, 14713, 15133, 15554, 15975, 16397
+};
+
+
+/*!
+ * \brief Read a table entry from program memory.
+ * \param Index Table entry index.
+ * \return Returns the thermocouple voltage in uV.
+*/
+static inline int32_t tableVoltage( uint8_t Index )
+{
+  return (int16_t)pgm_read_word( &TYPEK_TABLE[ Index ] );
+}
+
+
+int32_t typeKVoltage( int32_t Temp )
+{
+  int32_t Offset = Temp - TYPEK_TABLE_MIN * 100L;
+  int32_t Index = Offset / (TYPEK_TABLE_STEP * 100L);
+  int32_t V0;
+
+  // Keep the end segments for extrapolation, integer division truncates towards zero.
+  if (Offset < 0)
+    Index = 0;
+  else if (Index > TYPEK_TABLE_SIZE - 2)
+    Index = TYPEK_TABLE_SIZE - 2;
+
+  V0 = tableVoltage( Index );
+  return V0 + (tableVoltage( Index + 1 ) - V0) * (Offset - Index * TYPEK_TABLE_STEP * 100L) / (TYPEK_TABLE_STEP * 100L);
+}
+
+
+int32_t typeKTemperature( int32_t Voltage )
+{
+  uint8_t Low = 0;
+  uint8_t High = TYPEK_TABLE_SIZE - 1;
+  int32_t V0;
+
+  // Find the segment holding the voltage, the table is strictly increasing.
+  while (High - Low > 1)
+  {
+    uint8_t Middle = (Low + High) / 2;
+
+    if (Voltage < tableVoltage( Middle ))
+      High = Middle;
+    else
+      Low = Middle;
+  }
+
+  V0 = tableVoltage( Low );
+  return (TYPEK_TABLE_MIN + Low * TYPEK_TABLE_STEP) * 100L + (Voltage - V0) * (TYPEK_TABLE_STEP * 100L) / (tableVoltage( High ) - V0);
+}
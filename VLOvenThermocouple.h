@@ -0,0 +1,50 @@
+/*! \file
+ *  \brief Type K thermocouple linearisation.
+ *  This file declares the functions converting between type K thermocouple voltages and temperatures.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _VLOvenThermocouple_h_
+#define  _VLOvenThermocouple_h_
+
+#include <arduino.h>
+#include <inttypes.h>
+
+
+#define TYPEK_TABLE_MIN         (-50)     /*!< \brief Lowest temperature in the type K table, in degrees C. */
+#define TYPEK_TABLE_STEP        (10)      /*!< \brief Temperature step between type K table entries, in degrees C. */
+#define TYPEK_TABLE_SIZE        (46)      /*!< \brief Number of entries in the type K table, covers up to 400 degrees C. */
+#define TYPEK_SEEBECK_NUM       (10319L)  /*!< \brief Linear type K sensitivity used by MAX31855 converters, 41.276 uV/C as \c 10319/25000 uV per 1/100 C. */
+#define TYPEK_SEEBECK_DEN       (25000L)  /*!< \brief Denominator for #TYPEK_SEEBECK_NUM. */
+
+
+/*!
+ * \brief Type K thermocouple voltage for a temperature.
+ * Constant time lookup, the table is uniformly spaced in temperature.
+ * \param Temp Temperature in 1/100 degrees C.
+ * \return Returns the thermocouple voltage in uV, referenced to 0 degrees C.
+*/
+int32_t typeKVoltage( int32_t Temp );
+
+/*!
+ * \brief Type K thermocouple temperature for a voltage.
+ * Binary search over the table followed by linear interpolation, integer math only.
+ * \param Voltage Thermocouple voltage in uV, referenced to 0 degrees C.
+ * \return Returns the temperature in 1/100 degrees C. Out of table values are extrapolated from the end segments.
+*/
+int32_t typeKTemperature( int32_t Voltage );
+
+
+#endif  /* _VLOvenThermocouple_h_ */
@@ -0,0 +1,260 @@
+/*! \file
+ *  \brief Sketch hot paths benchmark.
+ *  Host micro-benchmark running the sketch on the mock converters and the emulated EEPROM of host.cpp, in
+ *  simulated time: the controller cycle idle and with the Pb-free reflow profile in progress, the main loop, the
+ *  trajectory compilation, the profiles directory walks over a filled EEPROM, and the console commands lookup and
+ *  dispatch. It prints one JSON object per case with the nanoseconds per call, the host time only, the simulated
+ *  time does not count.
+ *  The on-target \c bm command times some of the same paths on the real part.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "host.h"
+#include "VLOven.ino"
+
+
+#define BENCH_CALLS             (200000L) /*!< \brief Calls timed per case. */
+#define BENCH_CYCLES            (50000L)  /*!< \brief Cycles timed per controller case, over 8 simulated minutes. */
+#define SIM_STEP                (10)      /*!< \brief Simulated time between cycles in <b>ms</b>, the controller cycle periode. */
+#define PUMP_TIMEOUT            (60000UL) /*!< \brief Longest wait for the EEPROM writes to end in <b>ms</b>. */
+#define FILL_PROFILES           (8)       /*!< \brief Profiles added after the default ones, for the directory walks. */
+#define PBFREE_PROFILE          (1)       /*!< \brief Pb-free reflow profile index, as registered by the sketch. */
+
+static char s_Line[ sizeof(m_ConsoleBuffer) ]; /*!< \brief Command line being sent. */
+static volatile long s_Sink;              /*!< \brief Keeps the compiler from dropping the calls. */
+
+
+/*!
+ * \brief Monotonic time.
+ *
+ * \return Returns the current time in nanoseconds.
+*/
+static double now()
+{
+  struct timespec Time;
+
+  clock_gettime( CLOCK_MONOTONIC, &Time );
+  return Time.tv_sec * 1e9 + Time.tv_nsec;
+}
+
+
+/*!
+ * \brief Runs a console command.
+ * \param lpLine Command line, without the line end.
+ * \return Returns the console output.
+*/
+static const char* command( const char* lpLine )
+{
+  snprintf( s_Line, sizeof(s_Line), "%s\n", lpLine );
+  clearSerialOutput();
+  setSerialInput( s_Line );
+  while (m_Console.hasNewInput())
+    m_Console.handleInput();
+  return getSerialOutput();
+}
+
+
+/*!
+ * \brief Runs the sketch main loop until the EEPROM writes and the profile edit are completed.
+ * \return Returns \c false when they did not complete in time.
+*/
+static bool pump()
+{
+  for (unsigned long Time = 0; Time < PUMP_TIMEOUT; Time++)
+  {
+    loop();
+    if (VLOvenEEPROM::isIdle() && !m_Edit.Active)
+      return true;
+    advanceMillis( 1 );
+  }
+  return false;
+}
+
+
+/*!
+ * \brief Starts the sketch on the default profiles, followed by #FILL_PROFILES four phases ones.
+ * \return Returns \c false when a profile could not be stored.
+*/
+static bool boot()
+{
+  char Line[ 48 ];
+
+  EEPROMFormat();
+  EEPROMRegisterDefaultProfiles();
+  while (!VLOvenEEPROM::isIdle())
+  {
+    advanceMillis( 1 );
+    VLOvenEEPROM::doCycle();
+  }
+  setup();
+
+  for (int Profile = 0; Profile < FILL_PROFILES; Profile++)
+  {
+    sprintf( Line, "p up Fill%d 4", Profile );
+    command( Line );
+    for (int Index = 0; Index < 4; Index++)
+    {
+      sprintf( Line, "p ph %d P%d %d 1 0", Index, Index, 100 + 20 * Index );
+      command( Line );
+    }
+    command( "p cm" );
+    if (!pump())
+      return false;
+  }
+  clearSerialOutput();
+  return GetProfilesCount() == FILL_PROFILES + 2;
+}
+
+
+/*!
+ * \brief Starts the Pb-free reflow profile from the oven temperature.
+ * \return Returns \c false when the controller did not start.
+*/
+static bool startProfile()
+{
+  m_Controller.setPhases( m_ActiveProfile.lpPhases, m_ActiveProfile.Header.PhasesCount, &m_ActiveProfile.Header.Limits );
+  return m_Controller.Start();
+}
+
+
+/*! \brief Profiles directory walk up to the last profile header. */
+static void directoryWalk( long Call )
+{
+  ProfileHeader_t Header;
+
+  s_Sink += LoadProfileHeader( Header, FILL_PROFILES + 1 );
+}
+
+static void freeLookup( long Call ) { s_Sink += FindFreeEEPROMStart(); }
+
+/*! \brief Trajectory of the selected profile, from room temperature. */
+static void trajectory( long Call )
+{
+  VLOvenTrajectorySegment_t Trajectory[ MAX_PROFILE_PHASES ];
+
+  m_Controller.compileTrajectory( m_ActiveProfile.lpPhases, m_ActiveProfile.Header.PhasesCount, 25.0, Trajectory );
+  s_Sink += Trajectory[ 0 ].Length;
+}
+
+/*! \brief Profiles subcommand lookup, in turn for every name of the table. */
+static void lookup( long Call )
+{
+  s_Sink += findCommand( ProfilesCommands[ Call % COMMANDS_COUNT( ProfilesCommands ) ].Name, ProfilesCommands,
+    COMMANDS_COUNT( ProfilesCommands ) );
+}
+
+/*! \brief Settings read from the console, parsing, dispatch and response. */
+static void dispatch( long Call ) { s_Sink += command( "c get kp" )[ 0 ]; }
+
+
+/*!
+ * \brief Reports a case.
+ *
+ * \param lpName Case name.
+ * \param Calls Number of calls timed.
+ * \param Time Host time of the calls, in nanoseconds.
+ * \param Last The case is the last one reported.
+*/
+static void report( const char* lpName, long Calls, double Time, bool Last )
+{
+  printf( "  { \"case\": \"%s\", \"calls\": %ld, \"ns\": %.1f }%s\n", lpName, Calls, Time / Calls, Last ? "" : "," );
+}
+
+
+/*!
+ * \brief Times a function in a tight loop and reports it.
+ *
+ * \param lpName Case name.
+ * \param lpStep Function to time, called with the call number.
+*/
+static void runCase( const char* lpName, void (*lpStep)( long ) )
+{
+  double Start = now();
+
+  for (long Call = 0; Call < BENCH_CALLS; Call++)
+    lpStep( Call );
+  report( lpName, BENCH_CALLS, now() - Start, false );
+}
+
+
+/*!
+ * \brief Times cycles one #SIM_STEP apart and reports them, the simulated time and console output between cycles
+ * are not counted.
+ *
+ * \param lpName Case name.
+ * \param lpCycle Cycle to time.
+ * \param Running The profile is kept running, restarted when it ends.
+ * \param Last The case is the last one reported.
+ * \return Returns \c false when the profile could not be restarted.
+*/
+static bool runCycles( const char* lpName, void (*lpCycle)(), bool Running, bool Last )
+{
+  double Time = 0.0;
+
+  for (long Cycle = 0; Cycle < BENCH_CYCLES; Cycle++)
+  {
+    double Start;
+
+    advanceMillis( SIM_STEP );
+    clearSerialOutput();
+    if (Running && !m_Controller.getRuning() && !startProfile())
+      return false;
+    Start = now();
+    lpCycle();
+    Time += now() - Start;
+  }
+  report( lpName, BENCH_CYCLES, Time, Last );
+  return true;
+}
+
+
+/*! \brief One controller cycle. */
+static void controllerCycle() { m_Controller.doCycle(); }
+
+
+int main()
+{
+  bool Started;
+
+  if (!boot() || !LoadProfile( m_ActiveProfile, PBFREE_PROFILE ))
+  {
+    printf( "FAIL setup\n" );
+    return EXIT_FAILURE;
+  }
+  m_CurrentProfileIndex = PBFREE_PROFILE;
+
+  printf( "[\n" );
+  runCase( "directory walk", directoryWalk );
+  runCase( "free lookup", freeLookup );
+  runCase( "trajectory", trajectory );
+  runCase( "command lookup", lookup );
+  runCase( "command dispatch", dispatch );
+
+  // The idle cycles settle the readings before the profile starts.
+  runCycles( "controller idle", controllerCycle, false, false );
+  Started = runCycles( "controller running", controllerCycle, true, false ) &&
+    runCycles( "loop running", loop, true, true );
+  printf( "]\n" );
+
+  if (!Started)
+  {
+    printf( "FAIL start\n" );
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*! \file
+ *  \brief Sliding window statistics benchmark.
+ *  Host micro-benchmark timing VLOvenStatistics on the windows the shield uses: the SPI converter channels,
+ *  plain and small, and the analog channels, with min/max and median kept. It prints one JSON object per case
+ *  with the nanoseconds per call.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <time.h>
+#include <arduino.h>
+
+// the AVR double is a 32 bits float, build the template the way the sketch gets it
+#define double float
+#include "VLOvenStatistics.h"
+#undef double
+
+
+#define BENCH_CALLS             (5000000L) /*!< \brief Calls timed per case. */
+
+/*! \brief SPI converter channel window, as #TC_SPI_AVERAGING_SAMPLES and #TC_AVERAGING_OPTIONS. */
+typedef VLOvenStatistics<float, 4> SpiAverage_t;
+/*! \brief Analog channel window, as #TEMP_AVERAGING_SAMPLES, with every option. */
+typedef VLOvenStatistics<float, 100, STATISTICS_MINMAX | STATISTICS_MEDIAN> AnalogAverage_t;
+
+static SpiAverage_t s_Spi;                /*!< \brief SPI channel window under test. */
+static AnalogAverage_t s_Analog;          /*!< \brief Analog channel window under test. */
+static volatile float s_Sink;             /*!< \brief Keeps the compiler from dropping the calls. */
+
+
+/*!
+ * \brief Monotonic time.
+ *
+ * \return Returns the current time in nanoseconds.
+*/
+static double now()
+{
+  struct timespec Time;
+
+  clock_gettime( CLOCK_MONOTONIC, &Time );
+  return Time.tv_sec * 1e9 + Time.tv_nsec;
+}
+
+
+/*! \brief Reading a quarter degree converter gives, swinging around 200 degrees C. */
+static float reading( long Call ) { return 200.0f + ((Call * 7919L) % 200) / 4.0f; }
+
+static void spiAdd( long Call ) { s_Spi.addValue( reading( Call ) ); }
+static void spiAverage( long Call ) { s_Sink = s_Spi.getAverage(); }
+static void analogAdd( long Call ) { s_Analog.addValue( reading( Call ) ); }
+static void analogAverage( long Call ) { s_Sink = s_Analog.getAverage(); }
+static void analogVariance( long Call ) { s_Sink = s_Analog.getVariance(); }
+static void analogMin( long Call ) { s_Sink = s_Analog.getMin(); }
+static void analogMedian( long Call ) { s_Sink = s_Analog.getMedian(); }
+
+
+/*!
+ * \brief Times a function and reports it.
+ *
+ * \param lpName Case name.
+ * \param lpStep Function to time, called with the call number.
+ * \param Last The case is the last one reported.
+*/
+static void runCase( const char* lpName, void (*lpStep)( long ), bool Last )
+{
+  double Start = now();
+
+  for (long Call = 0; Call < BENCH_CALLS; Call++)
+    lpStep( Call );
+  printf( "  { \"case\": \"%s\", \"calls\": %ld, \"ns\": %.1f }%s\n", lpName, BENCH_CALLS,
+          (now() - Start) / BENCH_CALLS, Last ? "" : "," );
+}
+
+
+int main()
+{
+  // Full windows, as while running.
+  for (long Call = 0; Call < 100; Call++)
+  {
+    spiAdd( Call );
+    analogAdd( Call );
+  }
+
+  printf( "[\n" );
+  runCase( "spi add", spiAdd, false );
+  runCase( "spi average", spiAverage, false );
+  runCase( "analog add", analogAdd, false );
+  runCase( "analog average", analogAverage, false );
+  runCase( "analog variance", analogVariance, false );
+  runCase( "analog min", analogMin, false );
+  runCase( "analog median", analogMedian, true );
+  printf( "]\n" );
+  return 0;
+}
@@ -0,0 +1,103 @@
+/*! \file
+ *  \brief Formatter benchmark.
+ *  Host micro-benchmark timing the formatters of utils.cpp against the printf calls they replace. It prints
+ *  one JSON object per case with the nanoseconds per call of both.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <time.h>
+#include "utils.h"
+
+
+#define BENCH_CALLS             (2000000) /*!< \brief Calls timed per case. */
+
+static char s_Buffer[ 64 ];               /*!< \brief Destination of every call. */
+static volatile unsigned s_Sink;          /*!< \brief Keeps the compiler from dropping the calls. */
+
+
+/*!
+ * \brief Monotonic time.
+ *
+ * \return Returns the current time in nanoseconds.
+*/
+static double now()
+{
+  struct timespec Time;
+
+  clock_gettime( CLOCK_MONOTONIC, &Time );
+  return Time.tv_sec * 1e9 + Time.tv_nsec;
+}
+
+
+/*! \brief Temperature display the sketch writes on every refresh, in 1/4 degree units. */
+static void fixedTemperature( long Value ) { formatFixed( s_Buffer, Value * 25, 2, 1, 6, "C" ); }
+static void printfTemperature( long Value ) { snprintf( s_Buffer, sizeof(s_Buffer), "%5.1fC", Value * 0.25 ); }
+
+/*! \brief Integer field. */
+static void intField( long Value ) { formatInt( s_Buffer, Value, 6 ); }
+static void printfIntField( long Value ) { snprintf( s_Buffer, sizeof(s_Buffer), "%6ld", Value ); }
+
+/*! \brief Energy display with a SI prefix. */
+static void siEnergy( long Value ) { formatSI( s_Buffer, Value * 37, 0, 1, 8, "Wh" ); }
+static void printfEnergy( long Value ) { snprintf( s_Buffer, sizeof(s_Buffer), "%5.1fkWh", Value * 0.037 ); }
+
+/*! \brief EEPROM dump byte. */
+static void hexByte( long Value ) { formatHex( s_Buffer, (unsigned char)Value, 2 ); }
+static void printfHexByte( long Value ) { snprintf( s_Buffer, sizeof(s_Buffer), "%02X", (unsigned char)Value ); }
+
+
+/*!
+ * \brief Times a formatting function.
+ *
+ * \param lpFormat Function to time, called with values cycling over the display range.
+ * \return Returns the nanoseconds per call.
+*/
+static double timeCalls( void (*lpFormat)( long ) )
+{
+  double Start = now();
+
+  for (long Call = 0; Call < BENCH_CALLS; Call++)
+  {
+    lpFormat( (Call % 5000) - 400 );
+    s_Sink += s_Buffer[ 0 ];
+  }
+  return (now() - Start) / BENCH_CALLS;
+}
+
+
+/*!
+ * \brief Times a formatter and the printf call it replaces and reports both.
+*/
+static void runCase( const char* lpName, void (*lpFormat)( long ), void (*lpPrintf)( long ), bool Last )
+{
+  double Format = timeCalls( lpFormat );
+  double Printf = timeCalls( lpPrintf );
+
+  printf( "  { \"case\": \"%s\", \"calls\": %ld, \"format_ns\": %.1f, \"printf_ns\": %.1f, \"speedup\": %.2f }%s\n",
+          lpName, (long)BENCH_CALLS, Format, Printf, Printf / Format, Last ? "" : "," );
+}
+
+
+int main()
+{
+  printf( "[\n" );
+  runCase( "temperature", fixedTemperature, printfTemperature, false );
+  runCase( "int", intField, printfIntField, false );
+  runCase( "energy", siEnergy, printfEnergy, false );
+  runCase( "hex", hexByte, printfHexByte, true );
+  printf( "]\n" );
+  return 0;
+}
@@ -0,0 +1,41 @@
+/*! \file
+ *  \brief Host stand-in for the GPIOKey library.
+ *  Keys are never pressed on the host.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _GPIOKey_h_
+#define  _GPIOKey_h_
+
+#include <arduino.h>
+
+
+#define GPIOKEYRELEASED         2         /*!< \brief Key state change returned by GPIOKey::Check() on release. */
+
+
+class GPIOKey
+{
+  public:
+    GPIOKey( uint8_t Pin, uint8_t KeyCode ) : m_KeyCode( KeyCode ) {}
+    int Check() { return 0; }
+    unsigned long keyPressDuration() { return 0; }
+    uint8_t keyCode() { return m_KeyCode; }
+
+  private:
+    uint8_t m_KeyCode;
+};
+
+
+#endif  /* _GPIOKey_h_ */
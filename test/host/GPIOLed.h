@@ -0,0 +1,38 @@
+/*! \file
+ *  \brief Host stand-in for the GPIOLed library.
+ *  The LED state goes to its pin, see getPinState().
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _GPIOLed_h_
+#define  _GPIOLed_h_
+
+#include <arduino.h>
+
+
+class GPIOLed
+{
+  public:
+    GPIOLed( uint8_t Pin ) : m_Pin( Pin ) {}
+    void on() { digitalWrite( m_Pin, HIGH ); }
+    void off() { digitalWrite( m_Pin, LOW ); }
+    void update() {}
+
+  private:
+    uint8_t m_Pin;
+};
+
+
+#endif  /* _GPIOLed_h_ */
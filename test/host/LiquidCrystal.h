@@ -0,0 +1,36 @@
+/*! \file
+ *  \brief Host stand-in for the LiquidCrystal library.
+ *  The display output is discarded.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _LiquidCrystal_h_
+#define  _LiquidCrystal_h_
+
+#include <arduino.h>
+
+
+class LiquidCrystal : public Print
+{
+  public:
+    LiquidCrystal( uint8_t RS, uint8_t RW, uint8_t EN, uint8_t DB4, uint8_t DB5, uint8_t DB6, uint8_t DB7 ) {}
+    void begin( uint8_t Columns, uint8_t Rows ) {}
+    void clear() {}
+    void noAutoscroll() {}
+    void setCursor( uint8_t Column, uint8_t Row ) {}
+};
+
+
+#endif  /* _LiquidCrystal_h_ */
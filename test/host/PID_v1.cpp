@@ -0,0 +1,138 @@
+/*! \file
+ *  \brief Host stand-in for the Arduino PID Library.
+ *  This file implements the PID_v1 (version 1.1.1) algorithm, see PID_v1.h.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "PID_v1.h"
+
+
+PID::PID( double* lpInput, double* lpOutput, double* lpSetpoint, double Kp, double Ki, double Kd, int ControllerDirection ) :
+  m_ControllerDirection( ControllerDirection ),
+  m_lpInput( lpInput ),
+  m_lpOutput( lpOutput ),
+  m_lpSetpoint( lpSetpoint ),
+  m_ITerm( 0.0 ),
+  m_LastInput( 0.0 ),
+  m_SampleTime( 100 ),
+  m_InAuto( false )
+{
+  SetOutputLimits( 0, 255 );
+  SetControllerDirection( ControllerDirection );
+  SetTunings( Kp, Ki, Kd );
+  m_LastTime = millis() - m_SampleTime;
+}
+
+
+bool PID::Compute()
+{
+  unsigned long Now = millis();
+  double Input;
+  double Error;
+  double Output;
+
+  if (!m_InAuto || ((Now - m_LastTime) < m_SampleTime))
+    return false;
+
+  Input = *m_lpInput;
+  Error = *m_lpSetpoint - Input;
+  m_ITerm = constrain( m_ITerm + m_Ki * Error, m_OutMin, m_OutMax );
+  Output = constrain( m_Kp * Error + m_ITerm - m_Kd * (Input - m_LastInput), m_OutMin, m_OutMax );
+  *m_lpOutput = Output;
+
+  m_LastInput = Input;
+  m_LastTime = Now;
+  return true;
+}
+
+
+void PID::SetTunings( double Kp, double Ki, double Kd )
+{
+  double SampleTime = m_SampleTime / 1000.0;
+
+  if ((Kp < 0) || (Ki < 0) || (Kd < 0))
+    return;
+
+  m_DispKp = Kp;
+  m_DispKi = Ki;
+  m_DispKd = Kd;
+  m_Kp = Kp;
+  m_Ki = Ki * SampleTime;
+  m_Kd = Kd / SampleTime;
+  if (m_ControllerDirection == REVERSE)
+  {
+    m_Kp = -m_Kp;
+    m_Ki = -m_Ki;
+    m_Kd = -m_Kd;
+  }
+}
+
+
+void PID::SetSampleTime( int NewSampleTime )
+{
+  if (NewSampleTime > 0)
+  {
+    double Ratio = (double)NewSampleTime / m_SampleTime;
+
+    m_Ki *= Ratio;
+    m_Kd /= Ratio;
+    m_SampleTime = NewSampleTime;
+  }
+}
+
+
+void PID::SetOutputLimits( double Min, double Max )
+{
+  if (Min >= Max)
+    return;
+
+  m_OutMin = Min;
+  m_OutMax = Max;
+  if (m_InAuto)
+  {
+    *m_lpOutput = constrain( *m_lpOutput, m_OutMin, m_OutMax );
+    m_ITerm = constrain( m_ITerm, m_OutMin, m_OutMax );
+  }
+}
+
+
+void PID::SetMode( int Mode )
+{
+  bool NewAuto = (Mode == AUTOMATIC);
+
+  // Bumpless transfer from manual.
+  if (NewAuto && !m_InAuto)
+    Initialize();
+  m_InAuto = NewAuto;
+}
+
+
+void PID::Initialize()
+{
+  m_ITerm = constrain( *m_lpOutput, m_OutMin, m_OutMax );
+  m_LastInput = *m_lpInput;
+}
+
+
+void PID::SetControllerDirection( int Direction )
+{
+  if (m_InAuto && (Direction != m_ControllerDirection))
+  {
+    m_Kp = -m_Kp;
+    m_Ki = -m_Ki;
+    m_Kd = -m_Kd;
+  }
+  m_ControllerDirection = Direction;
+}
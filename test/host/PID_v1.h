@@ -0,0 +1,77 @@
+/*! \file
+ *  \brief Host stand-in for the Arduino PID Library.
+ *  This file declares the PID_v1 (version 1.1.1) interface the controller uses. The implementation in PID_v1.cpp
+ *  follows the same algorithm: proportional on error, derivative on measurement, integral term clamped to the
+ *  output limits, fixed sample time.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _PID_v1_h_
+#define  _PID_v1_h_
+
+#include <arduino.h>
+
+
+#define AUTOMATIC               1
+#define MANUAL                  0
+#define DIRECT                  0
+#define REVERSE                 1
+
+
+/*!
+ * \brief PID loop.
+*/
+class PID
+{
+  public:
+    PID( double* lpInput, double* lpOutput, double* lpSetpoint, double Kp, double Ki, double Kd, int ControllerDirection );
+
+    void SetMode( int Mode );
+    bool Compute();
+    void SetOutputLimits( double Min, double Max );
+    void SetTunings( double Kp, double Ki, double Kd );
+    void SetControllerDirection( int Direction );
+    void SetSampleTime( int NewSampleTime );
+
+    double GetKp() { return m_DispKp; }
+    double GetKi() { return m_DispKi; }
+    double GetKd() { return m_DispKd; }
+    int GetMode() { return m_InAuto ? AUTOMATIC : MANUAL; }
+    int GetDirection() { return m_ControllerDirection; }
+
+  private:
+    void Initialize();
+
+    double m_DispKp;                      /*!< \brief Proportional gain, as given. */
+    double m_DispKi;                      /*!< \brief Integral gain, as given. */
+    double m_DispKd;                      /*!< \brief Derivative gain, as given. */
+    double m_Kp;                          /*!< \brief Proportional gain, signed for the direction. */
+    double m_Ki;                          /*!< \brief Integral gain per sample. */
+    double m_Kd;                          /*!< \brief Derivative gain per sample. */
+    int m_ControllerDirection;            /*!< \brief #DIRECT or #REVERSE. */
+    double* m_lpInput;                    /*!< \brief Process value. */
+    double* m_lpOutput;                   /*!< \brief Controller output. */
+    double* m_lpSetpoint;                 /*!< \brief Setpoint. */
+    unsigned long m_LastTime;             /*!< \brief Time of the last computation. */
+    double m_ITerm;                       /*!< \brief Integral term. */
+    double m_LastInput;                   /*!< \brief Process value at the last computation. */
+    unsigned long m_SampleTime;           /*!< \brief Sample time in <b>ms</b>. */
+    double m_OutMin;                      /*!< \brief Lower output limit. */
+    double m_OutMax;                      /*!< \brief Upper output limit. */
+    bool m_InAuto;                        /*!< \brief The loop runs. */
+};
+
+
+#endif  /* _PID_v1_h_ */
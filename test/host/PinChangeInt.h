@@ -0,0 +1,28 @@
+/*! \file
+ *  \brief Host stand-in for the PinChangeInt library.
+ *  Pin change interrupts never fire on the host.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _PinChangeInt_h_
+#define  _PinChangeInt_h_
+
+#include <arduino.h>
+
+
+inline void attachPinChangeInterrupt( uint8_t Pin, void (*lpHandler)( void ), uint8_t Mode ) {}
+
+
+#endif  /* _PinChangeInt_h_ */
@@ -0,0 +1,28 @@
+/*! \file
+ *  \brief Host stand-in for the SoftReset library.
+ *  There is nothing to restart on the host, a restart ends the program.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _SoftReset_h_
+#define  _SoftReset_h_
+
+#include <stdlib.h>
+
+
+inline void soft_restart() { abort(); }
+
+
+#endif  /* _SoftReset_h_ */
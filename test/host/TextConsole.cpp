@@ -0,0 +1,93 @@
+/*! \file
+ *  \brief Host stand-in for the TextConsole Library.
+ *  This file implements the line reading and the command dispatching, see TextConsole.h.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "TextConsole.h"
+
+
+TextConsole::TextConsole( HardwareSerial& Port, char* lpBuffer, int Size, const ConsoleCommandEntry* lpCommands ) :
+  m_Port( Port ),
+  m_lpBuffer( lpBuffer ),
+  m_Size( Size ),
+  m_Length( 0 ),
+  m_lpCommands( lpCommands ),
+  m_ArgsCount( 0 )
+{
+}
+
+
+void TextConsole::begin( const __FlashStringHelper* lpBanner )
+{
+  m_Length = 0;
+  m_Port.print( lpBanner );
+}
+
+
+bool TextConsole::handleInput()
+{
+  int Value;
+
+  if (m_Port.available() <= 0)
+    return false;
+
+  while ((Value = m_Port.read()) >= 0)
+  {
+    if ((Value == '\r') || (Value == '\n'))
+    {
+      m_lpBuffer[ m_Length ] = '\0';
+      if (m_Length > 0)
+        runCommand();
+      m_Length = 0;
+      break;
+    }
+
+    // Longer lines are cut, the command then fails on its arguments.
+    if (m_Length < m_Size - 1)
+      m_lpBuffer[ m_Length++ ] = Value;
+  }
+  return true;
+}
+
+
+void TextConsole::sendResponse( ConsoleResult_t Result, const __FlashStringHelper* lpText )
+{
+  beginResponse( Result );
+  if (lpText != NULL)
+    m_Port.print( lpText );
+  endResponse( Result );
+}
+
+
+void TextConsole::runCommand()
+{
+  char* lpName = strtok( m_lpBuffer, " \t" );
+  char* lpArg;
+
+  m_ArgsCount = 0;
+  while ((m_ArgsCount < TEXTCONSOLE_MAX_ARGS) && ((lpArg = strtok( NULL, " \t" )) != NULL))
+    m_lpArgs[ m_ArgsCount++ ] = lpArg;
+
+  for (const ConsoleCommandEntry* lpCommand = m_lpCommands; (lpCommand != NULL) && (lpCommand->Name != NULL); lpCommand++)
+  {
+    if (strcmp( lpCommand->Name, lpName ) == 0)
+    {
+      lpCommand->Handler( this );
+      return;
+    }
+  }
+  sendResponse( CONSOLEERROR, F(TEXTCONSOLE_CMDUNKNOWN) );
+}
@@ -0,0 +1,104 @@
+/*! \file
+ *  \brief Host stand-in for the TextConsole Library.
+ *  This file declares the TextConsole interface the sketch uses. Lines read from the serial port are split on
+ *  blanks, the first word selects the command entry and the others are the handler arguments. Responses are
+ *  written as \c OK or \c ERR followed by the text, events start with \c EV, each ends with #TEXTCONSOLE_EOLN.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _TextConsole_h_
+#define  _TextConsole_h_
+
+#include <arduino.h>
+
+
+#define TEXTCONSOLE_EOLN              "\r\n"
+#define TEXTCONSOLE_CMDUNKNOWN        "Unknown command"
+#define TEXTCONSOLE_CMDARGSCOUNT      "Wrong arguments count"
+#define TEXTCONSOLE_CMDARGINVALIDOPT  "Invalid option"
+#define TEXTCONSOLE_CMDARGOUTOFRANGE  "Argument out of range"
+#define TEXTCONSOLE_CMDNOMEMORY       "Not enough memory"
+
+#define TEXTCONSOLE_MAX_ARGS          (8)     /*!< \brief Most arguments a command line holds. */
+
+
+typedef enum {
+  CONSOLESUCCESS,
+  CONSOLEERROR
+} ConsoleResult_t;
+
+
+class TextConsole;
+
+/*!
+ * \brief Command table entry, tables end with a \c NULL name.
+*/
+struct ConsoleCommandEntry
+{
+  const char* Name;
+  void (*Handler)( TextConsole* lpSilly );
+};
+
+
+/*!
+ * \brief Line oriented command interpreter.
+*/
+class TextConsole
+{
+  public:
+    TextConsole( HardwareSerial& Port, char* lpBuffer, int Size, const ConsoleCommandEntry* lpCommands );
+
+    void begin( const __FlashStringHelper* lpBanner );
+
+    /*!
+     * \brief Read the available input, running the command once a line is complete.
+     * \return Returns \c true when input was read.
+    */
+    bool handleInput();
+    bool hasNewInput() { return m_Port.available() > 0; }
+
+    int argsCount() { return m_ArgsCount; }
+    const char* getArg( int Index ) { return ((Index >= 0) && (Index < m_ArgsCount)) ? m_lpArgs[ Index ] : ""; }
+
+    void beginEvent() { m_Port.print( "EV " ); }
+    void endEvent() { m_Port.print( TEXTCONSOLE_EOLN ); }
+    void beginResponse( ConsoleResult_t Result = CONSOLESUCCESS ) { m_Port.print( (Result == CONSOLESUCCESS) ? "OK " : "ERR " ); }
+    void endResponse( ConsoleResult_t Result = CONSOLESUCCESS ) { m_Port.print( TEXTCONSOLE_EOLN ); }
+    void sendResponse( ConsoleResult_t Result, const __FlashStringHelper* lpText = NULL );
+
+    void send( const char* lpText ) { m_Port.print( lpText ); }
+    void send( const __FlashStringHelper* lpText ) { m_Port.print( lpText ); }
+    void send( char Value ) { m_Port.print( Value ); }
+    void send( int Value ) { m_Port.print( Value ); }
+    void send( unsigned int Value ) { m_Port.print( Value ); }
+    void send( long Value ) { m_Port.print( Value ); }
+    void send( unsigned long Value ) { m_Port.print( Value ); }
+    void send( double Value ) { m_Port.print( Value ); }
+    void send( bool Value ) { m_Port.print( (int)Value ); }
+
+  private:
+    void runCommand();
+
+    HardwareSerial& m_Port;                       /*!< \brief Serial port. */
+    char* m_lpBuffer;                             /*!< \brief Input line buffer. */
+    int m_Size;                                   /*!< \brief Input line buffer size. */
+    int m_Length;                                 /*!< \brief Input line length. */
+    const ConsoleCommandEntry* m_lpCommands;      /*!< \brief Command table. */
+    const char* m_lpArgs[ TEXTCONSOLE_MAX_ARGS ]; /*!< \brief Current command arguments. */
+    int m_ArgsCount;                              /*!< \brief Current command arguments count. */
+};
+
+
+#endif  /* _TextConsole_h_ */
@@ -0,0 +1,129 @@
+/*! \file
+ *  \brief Host stand-in for the Arduino core header.
+ *  This file declares the Arduino core definitions the sketch modules use, so they build and run on the host.
+ *  The core functions are implemented in host.cpp, see host.h for driving the time and the inputs.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _arduino_h_
+#define  _arduino_h_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+
+
+#define HIGH                    1
+#define LOW                     0
+
+#define INPUT                   0
+#define OUTPUT                  1
+#define INPUT_PULLUP            2
+
+#define EXTERNAL                0
+#define DEFAULT                 1
+#define INTERNAL                3
+
+#define CHANGE                  1
+#define FALLING                 2
+#define RISING                  3
+
+#define A0                      14
+#define A1                      15
+#define A2                      16
+#define A3                      17
+#define A4                      18
+#define A5                      19
+#define A6                      20
+#define A7                      21
+
+#define NUM_DIGITAL_PINS        22        /*!< \brief Number of pins, the analog inputs included. */
+
+static const uint8_t SS = 10;
+static const uint8_t MOSI = 11;
+static const uint8_t MISO = 12;
+static const uint8_t SCK = 13;
+
+#define noInterrupts()          cli()
+#define interrupts()            sei()
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+/*! \brief Flash strings are plain strings on the host. */
+class __FlashStringHelper;
+#define F( Text )               (reinterpret_cast<const __FlashStringHelper*>( Text ))
+
+
+/* The core macros are templates, so that the C++ library headers can follow. */
+template <class T, class U> inline auto min( T a, U b ) -> decltype( a + b ) { return (a < b) ? a : b; }
+template <class T, class U> inline auto max( T a, U b ) -> decltype( a + b ) { return (a > b) ? a : b; }
+template <class T, class U, class V> inline auto constrain( T Value, U Low, V High ) -> decltype( Value + Low + High )
+  { return (Value < Low) ? Low : ((Value > High) ? High : Value); }
+
+
+unsigned long millis();
+unsigned long micros();
+void delay( unsigned long Time );
+void delayMicroseconds( unsigned int Time );
+
+void pinMode( uint8_t Pin, uint8_t Mode );
+void digitalWrite( uint8_t Pin, uint8_t Value );
+int digitalRead( uint8_t Pin );
+int analogRead( uint8_t Pin );
+void analogReference( uint8_t Mode );
+void analogWrite( uint8_t Pin, int Value );
+
+
+/*!
+ * \brief Text output, discarded unless a derived class writes it somewhere.
+*/
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write( uint8_t Value ) { return 1; }
+    size_t print( const char* lpText );
+    size_t print( const __FlashStringHelper* lpText ) { return print( (const char*)lpText ); }
+    size_t print( char Value );
+    size_t print( int Value );
+    size_t print( unsigned int Value );
+    size_t print( long Value );
+    size_t print( unsigned long Value );
+    size_t print( double Value, int Digits = 2 );
+};
+
+
+/*!
+ * \brief Serial port, its input and output are buffered in memory, see host.h.
+*/
+class HardwareSerial : public Print
+{
+  public:
+    size_t write( uint8_t Value );
+    void begin( unsigned long Speed ) {}
+    int available();
+    int read();
+};
+
+extern HardwareSerial Serial;
+
+
+#endif  /* _arduino_h_ */
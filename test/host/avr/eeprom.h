@@ -0,0 +1,34 @@
+/*! \file
+ *  \brief Host stand-in for the AVR EEPROM header.
+ *  The EEPROM is an array in memory, of #E2END + 1 bytes, erased at startup. Waiting for a cell write to end moves
+ *  the host time to its end.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _avr_eeprom_h_
+#define  _avr_eeprom_h_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/io.h>
+
+
+#define eeprom_is_ready()       (!(EECR & _BV( EEPE )))
+
+void eeprom_busy_wait();
+void eeprom_read_block( void* lpData, const void* lpAddress, size_t Length );
+
+
+#endif  /* _avr_eeprom_h_ */
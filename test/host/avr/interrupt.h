@@ -0,0 +1,30 @@
+/*! \file
+ *  \brief Host stand-in for the AVR interrupts header.
+ *  Interrupt handlers are plain functions on the host, host.cpp calls them when their interrupt would fire.
+ *  Nothing runs concurrently, so disabling the interrupts does nothing.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _avr_interrupt_h_
+#define  _avr_interrupt_h_
+
+
+#define ISR( Vector )           extern "C" void Vector( void )
+
+#define cli()                   do {} while (0)
+#define sei()                   do {} while (0)
+
+
+#endif  /* _avr_interrupt_h_ */
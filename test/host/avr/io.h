@@ -0,0 +1,106 @@
+/*! \file
+ *  \brief Host stand-in for the AVR I/O registers header.
+ *  This file declares the ATmega328P registers, bits and interrupt vectors the sketch modules use. The registers
+ *  are plain variables, host.cpp plays the peripherals behind them when the host time runs. The EEPROM control
+ *  register is the exception, setting its read and write strobes acts on the EEPROM contents right away.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _avr_io_h_
+#define  _avr_io_h_
+
+#include <inttypes.h>
+
+
+#ifndef F_CPU
+# define F_CPU                  16000000UL  /*!< \brief CPU clock, an Arduino Uno. */
+#endif
+#ifndef E2END
+# define E2END                  0x3FF     /*!< \brief Last EEPROM address. */
+#endif
+
+#define _BV( Bit )              (1 << (Bit))
+
+/* Timer1 */
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TIMSK1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t TCNT1;
+
+#define CS10                    0
+#define CS11                    1
+#define CS12                    2
+#define WGM12                   3
+#define OCIE1A                  1
+
+/* SPI */
+extern volatile uint8_t SPCR;
+extern volatile uint8_t SPSR;
+extern volatile uint8_t SPDR;
+
+#define SPR0                    0
+#define SPR1                    1
+#define CPHA                    2
+#define CPOL                    3
+#define MSTR                    4
+#define DORD                    5
+#define SPE                     6
+#define SPIE                    7
+#define SPIF                    7
+
+/* ADC */
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t ADMUX;
+extern volatile uint16_t ADC;
+
+#define ADIE                    3
+#define ADSC                    6
+#define ADEN                    7
+
+/* EEPROM */
+#define EERE                    0
+#define EEPE                    1
+#define EEMPE                   2
+#define EERIE                   3
+
+/*!
+ * \brief EEPROM control register.
+ * Setting #EERE reads the cell at #EEAR into #EEDR. Setting #EEPE while #EEMPE is set writes #EEDR to the cell at
+ * #EEAR, #EEPE then stays set for the cell write time, as the hardware does. See host.cpp.
+*/
+class EEPROMControlRegister
+{
+  public:
+    operator uint8_t() const { return m_Value; }
+    EEPROMControlRegister& operator|=( uint8_t Bits );
+    EEPROMControlRegister& operator&=( uint8_t Bits ) { m_Value &= Bits; return *this; }
+
+  private:
+    volatile uint8_t m_Value;             /*!< \brief Register value, the strobes read back as on the hardware. */
+};
+
+extern EEPROMControlRegister EECR;
+extern volatile uint8_t EEDR;
+extern volatile uint16_t EEAR;
+
+/* Interrupt vectors */
+#define TIMER1_COMPA_vect       __vector_11
+#define SPI_STC_vect            __vector_17
+#define ADC_vect                __vector_21
+#define EE_READY_vect           __vector_22
+
+
+#endif  /* _avr_io_h_ */
@@ -0,0 +1,41 @@
+/*! \file
+ *  \brief Host stand-in for the AVR program memory header.
+ *  There is one address space on the host, flash data is plain constant data.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _avr_pgmspace_h_
+#define  _avr_pgmspace_h_
+
+#include <inttypes.h>
+#include <string.h>
+
+
+#define PROGMEM
+#define PSTR( Text )            (Text)
+
+#define pgm_read_byte( Address )      (*(const uint8_t*)(Address))
+#define pgm_read_byte_near( Address ) (*(const uint8_t*)(Address))
+#define pgm_read_word( Address )      (*(const uint16_t*)(Address))
+#define pgm_read_dword( Address )     (*(const uint32_t*)(Address))
+#define pgm_read_float( Address )     (*(const float*)(Address))
+
+#define memcpy_P                memcpy
+#define strcmp_P                strcmp
+#define strcpy_P                strcpy
+#define strlen_P                strlen
+
+
+#endif  /* _avr_pgmspace_h_ */
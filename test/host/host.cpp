@@ -0,0 +1,329 @@
+/*! \file
+ *  \brief Host test support.
+ *  This file implements the Arduino core stand-in and plays the peripherals behind the registers.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <avr/eeprom.h>
+#include "host.h"
+
+
+/* The modules under test define the handlers they need, the others stay NULL. */
+extern "C" void TIMER1_COMPA_vect( void ) __attribute__((weak));
+extern "C" void ADC_vect( void ) __attribute__((weak));
+extern "C" void EE_READY_vect( void ) __attribute__((weak));
+
+#define EEPROM_WRITE_TIME       (3400)    /*!< \brief Cell erase and write time in <b>us</b>. */
+
+volatile uint8_t TCCR1A;
+volatile uint8_t TCCR1B;
+volatile uint8_t TIMSK1;
+volatile uint16_t OCR1A;
+volatile uint16_t TCNT1;
+volatile uint8_t SPCR;
+volatile uint8_t SPSR;
+volatile uint8_t SPDR;
+volatile uint8_t ADCSRA;
+volatile uint8_t ADMUX;
+volatile uint16_t ADC;
+EEPROMControlRegister EECR;
+volatile uint8_t EEDR;
+volatile uint16_t EEAR;
+
+HardwareSerial Serial;
+
+/*! \brief Timer1 clock dividers, indexed by the clock select bits. */
+static const uint16_t TIMER1_PRESCALERS[] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+
+static uint32_t s_Micros = 0;             /*!< \brief Host time. */
+static uint32_t s_TimerMicros = 0;        /*!< \brief Time since the last Timer1 compare match. */
+static uint16_t s_Analog[ 8 ];            /*!< \brief Analog input readings. */
+static uint8_t s_Pins[ NUM_DIGITAL_PINS ];  /*!< \brief Pin levels. */
+static uint8_t s_EEPROM[ E2END + 1 ];    /*!< \brief EEPROM contents. */
+static bool s_EEPROMErased = (memset( s_EEPROM, 0xFF, sizeof(s_EEPROM) ) != NULL);  /*!< \brief Erased at startup, as a new part. */
+static uint32_t s_EEPROMReady = 0;        /*!< \brief Time the cell write in progress ends. */
+static unsigned long s_EEPROMWrites = 0;  /*!< \brief Number of cell writes since startup. */
+static const char* s_lpSerialInput = "";  /*!< \brief Serial input not read yet. */
+static char s_SerialOutput[ 0x10000 ];    /*!< \brief Serial output since the last #clearSerialOutput(). */
+static size_t s_SerialLength = 0;         /*!< \brief Number of chars in #s_SerialOutput. */
+
+
+void setMillis( unsigned long Time )
+{
+  s_Micros = Time * 1000UL;
+}
+
+
+void advanceMillis( unsigned long Time )
+{
+  while (Time--)
+  {
+    s_Micros += 1000;
+    runInterrupts();
+
+    // CTC mode, the counter restarts on every compare match.
+    if ((TIMSK1 & _BV(OCIE1A)) && (TIMER1_PRESCALERS[ TCCR1B & 0x07 ] != 0) && (TIMER1_COMPA_vect != NULL))
+    {
+      uint32_t Periode = (uint32_t)((OCR1A + 1UL) * TIMER1_PRESCALERS[ TCCR1B & 0x07 ] / (F_CPU / 1000000UL));
+
+      for (s_TimerMicros += 1000; s_TimerMicros >= Periode; s_TimerMicros -= Periode)
+        TIMER1_COMPA_vect();
+    }
+  }
+}
+
+
+void runInterrupts()
+{
+  // Each conversion completes before the next one starts.
+  while ((ADCSRA & _BV(ADIE)) && (ADCSRA & _BV(ADSC)) && (ADC_vect != NULL))
+  {
+    ADCSRA &= ~_BV(ADSC);
+    ADC = s_Analog[ ADMUX & 0x07 ];
+    ADC_vect();
+  }
+
+  // The ready interrupt holds as long as it is enabled and no cell write is in progress.
+  if ((EECR & _BV(EEPE)) && ((int32_t)(s_Micros - s_EEPROMReady) >= 0))
+    EECR &= ~_BV(EEPE);
+  while ((EECR & _BV(EERIE)) && !(EECR & _BV(EEPE)) && (EE_READY_vect != NULL))
+    EE_READY_vect();
+}
+
+
+void setAnalogInput( uint8_t Pin, uint16_t Counts )
+{
+  s_Analog[ (Pin >= A0) ? Pin - A0 : Pin ] = Counts;
+}
+
+
+void setDigitalInput( uint8_t Pin, uint8_t Value )
+{
+  s_Pins[ Pin ] = Value;
+}
+
+
+uint8_t getPinState( uint8_t Pin )
+{
+  return s_Pins[ Pin ];
+}
+
+
+EEPROMControlRegister& EEPROMControlRegister::operator|=( uint8_t Bits )
+{
+  // The hardware ignores the strobes while a cell is being written.
+  if (m_Value & _BV(EEPE))
+    Bits &= ~(_BV(EERE) | _BV(EEPE));
+
+  if (Bits & _BV(EERE))
+    EEDR = s_EEPROM[ EEAR & E2END ];
+
+  // The write strobe only works after the master write enable.
+  if ((Bits & _BV(EEPE)) && (m_Value & _BV(EEMPE)))
+  {
+    s_EEPROM[ EEAR & E2END ] = EEDR;
+    s_EEPROMWrites++;
+    s_EEPROMReady = s_Micros + EEPROM_WRITE_TIME;
+    m_Value = (m_Value & ~_BV(EEMPE)) | _BV(EEPE);
+  }
+
+  m_Value |= Bits & (_BV(EEMPE) | _BV(EERIE));
+  return *this;
+}
+
+
+void eeprom_busy_wait()
+{
+  if (EECR & _BV(EEPE))
+  {
+    s_Micros = s_EEPROMReady;
+    EECR &= ~_BV(EEPE);
+  }
+}
+
+
+void eeprom_read_block( void* lpData, const void* lpAddress, size_t Length )
+{
+  memcpy( lpData, &s_EEPROM[ (uintptr_t)lpAddress ], Length );
+}
+
+
+uint8_t* getEEPROM()
+{
+  return s_EEPROM;
+}
+
+
+unsigned long getEEPROMWrites()
+{
+  return s_EEPROMWrites;
+}
+
+
+void setSerialInput( const char* lpText )
+{
+  s_lpSerialInput = lpText;
+}
+
+
+const char* getSerialOutput()
+{
+  s_SerialOutput[ s_SerialLength ] = '\0';
+  return s_SerialOutput;
+}
+
+
+void clearSerialOutput()
+{
+  s_SerialLength = 0;
+}
+
+
+unsigned long millis()
+{
+  return s_Micros / 1000UL;
+}
+
+
+unsigned long micros()
+{
+  return s_Micros;
+}
+
+
+void delay( unsigned long Time )
+{
+  advanceMillis( Time );
+}
+
+
+void delayMicroseconds( unsigned int Time )
+{
+  s_Micros += Time;
+}
+
+
+void pinMode( uint8_t Pin, uint8_t Mode )
+{
+  if (Mode == INPUT_PULLUP)
+    s_Pins[ Pin ] = HIGH;
+}
+
+
+void digitalWrite( uint8_t Pin, uint8_t Value )
+{
+  s_Pins[ Pin ] = (Value != LOW) ? HIGH : LOW;
+}
+
+
+int digitalRead( uint8_t Pin )
+{
+  return s_Pins[ Pin ];
+}
+
+
+int analogRead( uint8_t Pin )
+{
+  return s_Analog[ (Pin >= A0) ? Pin - A0 : Pin ];
+}
+
+
+void analogReference( uint8_t Mode )
+{
+}
+
+
+void analogWrite( uint8_t Pin, int Value )
+{
+  s_Pins[ Pin ] = (Value >= 128) ? HIGH : LOW;
+}
+
+
+size_t Print::print( const char* lpText )
+{
+  size_t Count = 0;
+
+  while (*lpText)
+    Count += write( *lpText++ );
+  return Count;
+}
+
+
+size_t Print::print( char Value )
+{
+  return write( Value );
+}
+
+
+size_t Print::print( int Value )
+{
+  return print( (long)Value );
+}
+
+
+size_t Print::print( unsigned int Value )
+{
+  return print( (unsigned long)Value );
+}
+
+
+size_t Print::print( long Value )
+{
+  char Text[ 16 ];
+
+  snprintf( Text, sizeof(Text), "%ld", Value );
+  return print( Text );
+}
+
+
+size_t Print::print( unsigned long Value )
+{
+  char Text[ 16 ];
+
+  snprintf( Text, sizeof(Text), "%lu", Value );
+  return print( Text );
+}
+
+
+size_t Print::print( double Value, int Digits )
+{
+  char Text[ 32 ];
+
+  snprintf( Text, sizeof(Text), "%.*f", Digits, Value );
+  return print( Text );
+}
+
+
+size_t HardwareSerial::write( uint8_t Value )
+{
+  // Whatever does not fit is lost, as on a port nobody reads.
+  if (s_SerialLength >= sizeof(s_SerialOutput) - 1)
+    return 0;
+  s_SerialOutput[ s_SerialLength++ ] = Value;
+  return 1;
+}
+
+
+int HardwareSerial::available()
+{
+  return strlen( s_lpSerialInput );
+}
+
+
+int HardwareSerial::read()
+{
+  return (*s_lpSerialInput != '\0') ? (uint8_t)*s_lpSerialInput++ : -1;
+}
@@ -0,0 +1,101 @@
+/*! \file
+ *  \brief Host test support.
+ *  The sketch modules run on the host against stand-ins for the Arduino core, the AVR headers and the libraries,
+ *  found in this directory. Time only moves when the test says so, and the interrupts the peripherals would
+ *  raise meanwhile are delivered then, between two statements of the main program. This file declares the
+ *  functions tests use for driving the time and the inputs.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _host_h_
+#define  _host_h_
+
+#include <arduino.h>
+
+
+/*!
+ * \brief Set the time, without delivering any interrupt.
+ * \param Time New #millis() value.
+*/
+void setMillis( unsigned long Time );
+
+/*!
+ * \brief Let the time run one millisecond at a time, delivering the interrupts due along the way.
+ * Timer1 fires at its programmed periode, and the pending interrupts are delivered once per millisecond.
+ * \param Time Number of milliseconds.
+*/
+void advanceMillis( unsigned long Time );
+
+/*!
+ * \brief Deliver the pending interrupts: the ADC conversions started, one after the other, then the EEPROM ready
+ * interrupt while it is enabled and no cell write is in progress. A cell write takes 3.4 ms of host time.
+ * \remarks Code waiting in a loop for an interrupt to change something does not return on the host.
+*/
+void runInterrupts();
+
+/*!
+ * \brief Set the reading of an analog input.
+ * \param Pin Analog input, from #A0 to #A7.
+ * \param Counts ADC reading, from \c 0 to \c 1023.
+*/
+void setAnalogInput( uint8_t Pin, uint16_t Counts );
+
+/*!
+ * \brief Set the level of a digital input.
+ * \param Pin Input pin.
+ * \param Value Input level, \c HIGH or \c LOW.
+*/
+void setDigitalInput( uint8_t Pin, uint8_t Value );
+
+/*!
+ * \brief Get the level of a pin, as last written or set.
+ * \param Pin Pin number.
+ * \return Returns \c HIGH or \c LOW.
+*/
+uint8_t getPinState( uint8_t Pin );
+
+
+/*!
+ * \brief Get the EEPROM contents.
+ * \return Returns the #E2END + 1 EEPROM bytes, which tests may change, as a reset keeps them.
+*/
+uint8_t* getEEPROM();
+
+/*!
+ * \brief Get the number of EEPROM cell writes.
+ * \return Returns the number of cells written since startup, the EEPROM wear.
+*/
+unsigned long getEEPROMWrites();
+
+
+/*!
+ * \brief Set the text the serial port receives next.
+ * \param lpText Input text, read in place so it must last until read.
+*/
+void setSerialInput( const char* lpText );
+
+/*!
+ * \brief Get the serial port output.
+ * \return Returns the text written to the serial port since the last #clearSerialOutput(), up to 64 KB.
+*/
+const char* getSerialOutput();
+
+/*!
+ * \brief Drop the serial port output.
+*/
+void clearSerialOutput();
+
+
+#endif  /* _host_h_ */
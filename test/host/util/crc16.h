@@ -0,0 +1,42 @@
+/*! \file
+ *  \brief Host stand-in for the AVR CRC header.
+ *  Same computations as the avr-libc inline functions.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#ifndef  _util_crc16_h_
+#define  _util_crc16_h_
+
+#include <inttypes.h>
+
+
+static inline uint16_t _crc16_update( uint16_t Crc, uint8_t Data )
+{
+  Crc ^= Data;
+  for (uint8_t Bit = 0; Bit < 8; Bit++)
+    Crc = (Crc & 1) ? (Crc >> 1) ^ 0xA001 : (Crc >> 1);
+  return Crc;
+}
+
+
+static inline uint16_t _crc_ccitt_update( uint16_t Crc, uint8_t Data )
+{
+  Data ^= (uint8_t)Crc;
+  Data ^= (uint8_t)(Data << 4);
+  return ((((uint16_t)Data << 8) | (Crc >> 8)) ^ (uint8_t)(Data >> 4) ^ ((uint16_t)Data << 3));
+}
+
+
+#endif  /* _util_crc16_h_ */
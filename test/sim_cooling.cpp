@@ -0,0 +1,98 @@
+/*! \file
+ *  \brief Cooling actuator simulation.
+ *  Host program running the Pb-free reflow profile through the controller on the mock converter oven model (see
+ *  #TC_DEVICE_MOCK), in simulated time. Built with and without #PIN_COOLER, comparing both shows the cycle time the
+ *  cooling actuator saves. It prints one JSON object with the time spent in each phase, and exits with a non zero
+ *  status when the run does not complete.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host.h"
+#include <TextConsole.h>
+#include "VLOvenController.h"
+
+
+#define SIM_STEP                (10)      /*!< \brief Simulation step in <b>ms</b>, the controller cycle periode. */
+#define SIM_TIMEOUT             (3600000UL) /*!< \brief Longest simulated run in <b>ms</b>. */
+
+/*! \brief Pb-free reflow profile, as registered by the sketch. */
+static VLOvenControllerPhase_t PHASES[] =
+{
+  { "Preheat-1",  50.0,   2.0,  0 },
+  { "Preheat-2",  150.0,  2.0,  0 },
+  { "Soak-1",     200.0,  0.0,  100 },
+  { "Soak-2",     217.0,  2.0,  0 },
+  { "Reflow-1",   245.0,  0.0,  20 },
+  { "Reflow-2",   217.0,  0.0,  20 },
+  { "Cooling",    100.0,  -3.0, 0 },
+  { "Done(HOT)",  50.0,   -10.0, 0 }
+};
+#define PHASES_COUNT            (sizeof(PHASES) / sizeof(PHASES[ 0 ]))
+
+static char s_ConsoleBuffer[ 64 ];        /*!< \brief Console input buffer, no input is given. */
+
+
+int main()
+{
+  TextConsole Console( Serial, s_ConsoleBuffer, sizeof(s_ConsoleBuffer), NULL );
+  VLOvenShield Shield;
+  VLOvenController Controller( Shield, Console );
+  unsigned long PhaseTime[ PHASES_COUNT ] = { 0 };
+  unsigned long StartTime;
+
+  Shield.begin();
+  Controller.begin();
+  Controller.SetPIDTunings( PID_KP, PID_KI, PID_KD );
+
+  // Readings settled before starting.
+  for (unsigned long Time = 0; Time < 2000; Time += SIM_STEP)
+  {
+    advanceMillis( SIM_STEP );
+    Controller.doCycle();
+  }
+
+  Controller.setPhases( PHASES, PHASES_COUNT );
+  if (!Controller.Start())
+  {
+    printf( "FAIL start\n" );
+    return EXIT_FAILURE;
+  }
+
+  StartTime = millis();
+  while (Controller.getRuning() && (millis() - StartTime < SIM_TIMEOUT))
+  {
+    const VLOvenControllerPhase_t* lpPhase = Controller.getCurrentPhase();
+
+    if (lpPhase != NULL)
+      PhaseTime[ lpPhase - PHASES ] += SIM_STEP;
+    advanceMillis( SIM_STEP );
+    Controller.doCycle();
+    clearSerialOutput();
+  }
+
+#if defined(PIN_COOLER)
+  printf( "{ \"sim\": \"cooling\", \"cooler\": true, \"phases\": {" );
+#else
+  printf( "{ \"sim\": \"cooling\", \"cooler\": false, \"phases\": {" );
+#endif
+  for (size_t Index = 0; Index < PHASES_COUNT; Index++)
+    printf( "%s \"%s\": %.1f", (Index > 0) ? "," : "", PHASES[ Index ].Name, PhaseTime[ Index ] / 1000.0 );
+  printf( " }, \"cycle_s\": %.1f, \"completed\": %s }\n", (millis() - StartTime) / 1000.0,
+          Controller.getRuning() ? "false" : "true" );
+
+  return Controller.getRuning() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+/*! \file
+ *  \brief Sliding window statistics soak test.
+ *  Host program feeding 10^8 samples to VLOvenStatistics built with \c float arithmetic, like the AVR \c double,
+ *  and checking its mean and variance against an exact recomputation of the window all along the run. It exits
+ *  with a non zero status when the error goes over the bounds.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <arduino.h>
+
+// the AVR double is a 32 bits float, build the template the way the sketch gets it
+#define double float
+#include "VLOvenStatistics.h"
+#undef double
+
+
+#define SOAK_SAMPLES            (100000000L)  /*!< \brief Samples fed to each window. */
+#define SOAK_CHECK_PERIOD       (1000003L)    /*!< \brief Samples between checks, prime so the checks fall anywhere in the window. */
+#define SOAK_MAX_MEAN_ERROR     (1e-3)        /*!< \brief Largest mean error allowed, in degrees C. */
+#define SOAK_MAX_VARIANCE_ERROR (1e-3)        /*!< \brief Largest variance error allowed, in degrees C squared. */
+
+
+/*!
+ * \brief Runs the soak test on one window.
+ * The samples are a slow 200 +/- 50 degrees C swing plus 0 to 10 degrees C of noise, a long hot phase.
+ *
+ * \param lpName Window description for the report.
+ * \param Statistics Statistics under test, its window length is the one checked.
+ * \return Returns \c true when the errors stayed within the bounds.
+*/
+template <typename S>
+static bool soak( const char* lpName, S& Statistics )
+{
+  uint16_t Length = Statistics.getLength();
+  float* lpWindow = new float[ Length ];
+  uint32_t Random = 12345;
+  long double WorstMean = 0;
+  long double WorstVariance = 0;
+
+  for (long Sample = 0; Sample < SOAK_SAMPLES; Sample++)
+  {
+    float Value;
+
+    Random = Random * 1664525UL + 1013904223UL;
+    Value = 200.0f + 50.0f * sinf( Sample * 1e-6f ) + ((Random >> 16) % 1000) / 100.0f;
+    Statistics.addValue( Value );
+    lpWindow[ Sample % Length ] = Value;
+
+    if ((Sample >= Length) && (Sample % SOAK_CHECK_PERIOD == 0))
+    {
+      long double Mean = 0;
+      long double Variance = 0;
+
+      for (uint16_t Index = 0; Index < Length; Index++)
+        Mean += lpWindow[ Index ];
+      Mean /= Length;
+      for (uint16_t Index = 0; Index < Length; Index++)
+        Variance += (lpWindow[ Index ] - Mean) * (lpWindow[ Index ] - Mean);
+      Variance /= Length - 1;
+
+      WorstMean = fmaxl( WorstMean, fabsl( Mean - Statistics.getAverage() ) );
+      WorstVariance = fmaxl( WorstVariance, fabsl( Variance - Statistics.getVariance() ) );
+    }
+  }
+  delete[] lpWindow;
+
+  printf( "%s: %ld samples, worst mean error %.3Lg, worst variance error %.3Lg\n", lpName, SOAK_SAMPLES,
+          WorstMean, WorstVariance );
+  return (WorstMean <= SOAK_MAX_MEAN_ERROR) && (WorstVariance <= SOAK_MAX_VARIANCE_ERROR);
+}
+
+
+int main()
+{
+  // the sensor channel configurations: analog sonde and SPI converter windows
+  static VLOvenStatistics<float, 100> Analog;
+  static VLOvenStatistics<float, 4> Converter;
+  bool Passed = true;
+
+  Passed &= soak( "window 100", Analog );
+  Passed &= soak( "window 4", Converter );
+
+  printf( "%s\n", Passed ? "passed" : "FAILED" );
+  return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
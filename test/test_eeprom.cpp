@@ -0,0 +1,243 @@
+/*! \file
+ *  \brief EEPROM write queue tests.
+ *  Host program checking VLOvenEEPROM on the emulated EEPROM of host.cpp: requests completed in order from the
+ *  ready interrupt, callbacks called from the main loop only, bytes already holding their value not written again,
+ *  moves in both directions over overlapping areas, reads while a request is in progress, and the queue full
+ *  behaviour. It exits with a non zero status on failures.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "VLOvenEEPROM.h"
+
+
+#define PUMP_TIMEOUT            (60000UL) /*!< \brief Longest wait for the queue to empty in <b>ms</b>. */
+
+static unsigned long s_Checks = 0;        /*!< \brief Number of checks made. */
+static unsigned long s_Errors = 0;        /*!< \brief Number of failed checks. */
+
+static char s_Calls[ 16 ];                /*!< \brief Callback contexts, in the order the callbacks were called. */
+static uint8_t s_CallsCount = 0;          /*!< \brief Number of callbacks called. */
+
+/*! \brief Flash data, program memory is plain memory on the host. */
+static const uint8_t FLASH_DATA[] PROGMEM = { 0x10, 0x20, 0x30, 0x40, 0x50 };
+
+
+/*!
+ * \brief Counts a check, and reports it when it failed.
+ *
+ * \param lpCase Test case.
+ * \param lpWhat Failed condition.
+ * \param Passed Check result.
+*/
+static void check( const char* lpCase, const char* lpWhat, bool Passed )
+{
+  s_Checks++;
+  if (!Passed)
+  {
+    s_Errors++;
+    printf( "FAIL %s: %s\n", lpCase, lpWhat );
+  }
+}
+
+
+/*!
+ * \brief Completion callback recording its context.
+ * \param lpContext Character naming the request.
+*/
+static void onDone( void* lpContext )
+{
+  if (s_CallsCount < sizeof(s_Calls) - 1)
+    s_Calls[ s_CallsCount++ ] = (char)(uintptr_t)lpContext;
+  s_Calls[ s_CallsCount ] = '\0';
+}
+
+
+/*!
+ * \brief Runs the main loop until every request is completed and its callback called.
+ * \return Returns \c false when the queue did not empty in time.
+*/
+static bool pump()
+{
+  for (unsigned long Time = 0; Time < PUMP_TIMEOUT; Time++)
+  {
+    VLOvenEEPROM::doCycle();
+    if (VLOvenEEPROM::isIdle())
+      return true;
+    advanceMillis( 1 );
+  }
+  return false;
+}
+
+
+/*! \brief Requests are completed in queue order, callbacks only run from the main loop. */
+static void testOrder()
+{
+  static const char TEXT[] = "Reflow";
+  uint8_t* lpMemory = getEEPROM();
+
+  s_CallsCount = 0;
+  VLOvenEEPROM::fill( 0, 0xAA, 16, onDone, (void*)'a' );
+  VLOvenEEPROM::write( 4, TEXT, sizeof(TEXT), onDone, (void*)'b' );
+  VLOvenEEPROM::write_P( 8, FLASH_DATA, sizeof(FLASH_DATA), onDone, (void*)'c' );
+  check( "order", "no callback before the main loop runs", s_CallsCount == 0 );
+
+  // Interrupts only, the requests complete but the callbacks wait.
+  advanceMillis( 1000 );
+  check( "order", "no callback from the interrupt", s_CallsCount == 0 );
+  check( "order", "entries held until the callbacks run", VLOvenEEPROM::getFree() == EEPROM_QUEUE_LENGTH - 3 );
+
+  check( "order", "completed", pump() );
+  check( "order", "callbacks in order", strcmp( s_Calls, "abc" ) == 0 );
+  check( "order", "fill kept before the text", (lpMemory[ 0 ] == 0xAA) && (lpMemory[ 3 ] == 0xAA) );
+  check( "order", "text kept before the flash data", memcmp( lpMemory + 4, TEXT, 4 ) == 0 );
+  check( "order", "flash data last", memcmp( lpMemory + 8, FLASH_DATA, sizeof(FLASH_DATA) ) == 0 );
+  check( "order", "fill after the flash data", (lpMemory[ 13 ] == 0xAA) && (lpMemory[ 15 ] == 0xAA) );
+}
+
+
+/*! \brief Bytes holding their value already are not written, one cell write per interrupt. */
+static void testWear()
+{
+  uint8_t Data[ 64 ];
+  unsigned long Writes;
+
+  for (uint8_t Index = 0; Index < sizeof(Data); Index++)
+    Data[ Index ] = Index * 7;
+  VLOvenEEPROM::write( 100, Data, sizeof(Data) );
+  check( "wear", "first write", pump() );
+
+  // Two cells changed, two cell writes.
+  Writes = getEEPROMWrites();
+  Data[ 5 ] ^= 0xFF;
+  Data[ 60 ] ^= 0xFF;
+  VLOvenEEPROM::write( 100, Data, sizeof(Data) );
+  check( "wear", "second write", pump() );
+  check( "wear", "only the changed cells written", getEEPROMWrites() - Writes == 2 );
+  check( "wear", "data", memcmp( getEEPROM() + 100, Data, sizeof(Data) ) == 0 );
+
+  // The main program keeps running while the cells are written, each takes 3.4 ms.
+  Writes = getEEPROMWrites();
+  VLOvenEEPROM::fill( 100, 0x55, sizeof(Data) );
+  advanceMillis( 40 );
+  check( "wear", "cell write time", (getEEPROMWrites() - Writes >= 10) && (getEEPROMWrites() - Writes <= 12) );
+  check( "wear", "fill", pump() );
+}
+
+
+/*!
+ * \brief Moves over overlapping areas, in both directions, compared with memmove().
+ * \param Target EEPROM location written.
+ * \param Source EEPROM location of the data.
+ * \param Length Number of bytes moved.
+*/
+static void testMove( int Target, int Source, int Length )
+{
+  uint8_t Data[ 256 ];
+  uint8_t Expected[ 256 ];
+  char Case[ 32 ];
+
+  snprintf( Case, sizeof(Case), "move %d<-%d", Target, Source );
+  for (int Index = 0; Index < (int)sizeof(Data); Index++)
+    Data[ Index ] = (Index * 37 + 11) & 0xFF;
+  VLOvenEEPROM::write( 200, Data, sizeof(Data) );
+  check( Case, "setup", pump() );
+
+  memcpy( Expected, Data, sizeof(Data) );
+  memmove( Expected + Target - 200, Expected + Source - 200, Length );
+  VLOvenEEPROM::move( Target, Source, Length );
+  check( Case, "completed", pump() );
+  check( Case, "data", memcmp( getEEPROM() + 200, Expected, sizeof(Expected) ) == 0 );
+}
+
+
+/*! \brief Reads while requests are in progress return the EEPROM contents, and leave the requests going. */
+static void testRead()
+{
+  static uint8_t Data[ 32 ];
+  uint8_t Value;
+  bool Matched = true;
+
+  memset( Data, 0x3C, sizeof(Data) );
+  VLOvenEEPROM::fill( 500, 0, sizeof(Data) );
+  check( "read", "setup", pump() );
+
+  VLOvenEEPROM::write( 500, Data, sizeof(Data) );
+  for (int Step = 0; Step < 40; Step++)
+  {
+    advanceMillis( 2 );
+    Value = VLOvenEEPROM::read( 500 + Step % sizeof(Data) );
+    Matched &= (Value == getEEPROM()[ 500 + Step % sizeof(Data) ]);
+  }
+  check( "read", "contents", Matched );
+  check( "read", "completed", pump() );
+  check( "read", "data", memcmp( getEEPROM() + 500, Data, sizeof(Data) ) == 0 );
+}
+
+
+/*! \brief A full queue refuses requests, until the callbacks of the completed ones are called. */
+static void testQueueFull()
+{
+  static uint8_t Data[ EEPROM_QUEUE_LENGTH + 1 ];
+  bool Queued = true;
+
+  s_CallsCount = 0;
+  for (uint8_t Index = 0; Index < EEPROM_QUEUE_LENGTH; Index++)
+  {
+    Data[ Index ] = Index + 1;
+    Queued &= VLOvenEEPROM::write( 600 + Index, &Data[ Index ], 1, onDone, (void*)(uintptr_t)('0' + Index) );
+  }
+  check( "full", "queue length accepted", Queued );
+  check( "full", "no room", VLOvenEEPROM::getFree() == 0 );
+
+  Data[ EEPROM_QUEUE_LENGTH ] = 0x99;
+  check( "full", "request refused", !VLOvenEEPROM::write( 600 + EEPROM_QUEUE_LENGTH, &Data[ EEPROM_QUEUE_LENGTH ], 1 ) );
+
+  // Completed without the main loop running, still no room.
+  advanceMillis( 200 );
+  check( "full", "room only after the callbacks", VLOvenEEPROM::getFree() == 0 );
+  check( "full", "still refused", !VLOvenEEPROM::fill( 600 + EEPROM_QUEUE_LENGTH, 0x99, 1 ) );
+
+  VLOvenEEPROM::doCycle();
+  check( "full", "room back", VLOvenEEPROM::getFree() == EEPROM_QUEUE_LENGTH );
+  check( "full", "callbacks", strcmp( s_Calls, "01234567" ) == 0 );
+  check( "full", "refused request not written", getEEPROM()[ 600 + EEPROM_QUEUE_LENGTH ] != 0x99 );
+  check( "full", "data", memcmp( getEEPROM() + 600, Data, EEPROM_QUEUE_LENGTH ) == 0 );
+
+  // The ring buffer wraps around.
+  check( "full", "queued after wrapping", VLOvenEEPROM::write( 600, &Data[ EEPROM_QUEUE_LENGTH ], 1 ) );
+  check( "full", "completed after wrapping", pump() && (getEEPROM()[ 600 ] == 0x99) );
+}
+
+
+int main()
+{
+  testOrder();
+  testWear();
+  testMove( 210, 240, 100 );
+  testMove( 240, 210, 100 );
+  testMove( 201, 200, 255 );
+  testMove( 200, 201, 255 );
+  testMove( 220, 220, 50 );
+  testRead();
+  testQueueFull();
+  check( "idle", "interrupt disabled once the queue is empty", !(EECR & _BV(EERIE)) );
+
+  printf( "%lu checks, %lu failures\n", s_Checks, s_Errors );
+  return (s_Errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,211 @@
+/*! \file
+ *  \brief SPI converter tests.
+ *  Host program running mock converters (see #TC_DEVICE_MOCK) through the MAX31855 frame decoding, the fault
+ *  flags included, and through the shield with one board and one air channel, checking that a rejected
+ *  board sensor falls back to the air estimate. It exits with a non zero status on failures.
+ *  The shield is built with the two mock channels given on the command line, see the Makefile.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host.h"
+#include "VLOvenShield.h"
+
+
+#define DECODE_TOLERANCE        (0.3)     /*!< \brief Largest decoding error, in degrees C, the frames hold 0.25 degrees C steps. */
+#define AVERAGE_TOLERANCE       (0.5)     /*!< \brief Largest averaged reading error, in degrees C. */
+
+#define CHANNEL_AIR             0         /*!< \brief Shield channel measuring the air, see the Makefile. */
+#define CHANNEL_PCB             1         /*!< \brief Shield channel attached to the board, see the Makefile. */
+
+static unsigned long s_Checks = 0;        /*!< \brief Number of checks made. */
+static unsigned long s_Errors = 0;        /*!< \brief Number of failed checks. */
+
+
+/*!
+ * \brief Counts a check, and reports it when it failed.
+ *
+ * \param lpCase Case description for the report.
+ * \param Passed Check result.
+*/
+static void check( const char* lpCase, bool Passed )
+{
+  s_Checks++;
+  if (!Passed)
+  {
+    s_Errors++;
+    printf( "FAIL %s\n", lpCase );
+  }
+}
+
+
+/*!
+ * \brief Reads one frame from a converter, once its conversion time elapsed.
+ *
+ * \param Converter Converter to read.
+ * \param lpTemp Buffer receiving the thermocouple temperature.
+ * \param lpColdJunction Buffer receiving the cold junction temperature.
+ * \return Returns the converter fault flags.
+*/
+static int8_t readFrame( VLOvenMAX31855& Converter, float* lpTemp, float* lpColdJunction )
+{
+  advanceMillis( MAX31855_CONVERSION_TIME );
+  Converter.startRead();
+  return Converter.getReading( lpTemp, lpColdJunction );
+}
+
+
+/*!
+ * \brief Frame decoding, from below zero to the top of the type K range.
+*/
+static void testDecode()
+{
+  static const float TEMPERATURES[] = { -100.0, -10.25, 0.0, 25.0, 99.75, 183.0, 217.0, 250.0, 500.0, 1000.0, 1300.0 };
+  VLOvenMAX31855 Converter( 2, TC_DEVICE_MOCK );
+  float Temp;
+  float ColdJunction;
+  char Case[ 80 ];
+
+  Converter.begin();
+
+  // Nothing before the first conversion ends.
+  check( "startRead() during the first conversion", !Converter.startRead() );
+  check( "getReading() without a frame", Converter.getReading( &Temp, &ColdJunction ) == -1 );
+
+  for (size_t Index = 0; Index < sizeof(TEMPERATURES) / sizeof(TEMPERATURES[0]); Index++)
+  {
+    Converter.setMockTemperature( TEMPERATURES[ Index ] );
+    snprintf( Case, sizeof(Case), "decode %.2fC", TEMPERATURES[ Index ] );
+    check( Case, readFrame( Converter, &Temp, &ColdJunction ) == TC_FAULT_NONE );
+    check( Case, fabs( Temp - TEMPERATURES[ Index ] ) <= DECODE_TOLERANCE );
+    check( Case, ColdJunction == TC_MOCK_AMBIENT );
+    check( Case, Converter.getReading( &Temp, NULL ) == -1 );
+  }
+}
+
+
+/*!
+ * \brief Fault flags decoding, the thermocouple temperature is dropped and the cold junction one kept.
+*/
+static void testFaults()
+{
+  static const uint8_t FAULTS[] = { TC_FAULT_OPEN, TC_FAULT_SHORT_GND, TC_FAULT_SHORT_VCC };
+  VLOvenMAX31855 Converter( 2, TC_DEVICE_MOCK );
+  float Temp;
+  float ColdJunction;
+  char Case[ 80 ];
+
+  Converter.begin();
+  Converter.setMockTemperature( 150.0 );
+
+  for (size_t Index = 0; Index < sizeof(FAULTS); Index++)
+  {
+    Converter.setMockFault( FAULTS[ Index ] );
+    snprintf( Case, sizeof(Case), "fault 0x%02X", FAULTS[ Index ] );
+    check( Case, readFrame( Converter, &Temp, &ColdJunction ) == FAULTS[ Index ] );
+    check( Case, isnan( Temp ) );
+    check( Case, ColdJunction == TC_MOCK_AMBIENT );
+  }
+
+  // A floating MISO line sets the reserved bits, nothing in the frame is trusted.
+  Converter.setMockFault( TC_FAULT_NO_DEVICE );
+  check( "fault no device", readFrame( Converter, &Temp, &ColdJunction ) == TC_FAULT_NO_DEVICE );
+  check( "fault no device", isnan( Temp ) && isnan( ColdJunction ) );
+
+  Converter.setMockFault( TC_FAULT_NONE );
+  check( "fault cleared", readFrame( Converter, &Temp, &ColdJunction ) == TC_FAULT_NONE );
+  check( "fault cleared", fabs( Temp - 150.0 ) <= DECODE_TOLERANCE );
+}
+
+
+/*!
+ * \brief Runs the shield with the mock temperatures held, the heater is off so the oven models stay there.
+ *
+ * \param Shield Shield instance.
+ * \param AirTemp Air channel temperature.
+ * \param PCBTemp Board channel temperature.
+ * \param Time Time to run, in ms.
+*/
+static void runShield( VLOvenShield& Shield, float AirTemp, float PCBTemp, unsigned long Time )
+{
+  for (; Time >= TEMP_SAMPLING_TIME; Time -= TEMP_SAMPLING_TIME)
+  {
+    Shield.getConverter( CHANNEL_AIR )->setMockTemperature( AirTemp );
+    Shield.getConverter( CHANNEL_PCB )->setMockTemperature( PCBTemp );
+    advanceMillis( TEMP_SAMPLING_TIME );
+    Shield.doCycle();
+  }
+}
+
+
+/*!
+ * \brief Shield readings, and the board estimate falling back to the air one when the board sensor fails.
+*/
+static void testShield()
+{
+  static const uint8_t FAULTS[] = { TC_FAULT_OPEN, TC_FAULT_SHORT_GND, TC_FAULT_SHORT_VCC };
+  VLOvenShield Shield;
+  char Case[ 80 ];
+
+  Shield.begin();
+  check( "mock converters", (Shield.getConverter( CHANNEL_AIR ) != NULL) && Shield.getConverter( CHANNEL_AIR )->isMock() &&
+    (Shield.getConverter( CHANNEL_PCB ) != NULL) && Shield.getConverter( CHANNEL_PCB )->isMock() );
+
+  runShield( Shield, 120.0, 80.0, 2000 );
+  check( "air reading", fabs( Shield.readTC( CHANNEL_AIR ) - 120.0 ) <= AVERAGE_TOLERANCE );
+  check( "board reading", fabs( Shield.readTC( CHANNEL_PCB ) - 80.0 ) <= AVERAGE_TOLERANCE );
+  check( "air estimate", fabs( Shield.readTC( TC_SOURCE_AIR ) - 120.0 ) <= AVERAGE_TOLERANCE );
+  check( "board estimate", fabs( Shield.readTC( TC_SOURCE_PCB ) - 80.0 ) <= AVERAGE_TOLERANCE );
+  check( "control on the board", Shield.readTC() == Shield.readTC( TC_SOURCE_PCB ) );
+
+  for (size_t Index = 0; Index < sizeof(FAULTS); Index++)
+  {
+    snprintf( Case, sizeof(Case), "board fault 0x%02X", FAULTS[ Index ] );
+    Shield.getConverter( CHANNEL_PCB )->setMockFault( FAULTS[ Index ] );
+
+    // One frame per conversion time, the channel goes once enough of them are bad in a row.
+    runShield( Shield, 120.0, 80.0, (TC_FAULT_SAMPLES + 2) * MAX31855_CONVERSION_TIME );
+    check( Case, Shield.getChannelFault( CHANNEL_PCB ) == FAULTS[ Index ] );
+    check( Case, Shield.getFailedChannels() == (1 << CHANNEL_PCB) );
+    check( Case, isnan( Shield.readTC( CHANNEL_PCB ) ) );
+    check( Case, fabs( Shield.readTC( TC_SOURCE_PCB ) - 120.0 ) <= AVERAGE_TOLERANCE );
+    check( Case, Shield.readTC() == Shield.readTC( TC_SOURCE_AIR ) );
+    check( Case, Shield.getSafety().getFaults() == SAFETY_FAULT_NONE );
+
+    Shield.getConverter( CHANNEL_PCB )->setMockFault( TC_FAULT_NONE );
+    runShield( Shield, 120.0, 80.0, 2000 );
+    check( Case, Shield.getFailedChannels() == 0 );
+    check( Case, fabs( Shield.readTC( TC_SOURCE_PCB ) - 80.0 ) <= AVERAGE_TOLERANCE );
+  }
+
+  // Both gone, nothing left to fall back to.
+  Shield.getConverter( CHANNEL_AIR )->setMockFault( TC_FAULT_OPEN );
+  Shield.getConverter( CHANNEL_PCB )->setMockFault( TC_FAULT_OPEN );
+  runShield( Shield, 120.0, 80.0, (TC_FAULT_SAMPLES + 2) * MAX31855_CONVERSION_TIME );
+  check( "both sensors failed", isnan( Shield.readTC( TC_SOURCE_PCB ) ) && isnan( Shield.readTC( TC_SOURCE_AIR ) ) );
+  check( "both sensors failed", Shield.getSafety().getFaults() == SAFETY_FAULT_SENSOR );
+}
+
+
+int main()
+{
+  testDecode();
+  testFaults();
+  testShield();
+
+  printf( "%lu checks, %lu failures\n", s_Checks, s_Errors );
+  return (s_Errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,471 @@
+/*! \file
+ *  \brief Profile storage tests.
+ *  Host program running the sketch on the emulated EEPROM of host.cpp, driving it through the console as the PC
+ *  does: profile uploads by phase or as a binary image, their checks, and their single pass commit to EEPROM,
+ *  then profile deletes and replacements compacting the list. Every cell write of an edit is taken as a reset
+ *  point, the sketch restarted on the EEPROM left then must find a valid list. It exits with a non zero status on
+ *  failures.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "host.h"
+#include "VLOven.ino"
+
+
+#define PUMP_TIMEOUT            (60000UL) /*!< \brief Longest wait for the EEPROM writes to end in <b>ms</b>. */
+#define WRITE_CHUNK             (24)      /*!< \brief Bytes sent by one \c p \c wr command. */
+
+static unsigned long s_Checks = 0;        /*!< \brief Number of checks made. */
+static unsigned long s_Errors = 0;        /*!< \brief Number of failed checks. */
+static char s_Line[ sizeof(m_ConsoleBuffer) ];  /*!< \brief Command line being sent. */
+
+/*! \brief Stored profiles, EEPROM bytes by name. */
+typedef std::map<std::string, std::string> Images_t;
+
+
+/*!
+ * \brief Counts a check, and reports it when it failed.
+ *
+ * \param lpCase Test case.
+ * \param lpWhat Failed condition.
+ * \param Passed Check result.
+*/
+static void check( const char* lpCase, const char* lpWhat, bool Passed )
+{
+  s_Checks++;
+  if (!Passed)
+  {
+    s_Errors++;
+    printf( "FAIL %s: %s\n", lpCase, lpWhat );
+  }
+}
+
+
+/*!
+ * \brief Runs the sketch main loop until the EEPROM writes and the profile edit are completed.
+ * \return Returns \c false when they did not complete in time.
+*/
+static bool pump()
+{
+  for (unsigned long Time = 0; Time < PUMP_TIMEOUT; Time++)
+  {
+    loop();
+    if (VLOvenEEPROM::isIdle() && !m_Edit.Active)
+      return true;
+    advanceMillis( 1 );
+  }
+  return false;
+}
+
+
+/*!
+ * \brief Runs a console command.
+ * \param lpLine Command line, without the line end.
+ * \return Returns the console output.
+*/
+static const char* command( const char* lpLine )
+{
+  snprintf( s_Line, sizeof(s_Line), "%s\n", lpLine );
+  clearSerialOutput();
+  setSerialInput( s_Line );
+  while (m_Console.hasNewInput())
+    m_Console.handleInput();
+  return getSerialOutput();
+}
+
+
+/*!
+ * \brief Check whether a console command succeeds.
+ * \param lpLine Command line, without the line end.
+ * \return Returns \c true when the response, after the events sent meanwhile, is a success.
+*/
+static bool succeeds( const char* lpLine )
+{
+  const char* lpOutput = command( lpLine );
+
+  while ((strncmp( lpOutput, "EV ", 3 ) == 0) && (strchr( lpOutput, '\n' ) != NULL))
+    lpOutput = strchr( lpOutput, '\n' ) + 1;
+  return strncmp( lpOutput, "OK", 2 ) == 0;
+}
+
+
+/*!
+ * \brief Starts the sketch on an EEPROM holding the default profiles.
+*/
+static void boot()
+{
+  EEPROMFormat();
+  EEPROMRegisterDefaultProfiles();
+  while (!VLOvenEEPROM::isIdle())
+  {
+    advanceMillis( 1 );
+    VLOvenEEPROM::doCycle();
+  }
+  setup();
+  clearSerialOutput();
+}
+
+
+/*!
+ * \brief Restarts the sketch on the EEPROM contents, as #setup() does after a reset.
+ * The hardware set up by the first start is kept, a reset only matters here for what is read from EEPROM.
+*/
+static void restart()
+{
+  FreeProfile( m_ActiveProfile );
+  m_CurrentProfileIndex = -1;
+  if (LoadProfile( m_ActiveProfile, 0 ))
+    m_CurrentProfileIndex = 0;
+  m_Settings.begin( EEPROM_SETTINGS_OFFSET );
+  ApplySettings();
+  m_Controller.getEnergy().begin( EEPROM_ENERGY_OFFSET );
+  m_History.begin( EEPROM_HISTORY_OFFSET );
+}
+
+
+/*!
+ * \brief Check a stored profile against the expected one.
+ * \param Index Profile index.
+ * \param Header Expected header.
+ * \param lpPhases Expected phases.
+ * \return Returns \c true when the stored profile is the same, byte for byte.
+*/
+static bool isStored( int Index, const ProfileHeader_t& Header, const VLOvenControllerPhase_t* lpPhases )
+{
+  ProfileHeader_t Stored;
+  int Offset = LoadProfileHeader( Stored, Index );
+
+  return (Offset > 0) && (memcmp( &Stored, &Header, sizeof(Header) ) == 0) &&
+    (memcmp( getEEPROM() + Offset + sizeof(Header), lpPhases, Header.PhasesCount * sizeof(lpPhases[0]) ) == 0);
+}
+
+
+/*!
+ * \brief Sends a profile image in chunks, as laid out in EEPROM.
+ * \param lpImage Header followed by the phases.
+ * \param Size Image size.
+ * \return Returns \c true when every chunk was accepted.
+*/
+static bool sendImage( const uint8_t* lpImage, int Size )
+{
+  for (int Offset = 0; Offset < Size; Offset += WRITE_CHUNK)
+  {
+    char Line[ sizeof(m_ConsoleBuffer) ];
+    int Length = sprintf( Line, "p wr %d ", Offset );
+
+    for (int Index = Offset; (Index < Offset + WRITE_CHUNK) && (Index < Size); Index++)
+      Length += sprintf( Line + Length, "%02X", lpImage[ Index ] );
+    if (!succeeds( Line ))
+      return false;
+  }
+  return true;
+}
+
+
+/*! \brief A profile uploaded phase by phase is appended once complete and valid. */
+static void testUploadPhases()
+{
+  ProfileHeader_t Header;
+  VLOvenControllerPhase_t Phases[ 2 ];
+  int Count = GetProfilesCount();
+  char Expected[ 32 ];
+
+  check( "phases", "upload started", succeeds( "p up Test 2" ) );
+  check( "phases", "first phase", succeeds( "p ph 0 Heat 150 2 0" ) );
+  check( "phases", "phase out of range refused", !succeeds( "p ph 2 Extra 50 -2 0" ) );
+  check( "phases", "incomplete upload refused", strcmp( command( "p cm" ), "ERR " TEXTCONSOLE_CMDARGOUTOFRANGE "\r\n" ) == 0 );
+  check( "phases", "second phase", succeeds( "p ph 1 Cool 50 -2 0" ) );
+
+  sprintf( Expected, "OK %d\r\n", Count );
+  check( "phases", "committed after the stored ones", strcmp( command( "p cm" ), Expected ) == 0 );
+  check( "phases", "no phase change while storing", !succeeds( "p ph 1 Cool 60 -2 0" ) );
+  check( "phases", "no second commit while storing", !succeeds( "p cm" ) );
+  check( "phases", "stored", pump() );
+  sprintf( Expected, "EV pedit[idx=%d,del=0]\r\n", Count );
+  check( "phases", "completion event", strstr( getSerialOutput(), Expected ) != NULL );
+  check( "phases", "appended", GetProfilesCount() == Count + 1 );
+
+  memset( &Header, 0, sizeof(Header) );
+  strcpy( Header.Name, "Test" );
+  Header.PhasesCount = 2;
+  memset( Phases, 0, sizeof(Phases) );
+  strcpy( Phases[ 0 ].Name, "Heat" );
+  Phases[ 0 ].EndTemp = 150.0;
+  Phases[ 0 ].Slope = 2.0;
+  strcpy( Phases[ 1 ].Name, "Cool" );
+  Phases[ 1 ].EndTemp = 50.0;
+  Phases[ 1 ].Slope = -2.0;
+  check( "phases", "contents", isStored( Count, Header, Phases ) );
+}
+
+
+/*! \brief A profile uploaded as a binary image replaces a stored one, written once, only where it differs. */
+static void testUploadImage()
+{
+  ProfileHeader_t Header;
+  VLOvenControllerPhase_t Phases[ 3 ];
+  uint8_t Image[ sizeof(Header) + sizeof(Phases) ];
+  int Index = GetProfilesCount() - 1;
+  unsigned long Writes;
+  char Line[ 32 ];
+
+  memset( &Header, 0, sizeof(Header) );
+  strcpy( Header.Name, "Blob" );
+  Header.PhasesCount = 3;
+  Header.Limits.PeakMin = 230;
+  Header.Limits.PeakMax = 250;
+  memset( Phases, 0, sizeof(Phases) );
+  strcpy( Phases[ 0 ].Name, "Ramp" );
+  Phases[ 0 ].EndTemp = 180.0;
+  Phases[ 0 ].Slope = 1.5;
+  strcpy( Phases[ 1 ].Name, "Peak" );
+  Phases[ 1 ].EndTemp = 240.0;
+  Phases[ 1 ].Duration = 10;
+  strcpy( Phases[ 2 ].Name, "Down" );
+  Phases[ 2 ].EndTemp = 60.0;
+  Phases[ 2 ].Slope = -3.0;
+
+  // As laid out in EEPROM, the phases right after the header.
+  memcpy( Image, &Header, sizeof(Header) );
+  memcpy( Image + sizeof(Header), Phases, sizeof(Phases) );
+
+  check( "image", "upload started", succeeds( "p up Blob 3" ) );
+  check( "image", "image sent", sendImage( Image, sizeof(Image) ) );
+  check( "image", "past the image refused", !succeeds( "p wr 1000 00" ) );
+  sprintf( Line, "p cm %d", Index );
+  check( "image", "committed in place", succeeds( Line ) );
+  check( "image", "stored", pump() );
+  check( "image", "count kept", GetProfilesCount() == Index + 1 );
+  check( "image", "contents", isStored( Index, Header, Phases ) );
+
+  // The same profile again, only the name byte unlinking and linking the profile is written.
+  Writes = getEEPROMWrites();
+  check( "image", "same upload", succeeds( "p up Blob 3" ) && sendImage( Image, sizeof(Image) ) );
+  check( "image", "same committed", succeeds( Line ) && pump() );
+  check( "image", "unchanged cells not written", getEEPROMWrites() - Writes == 2 );
+  check( "image", "same contents", isStored( Index, Header, Phases ) );
+}
+
+
+/*! \brief Invalid profiles are refused before anything is written. */
+static void testUploadChecks()
+{
+  unsigned long Writes = getEEPROMWrites();
+  int Count = GetProfilesCount();
+
+  check( "checks", "upload started", succeeds( "p up Bad 1" ) );
+  check( "checks", "phase", succeeds( "p ph 0 Hot 900 2 0" ) );
+  check( "checks", "temperature over the limit refused", !succeeds( "p cm" ) );
+  check( "checks", "phase fixed", succeeds( "p ph 0 Hot 200 150 0" ) );
+  check( "checks", "slope over the limit refused", !succeeds( "p cm" ) );
+  check( "checks", "phase fixed again", succeeds( "p ph 0 Hot 200 2 0" ) );
+  check( "checks", "index past the list refused", !succeeds( "p cm 99" ) );
+  check( "checks", "nothing written", (getEEPROMWrites() == Writes) && (GetProfilesCount() == Count) );
+  check( "checks", "empty name refused", !succeeds( "p up" ) );
+  check( "checks", "too many phases refused", !succeeds( "p up Big 99" ) );
+}
+
+
+/*!
+ * \brief Get the stored profiles.
+ * \param Images Receives the EEPROM bytes of each profile, by name.
+ * \param lpNames Receives the profile names in list order, if not \c NULL.
+ * \return Returns \c false when a profile header is malformed.
+*/
+static bool getImages( Images_t& Images, std::vector<std::string>* lpNames = NULL )
+{
+  ProfileHeader_t Header;
+  int Offset;
+
+  for (int Index = 0; (Offset = LoadProfileHeader( Header, Index )) > 0; Index++)
+  {
+    if ((memchr( Header.Name, '\0', sizeof(Header.Name) ) == NULL) || (Header.PhasesCount < 1) ||
+      (Header.PhasesCount > MAX_PROFILE_PHASES))
+      return false;
+
+    Images[ Header.Name ].assign( (const char*)getEEPROM() + Offset, sizeof(Header) + Header.PhasesCount * sizeof(VLOvenControllerPhase_t) );
+    if (lpNames != NULL)
+      lpNames->push_back( Header.Name );
+  }
+  return true;
+}
+
+
+/*!
+ * \brief Check whether the stored profiles list is valid.
+ * \param Known Profiles the list may hold.
+ * \return Returns \c true when the list ends, and holds known profiles only, once each and unchanged.
+*/
+static bool isValid( const Images_t& Known )
+{
+  Images_t Images;
+
+  if (!getImages( Images ) || (FindFreeEEPROMStart() < 0) || ((int)Images.size() != GetProfilesCount()))
+    return false;
+  for (Images_t::const_iterator Image = Images.begin(); Image != Images.end(); ++Image)
+  {
+    if ((Known.count( Image->first ) == 0) || (Known.find( Image->first )->second != Image->second))
+      return false;
+  }
+  return true;
+}
+
+
+/*!
+ * \brief Starts uploading a profile, and sends its phases.
+ * \param lpName Profile name.
+ * \param Count Number of phases.
+ * \return Returns \c true when the upload is ready to commit.
+*/
+static bool upload( const char* lpName, int Count )
+{
+  char Line[ 48 ];
+
+  sprintf( Line, "p up %s %d", lpName, Count );
+  if (!succeeds( Line ))
+    return false;
+  for (int Index = 0; Index < Count; Index++)
+  {
+    sprintf( Line, "p ph %d P%d %d 1 0", Index, Index, 100 + Index );
+    if (!succeeds( Line ))
+      return false;
+  }
+  return true;
+}
+
+
+/*!
+ * \brief Runs a profile edit, restarting the sketch on the EEPROM left after each of its cell writes.
+ *
+ * \param lpCase Test case.
+ * \param lpLine Console command starting the edit.
+ * \param lpExpected Profile names once the edit is completed, comma separated.
+ * \param lpResets Receives the EEPROM left after each cell write, if not \c NULL.
+*/
+static void runEdit( const char* lpCase, const char* lpLine, const char* lpExpected,
+  std::vector<std::string>* lpResets = NULL )
+{
+  Images_t Known;
+  Images_t Images;
+  std::vector<std::string> Resets;
+  std::vector<std::string> Names;
+  std::string Final;
+  std::string List;
+  bool Completed = false;
+  bool Valid = true;
+
+  getImages( Known );
+  check( lpCase, "started", succeeds( lpLine ) );
+  for (unsigned long Time = 0; (Time < PUMP_TIMEOUT) && !Completed; Time++)
+  {
+    unsigned long Writes = getEEPROMWrites();
+
+    advanceMillis( 1 );
+    if (getEEPROMWrites() != Writes)
+      Resets.push_back( std::string( (const char*)getEEPROM(), E2END + 1 ) );
+    loop();
+    Completed = VLOvenEEPROM::isIdle() && !m_Edit.Active;
+  }
+  check( lpCase, "completed", Completed );
+
+  Final.assign( (const char*)getEEPROM(), E2END + 1 );
+  check( lpCase, "headers", getImages( Images, &Names ) );
+  for (size_t Index = 0; Index < Names.size(); Index++)
+    List += (Index ? "," : "") + Names[ Index ];
+  check( lpCase, "profiles", List == lpExpected );
+  Known.insert( Images.begin(), Images.end() );
+  check( lpCase, "profiles unchanged", isValid( Known ) );
+
+  // Profiles keep their bytes whatever the write the EEPROM was left at, the one edited is there whole or not at all.
+  check( lpCase, "cells written", !Resets.empty() );
+  for (size_t Index = 0; Index < Resets.size(); Index++)
+  {
+    memcpy( getEEPROM(), Resets[ Index ].data(), E2END + 1 );
+    restart();
+    Valid &= isValid( Known );
+  }
+  check( lpCase, "valid list after a reset at any write", Valid );
+
+  memcpy( getEEPROM(), Final.data(), E2END + 1 );
+  restart();
+  if (lpResets != NULL)
+    lpResets->swap( Resets );
+}
+
+
+/*! \brief Deletes and replacements move the following profiles down or up. */
+static void testEdits()
+{
+  check( "edits", "delete past the list refused", !succeeds( "p del 9" ) );
+  runEdit( "delete middle", "p del 1", "Oven Controller,Blob" );
+  check( "delete middle", "current profile kept", m_CurrentProfileIndex == 0 );
+
+  check( "grow", "upload", upload( "Large", 6 ) );
+  runEdit( "grow", "p cm 0", "Large,Blob" );
+  check( "shrink", "upload", upload( "Small", 1 ) );
+  runEdit( "shrink", "p cm 0", "Small,Blob" );
+  check( "append", "upload", upload( "Test", 2 ) );
+  runEdit( "append", "p cm", "Small,Blob,Test" );
+
+  check( "delete last", "refused while editing", succeeds( "p del 2" ) && !succeeds( "p del 0" ) );
+  check( "delete last", "completed", pump() && (GetProfilesCount() == 2) );
+  runEdit( "delete first", "p del 0", "Blob" );
+  runEdit( "delete only", "p del 0", "" );
+  check( "delete only", "no current profile", (m_CurrentProfileIndex == -1) && (m_ActiveProfile.lpPhases == NULL) );
+}
+
+
+/*! \brief A list left by a reset in the middle of a move takes new edits. */
+static void testResetMidMove()
+{
+  std::vector<std::string> Resets;
+
+  check( "reset", "upload", upload( "First", 4 ) && succeeds( "p cm" ) && pump() );
+  check( "reset", "upload", upload( "Second", 3 ) && succeeds( "p cm" ) && pump() );
+  check( "reset", "upload", upload( "Third", 2 ) && succeeds( "p cm" ) && pump() );
+  runEdit( "reset", "p del 0", "Second,Third", &Resets );
+  if (Resets.empty())
+    return;
+
+  // The move is under way halfway through the writes, the deleted profile is unlinked and the others not yet moved.
+  memcpy( getEEPROM(), Resets[ Resets.size() / 2 ].data(), E2END + 1 );
+  restart();
+  check( "reset", "list cut at the edited profile", GetProfilesCount() == 0 );
+  check( "reset", "upload after the reset", upload( "Fourth", 2 ) );
+  runEdit( "reset", "p cm", "Fourth" );
+  runEdit( "reset", "p del 0", "" );
+}
+
+
+int main()
+{
+  boot();
+  check( "boot", "default profiles", GetProfilesCount() == 2 );
+
+  testUploadPhases();
+  testUploadImage();
+  testUploadChecks();
+  testEdits();
+  testResetMidMove();
+
+  printf( "%lu checks, %lu failures\n", s_Checks, s_Errors );
+  return (s_Errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
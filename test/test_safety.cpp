@@ -0,0 +1,206 @@
+/*! \file
+ *  \brief Safety supervisor tests.
+ *  Host program injecting faults into the shield through its mock converters (see #TC_DEVICE_MOCK): every
+ *  check of the safety supervisor must latch its fault and cut the heater off, and the heater elements
+ *  overshooting after going off must not be taken for a runaway. It exits with a non zero status on failures.
+ *  The shield is built with the two mock channels given on the command line, see the Makefile.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host.h"
+#include "VLOvenShield.h"
+
+
+#define CHANNEL_AIR             0         /*!< \brief Shield channel measuring the air, see the Makefile. */
+#define CHANNEL_PCB             1         /*!< \brief Shield channel attached to the board, see the Makefile. */
+
+#define BASE_TEMPERATURE        (150.0)   /*!< \brief Temperature in degrees C every case starts from. */
+#define SETTLING_TIME           (2000)    /*!< \brief Time in <b>ms</b> the readings get to settle before a case starts. */
+
+static unsigned long s_Checks = 0;        /*!< \brief Number of checks made. */
+static unsigned long s_Errors = 0;        /*!< \brief Number of failed checks. */
+
+/*! \brief Oven temperature in degrees C, as a function of the time in <b>ms</b> since the case started. */
+typedef float (*TempProfile_t)( unsigned long Time );
+
+
+/*!
+ * \brief Counts a check, and reports it when it failed.
+ *
+ * \param lpCase Case description for the report.
+ * \param Passed Check result.
+*/
+static void check( const char* lpCase, bool Passed )
+{
+  s_Checks++;
+  if (!Passed)
+  {
+    s_Errors++;
+    printf( "FAIL %s\n", lpCase );
+  }
+}
+
+
+static float steady( unsigned long Time ) { return BASE_TEMPERATURE; }
+static float overTemp( unsigned long Time ) { return SAFETY_MAX_TEMPERATURE + 5.0; }
+static float fastRamp( unsigned long Time ) { return BASE_TEMPERATURE + 1.5 * SAFETY_MAX_RATE * Time / 1000.0; }
+static float slowRamp( unsigned long Time ) { return BASE_TEMPERATURE + 0.5 * SAFETY_MAX_RATE * Time / 1000.0; }
+static float slowRise( unsigned long Time ) { return BASE_TEMPERATURE + 2.0 * SAFETY_NORISE_RISE * Time / SAFETY_NORISE_TIME; }
+static float runaway( unsigned long Time ) { return BASE_TEMPERATURE + Time / 1000.0; }
+
+/*! \brief Heater elements giving off their stored heat after going off, 25 degrees C more with a 15 s time constant. */
+static float overshoot( unsigned long Time ) { return BASE_TEMPERATURE + 25.0 * (1.0 - exp( -(Time / 15000.0) )); }
+
+
+/*!
+ * \brief Runs the shield with both channels following a temperature profile, requesting a heater power all along.
+ *
+ * \param Shield Shield instance.
+ * \param lpProfile Temperature profile.
+ * \param HeaterDuty Heater power requested on every pass, in percent.
+ * \param Time Time to run, in ms.
+ * \return Returns the time in <b>ms</b> a fault was first latched, or \c Time when none was.
+*/
+static unsigned long run( VLOvenShield& Shield, TempProfile_t lpProfile, double HeaterDuty, unsigned long Time )
+{
+  unsigned long Trip = Time;
+
+  for (unsigned long Elapsed = 0; Elapsed < Time; Elapsed += TEMP_SAMPLING_TIME)
+  {
+    Shield.getConverter( CHANNEL_AIR )->setMockTemperature( lpProfile( Elapsed ) );
+    Shield.getConverter( CHANNEL_PCB )->setMockTemperature( lpProfile( Elapsed ) );
+    Shield.setHeaterDuty( HeaterDuty );
+    advanceMillis( TEMP_SAMPLING_TIME );
+    Shield.doCycle();
+
+    if ((Trip == Time) && (Shield.getSafety().getFaults() != SAFETY_FAULT_NONE))
+      Trip = Elapsed;
+  }
+  return Trip;
+}
+
+
+/*!
+ * \brief Settles the readings at #BASE_TEMPERATURE with the heater off, then clears the faults.
+ *
+ * \param Shield Shield instance.
+*/
+static void startCase( VLOvenShield& Shield )
+{
+  Shield.getConverter( CHANNEL_AIR )->setMockFault( TC_FAULT_NONE );
+  Shield.getConverter( CHANNEL_PCB )->setMockFault( TC_FAULT_NONE );
+  Shield.getSafety().clear();
+  run( Shield, steady, 0.0, SETTLING_TIME );
+  Shield.getSafety().clear();
+}
+
+
+/*!
+ * \brief Checks a case latched the expected fault, and that the heater stays off until the faults are cleared.
+ *
+ * \param Shield Shield instance.
+ * \param lpCase Case description for the report.
+ * \param Fault Expected \c SAFETY_FAULT_xxx flag.
+*/
+static void checkTrip( VLOvenShield& Shield, const char* lpCase, uint8_t Fault )
+{
+  check( lpCase, (Shield.getSafety().getFaults() & Fault) != 0 );
+  check( lpCase, Shield.getHeaterDuty( 0 ) == 0.0 );
+
+  // Latched: back to normal readings, heater requested at full power.
+  run( Shield, steady, 100.0, SETTLING_TIME );
+  check( lpCase, (Shield.getSafety().getFaults() & Fault) != 0 );
+  check( lpCase, Shield.getHeaterDuty( 0 ) == 0.0 );
+  check( lpCase, getPinState( PIN_SSR ) == LOW );
+}
+
+
+int main()
+{
+  VLOvenShield Shield;
+  unsigned long Trip;
+
+  Shield.begin();
+
+  // The heater really switches while no fault is latched.
+  startCase( Shield );
+  Shield.setHeaterDuty( 100.0 );
+  advanceMillis( 100 );
+  check( "heater on", (Shield.getHeaterDuty( 0 ) == 100.0) && (getPinState( PIN_SSR ) == HIGH) );
+
+  // Over temperature, within one converter frame.
+  startCase( Shield );
+  Trip = run( Shield, overTemp, 50.0, 5000 );
+  check( "overtemp trip time", Trip <= MAX31855_CONVERSION_TIME + TEMP_SAMPLING_TIME );
+  checkTrip( Shield, "overtemp", SAFETY_FAULT_OVERTEMP );
+
+  // Change rate, within two rate intervals.
+  startCase( Shield );
+  Trip = run( Shield, fastRamp, 50.0, 10000 );
+  check( "rate trip time", Trip <= 2 * SAFETY_RATE_INTERVAL + MAX31855_CONVERSION_TIME );
+  checkTrip( Shield, "rate", SAFETY_FAULT_RATE );
+
+  startCase( Shield );
+  run( Shield, slowRamp, 50.0, 10000 );
+  check( "rate within limit", Shield.getSafety().getFaults() == SAFETY_FAULT_NONE );
+
+  // Heater at full power, the temperature not rising.
+  startCase( Shield );
+  Trip = run( Shield, steady, 100.0, 2 * SAFETY_NORISE_TIME );
+  check( "no rise trip time", (Trip >= SAFETY_NORISE_TIME) && (Trip <= SAFETY_NORISE_TIME + 1000) );
+  checkTrip( Shield, "no rise", SAFETY_FAULT_NORISE );
+
+  startCase( Shield );
+  run( Shield, slowRise, 100.0, 4 * SAFETY_NORISE_TIME );
+  check( "rising at full power", Shield.getSafety().getFaults() == SAFETY_FAULT_NONE );
+
+  // Heater off, the temperature going on rising: a welded SSR.
+  startCase( Shield );
+  Trip = run( Shield, runaway, 0.0, SAFETY_RUNAWAY_DELAY + SAFETY_RUNAWAY_TIME );
+  check( "runaway trip time", Trip <= SAFETY_RUNAWAY_DELAY + 1000 * SAFETY_RUNAWAY_RISE + 2000 );
+  checkTrip( Shield, "runaway", SAFETY_FAULT_RUNAWAY );
+
+  // Heater off, the elements overshooting by more than the runaway rise.
+  startCase( Shield );
+  run( Shield, overshoot, 0.0, 5 * SAFETY_RUNAWAY_TIME );
+  check( "overshoot after cut-off", Shield.getSafety().getFaults() == SAFETY_FAULT_NONE );
+
+  // Both sensors open, nothing left to control on.
+  startCase( Shield );
+  Shield.getConverter( CHANNEL_AIR )->setMockFault( TC_FAULT_OPEN );
+  Shield.getConverter( CHANNEL_PCB )->setMockFault( TC_FAULT_OPEN );
+  Trip = run( Shield, steady, 50.0, 5000 );
+  check( "sensor trip time", Trip <= (TC_FAULT_SAMPLES + 2) * MAX31855_CONVERSION_TIME );
+  checkTrip( Shield, "sensor", SAFETY_FAULT_SENSOR );
+
+  // A single sensor open is handled by the fallback, without a fault.
+  startCase( Shield );
+  Shield.getConverter( CHANNEL_PCB )->setMockFault( TC_FAULT_OPEN );
+  run( Shield, steady, 50.0, 5000 );
+  check( "single sensor open", Shield.getSafety().getFaults() == SAFETY_FAULT_NONE );
+
+  // Cleared faults give the heater back.
+  startCase( Shield );
+  Shield.getSafety().trip( SAFETY_FAULT_INJECTED );
+  checkTrip( Shield, "injected", SAFETY_FAULT_INJECTED );
+  Shield.getSafety().clear();
+  Shield.setHeaterDuty( 100.0 );
+  check( "cleared", Shield.getHeaterDuty( 0 ) == 100.0 );
+
+  printf( "%lu checks, %lu failures\n", s_Checks, s_Errors );
+  return (s_Errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
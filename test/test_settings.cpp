@@ -0,0 +1,274 @@
+/*! \file
+ *  \brief Controller settings tests.
+ *  Host program running the sketch on the emulated EEPROM of host.cpp: the console \c c commands parsing and
+ *  range checking the values, the settings applied while running, and the stored record, kept across a restart
+ *  when committed and dropped whole when its CRC, version or values are wrong. It exits with a non zero status
+ *  on failures.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <util/crc16.h>
+#include "host.h"
+#include "VLOven.ino"
+
+
+#define PUMP_TIMEOUT            (60000UL) /*!< \brief Longest wait for the EEPROM writes to end in <b>ms</b>. */
+
+#define RESPONSE_OK             "OK \r\n"
+#define RESPONSE_INVALID        "ERR " TEXTCONSOLE_CMDARGINVALIDOPT "\r\n"
+#define RESPONSE_RANGE          "ERR " TEXTCONSOLE_CMDARGOUTOFRANGE "\r\n"
+
+static unsigned long s_Checks = 0;        /*!< \brief Number of checks made. */
+static unsigned long s_Errors = 0;        /*!< \brief Number of failed checks. */
+static char s_Line[ sizeof(m_ConsoleBuffer) ];  /*!< \brief Command line being sent. */
+
+
+/*!
+ * \brief Counts a check, and reports it when it failed.
+ *
+ * \param lpCase Test case.
+ * \param lpWhat Failed condition.
+ * \param Passed Check result.
+*/
+static void check( const char* lpCase, const char* lpWhat, bool Passed )
+{
+  s_Checks++;
+  if (!Passed)
+  {
+    s_Errors++;
+    printf( "FAIL %s: %s\n", lpCase, lpWhat );
+  }
+}
+
+
+/*!
+ * \brief Runs the sketch main loop for a while.
+ * \param Time Number of milliseconds.
+*/
+static void run( unsigned long Time )
+{
+  while (Time--)
+  {
+    advanceMillis( 1 );
+    loop();
+  }
+}
+
+
+/*!
+ * \brief Runs the sketch main loop until the EEPROM writes are completed.
+ * \return Returns \c false when they did not complete in time.
+*/
+static bool pump()
+{
+  for (unsigned long Time = 0; Time < PUMP_TIMEOUT; Time++)
+  {
+    loop();
+    if (VLOvenEEPROM::isIdle())
+      return true;
+    advanceMillis( 1 );
+  }
+  return false;
+}
+
+
+/*!
+ * \brief Runs a console command.
+ * \param lpLine Command line, without the line end.
+ * \return Returns the console output.
+*/
+static const char* command( const char* lpLine )
+{
+  snprintf( s_Line, sizeof(s_Line), "%s\n", lpLine );
+  clearSerialOutput();
+  setSerialInput( s_Line );
+  while (m_Console.hasNewInput())
+    m_Console.handleInput();
+  return getSerialOutput();
+}
+
+
+/*!
+ * \brief Check a console command response.
+ * \param lpLine Command line, without the line end.
+ * \param lpResponse Expected response.
+*/
+static bool responds( const char* lpLine, const char* lpResponse )
+{
+  return strcmp( command( lpLine ), lpResponse ) == 0;
+}
+
+
+/*!
+ * \brief Check whether a console command succeeds.
+ * \param lpLine Command line, without the line end.
+ * \return Returns \c true when the response, after the events sent meanwhile, is a success.
+*/
+static bool succeeds( const char* lpLine )
+{
+  const char* lpOutput = command( lpLine );
+
+  while ((strncmp( lpOutput, "EV ", 3 ) == 0) && (strchr( lpOutput, '\n' ) != NULL))
+    lpOutput = strchr( lpOutput, '\n' ) + 1;
+  return strncmp( lpOutput, "OK", 2 ) == 0;
+}
+
+
+/*!
+ * \brief Starts the sketch on a formatted EEPROM.
+*/
+static void boot()
+{
+  EEPROMFormat();
+  EEPROMRegisterDefaultProfiles();
+  while (!VLOvenEEPROM::isIdle())
+  {
+    advanceMillis( 1 );
+    VLOvenEEPROM::doCycle();
+  }
+  setup();
+  clearSerialOutput();
+}
+
+
+/*!
+ * \brief Stores a settings record as it is, then loads it the way the sketch does on startup.
+ * \param Record Settings record.
+ * \param FixCrc The record CRC is computed first.
+ * \return Returns \c true when the record is accepted.
+*/
+static bool load( VLOvenSettings_t Record, bool FixCrc )
+{
+  VLOvenSettings Settings;
+
+  if (FixCrc)
+  {
+    Record.Crc = 0xFFFF;
+    for (uint8_t Index = 0; Index < offsetof( VLOvenSettings_t, Crc ); Index++)
+      Record.Crc = _crc_ccitt_update( Record.Crc, ((const uint8_t*)&Record)[ Index ] );
+  }
+  memcpy( getEEPROM() + EEPROM_SETTINGS_OFFSET, &Record, sizeof(Record) );
+  return Settings.begin( EEPROM_SETTINGS_OFFSET ) && (memcmp( &Settings.get(), &Record, sizeof(Record) ) == 0);
+}
+
+
+/*! \brief Values are parsed whole, and checked against the setting range. */
+static void testParse()
+{
+  check( "parse", "float", responds( "c set kp 2.5", RESPONSE_OK ) );
+  check( "parse", "float read back", responds( "c get kp", "OK cfg[kp=2.5000]\r\n" ) );
+  check( "parse", "exponent", responds( "c set ki 5e-2", RESPONSE_OK ) && responds( "c get ki", "OK cfg[ki=0.0500]\r\n" ) );
+  check( "parse", "integer rounded", responds( "c set avg 2.6", RESPONSE_OK ) && responds( "c get avg", "OK cfg[avg=3]\r\n" ) );
+
+  check( "parse", "letters refused", responds( "c set ki abc", RESPONSE_INVALID ) );
+  check( "parse", "trailing letters refused", responds( "c set kp 3OO", RESPONSE_INVALID ) );
+  check( "parse", "trailing dot refused", responds( "c set kp 3..", RESPONSE_INVALID ) );
+  check( "parse", "sign alone refused", responds( "c set kp -", RESPONSE_INVALID ) );
+  check( "parse", "unknown name refused", responds( "c set xx 1", RESPONSE_INVALID ) );
+  check( "parse", "refused value unchanged", responds( "c get kp", "OK cfg[kp=2.5000]\r\n" ) );
+
+  check( "parse", "under the range refused", responds( "c set kp -1", RESPONSE_RANGE ) );
+  check( "parse", "over the range refused", responds( "c set ki 100.5", RESPONSE_RANGE ) );
+  check( "parse", "range ends accepted", responds( "c set ki 100", RESPONSE_OK ) && responds( "c set pidt 50", RESPONSE_OK ) );
+  check( "parse", "nan refused", responds( "c set kd nan", RESPONSE_RANGE ) );
+  check( "parse", "infinity refused", responds( "c set kd inf", RESPONSE_RANGE ) );
+  check( "parse", "integer past its type refused", responds( "c set prft 70000", RESPONSE_RANGE ) );
+  check( "parse", "arguments count", responds( "c set kp", "ERR " TEXTCONSOLE_CMDARGSCOUNT "\r\n" ) );
+
+  check( "parse", "defaults", responds( "c def", RESPONSE_OK ) && responds( "c get kp", "OK cfg[kp=300.0000]\r\n" ) );
+}
+
+
+/*! \brief Settings apply while running, except those changing the run as a whole. */
+static void testRunning()
+{
+  // Readings settled before starting.
+  run( 2000 );
+  check( "running", "started", succeeds( "p on" ) );
+
+  check( "running", "lead time refused", responds( "c set lead 100", RESPONSE_INVALID ) );
+  check( "running", "defaults refused", responds( "c def", RESPONSE_INVALID ) );
+  check( "running", "gains accepted", responds( "c set kp 250", RESPONSE_OK ) );
+
+  // The telemetry stops as soon as it is turned off.
+  clearSerialOutput();
+  run( 2000 );
+  check( "running", "telemetry sent", strstr( getSerialOutput(), "EV pid[" ) != NULL );
+  check( "running", "telemetry off", responds( "c set tlm 0", RESPONSE_OK ) );
+  clearSerialOutput();
+  run( 2000 );
+  check( "running", "no telemetry", strstr( getSerialOutput(), "EV pid[" ) == NULL );
+
+  check( "running", "stopped", succeeds( "p off" ) );
+  check( "running", "lead time accepted once stopped", responds( "c set lead 100", RESPONSE_OK ) );
+  check( "running", "defaults", responds( "c def", RESPONSE_OK ) );
+}
+
+
+/*! \brief The committed record is loaded on the next start, a wrong record is dropped whole. */
+static void testRecord()
+{
+  VLOvenSettings_t Record;
+  VLOvenSettings Settings;
+  VLOvenSettings Defaults;
+
+  check( "record", "changed", responds( "c set kp 123.5", RESPONSE_OK ) && responds( "c set avg 4", RESPONSE_OK ) );
+  check( "record", "modified", strstr( command( "c" ), "mod=1]" ) != NULL );
+  check( "record", "committed", responds( "c cm", RESPONSE_OK ) && pump() );
+  check( "record", "not modified", strstr( command( "c" ), "mod=0]" ) != NULL );
+
+  check( "record", "loaded", Settings.begin( EEPROM_SETTINGS_OFFSET ) );
+  check( "record", "values", (Settings.getValue( VLOvenSettings::find( "kp" ) ) == 123.5) &&
+    (Settings.getValue( VLOvenSettings::find( "avg" ) ) == 4) );
+
+  Record = Settings.get();
+  check( "record", "stored record accepted", load( Record, false ) );
+
+  Record.Kp = 124.0;
+  check( "record", "wrong CRC dropped", !load( Record, false ) );
+  check( "record", "changed value with its CRC accepted", load( Record, true ) );
+
+  Record.Version = SETTINGS_VERSION + 1;
+  check( "record", "other version dropped", !load( Record, true ) );
+
+  Record = Settings.get();
+  Record.Ki = 1000.0;
+  check( "record", "value out of range dropped", !load( Record, true ) );
+
+  Record = Settings.get();
+  Record.PIDSampleTime = 0;
+  check( "record", "value under the range dropped", !load( Record, true ) );
+
+  // A dropped record leaves the built-in defaults.
+  check( "record", "defaults kept", !Defaults.begin( EEPROM_SETTINGS_OFFSET ) &&
+    (Defaults.getValue( VLOvenSettings::find( "kp" ) ) == PID_KP) );
+}
+
+
+int main()
+{
+  boot();
+  check( "boot", "defaults", responds( "c get kp", "OK cfg[kp=300.0000]\r\n" ) );
+
+  testParse();
+  testRunning();
+  testRecord();
+
+  printf( "%lu checks, %lu failures\n", s_Checks, s_Errors );
+  return (s_Errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,165 @@
+/*! \file
+ *  \brief Sliding window statistics tests.
+ *  Host program checking VLOvenStatistics against a brute force computation over a copy of the window: count,
+ *  elements, min, max, median, mean and variance after every value, with the window length changed and the
+ *  statistics cleared along the way. It exits with a non zero status on mismatches.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <arduino.h>
+
+// the AVR double is a 32 bits float, build the template the way the sketch gets it
+#define double float
+#include "VLOvenStatistics.h"
+#undef double
+
+
+#define MAX_REPORTED_ERRORS     (20)      /*!< \brief Mismatches printed before the rest are only counted. */
+#define TEST_SAMPLES            (200000L) /*!< \brief Values fed to each window. */
+#define LENGTH_PERIOD           (331)     /*!< \brief Values between window length changes. */
+#define CLEAR_PERIOD            (50021)   /*!< \brief Values between clears. */
+#define MAX_RELATIVE_ERROR      (1e-4)    /*!< \brief Largest mean and variance error allowed, relative to the values. */
+
+static unsigned long s_Checks = 0;        /*!< \brief Number of comparisons made. */
+static unsigned long s_Errors = 0;        /*!< \brief Number of mismatches found. */
+
+
+/*!
+ * \brief Counts a check, and reports it when it failed.
+ *
+ * \param lpCase Window description for the report.
+ * \param lpWhat Failed quantity.
+ * \param Sample Sample number.
+ * \param Passed Check result.
+*/
+static void check( const char* lpCase, const char* lpWhat, long Sample, bool Passed )
+{
+  s_Checks++;
+  if (!Passed && (++s_Errors <= MAX_REPORTED_ERRORS))
+    printf( "FAIL %s: %s after sample %ld\n", lpCase, lpWhat, Sample );
+}
+
+
+/*!
+ * \brief Feeds a window and compares it with a brute force computation after every value.
+ * The values are 200 degrees C plus a quarter degree quantized noise, so that equal values are frequent.
+ *
+ * \param lpCase Window description for the report.
+ * \param Statistics Statistics under test.
+ * \param Median The statistics keep the median.
+*/
+template <typename S>
+static void run( const char* lpCase, S& Statistics, bool Median )
+{
+  std::vector<float> History;
+  std::vector<float> Window;
+  uint32_t Random = 7;
+  uint16_t Expected = 0;
+
+  for (long Sample = 0; Sample < TEST_SAMPLES; Sample++)
+  {
+    uint16_t Count;
+    float Value;
+    double Mean = 0.0;
+    double Variance = 0.0;
+    double Middle;
+
+    Random = Random * 1664525UL + 1013904223UL;
+    // Shortening the window drops the oldest values, lengthening it does not bring them back.
+    if (Sample % LENGTH_PERIOD == 0)
+    {
+      Statistics.setLength( 1 + (Random >> 16) % S::getCapacity() );
+      Expected = std::min( Expected, Statistics.getLength() );
+    }
+    if (Sample % CLEAR_PERIOD == 0)
+    {
+      Statistics.clear();
+      History.clear();
+      Expected = 0;
+    }
+
+    Value = 200.0f + ((Random >> 8) % 50) / 4.0f;
+    Statistics.addValue( Value );
+    History.push_back( Value );
+    Expected = std::min<uint16_t>( Expected + 1, Statistics.getLength() );
+
+    Count = Statistics.getCount();
+    check( lpCase, "count", Sample, Count == Expected );
+    if (Count != Expected)
+      continue;
+    Window.assign( History.end() - Count, History.end() );
+
+    for (uint16_t Index = 0; Index < Count; Index++)
+    {
+      if (Statistics.getElement( Index ) != Window[ Index ])
+      {
+        check( lpCase, "elements", Sample, false );
+        break;
+      }
+    }
+
+    check( lpCase, "min", Sample, Statistics.getMin() == *std::min_element( Window.begin(), Window.end() ) );
+    check( lpCase, "max", Sample, Statistics.getMax() == *std::max_element( Window.begin(), Window.end() ) );
+
+    for (uint16_t Index = 0; Index < Count; Index++)
+      Mean += Window[ Index ];
+    Mean /= Count;
+    for (uint16_t Index = 0; Index < Count; Index++)
+      Variance += (Window[ Index ] - Mean) * (Window[ Index ] - Mean);
+    check( lpCase, "mean", Sample, fabs( Statistics.getAverage() - Mean ) <= MAX_RELATIVE_ERROR * Mean );
+    if (Count > 1)
+      check( lpCase, "variance", Sample, fabs( Statistics.getVariance() - Variance / (Count - 1) ) <= MAX_RELATIVE_ERROR * Mean );
+    else
+      check( lpCase, "variance", Sample, isnan( Statistics.getVariance() ) );
+
+    if (Median)
+    {
+      std::sort( Window.begin(), Window.end() );
+      Middle = (Count % 2) ? Window[ Count / 2 ] : ((double)Window[ Count / 2 - 1 ] + Window[ Count / 2 ]) / 2;
+      check( lpCase, "median", Sample, Statistics.getMedian() == (float)Middle );
+    }
+    else
+      check( lpCase, "median", Sample, isnan( Statistics.getMedian() ) );
+  }
+}
+
+
+int main()
+{
+  static VLOvenStatistics<float, 100, STATISTICS_MINMAX | STATISTICS_MEDIAN> Full100;
+  static VLOvenStatistics<float, 7, STATISTICS_MINMAX | STATISTICS_MEDIAN> Full7;
+  static VLOvenStatistics<float, 1, STATISTICS_MINMAX | STATISTICS_MEDIAN> Full1;
+  static VLOvenStatistics<float, 64, STATISTICS_MEDIAN> Median64;
+  static VLOvenStatistics<float, 50> Plain50;
+
+  run( "minmax+median 100", Full100, true );
+  run( "minmax+median 7", Full7, true );
+  run( "minmax+median 1", Full1, true );
+  run( "median 64", Median64, true );
+  run( "plain 50", Plain50, false );
+
+  // Nothing held, nothing to report.
+  Full100.clear();
+  check( "empty", "values", 0, isnan( Full100.getAverage() ) && isnan( Full100.getVariance() ) &&
+    isnan( Full100.getMin() ) && isnan( Full100.getMax() ) && isnan( Full100.getMedian() ) );
+
+  printf( "%lu checks, %lu failures\n", s_Checks, s_Errors );
+  return (s_Errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,256 @@
+/*! \file
+ *  \brief Formatter tests.
+ *  Host program checking the text formatters of utils.cpp against the C library printf. It runs exhaustively
+ *  over the value ranges the sketch displays and exits with a non zero status on the first mismatches.
+ *
+ *  This file is free software; you can redistribute it and/or modify
+ *  it under the terms of GNU Lesser General Public License version 3.0,
+ *  as published by the Free Software Foundation.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+
+#define MAX_REPORTED_ERRORS     (20)      /*!< \brief Mismatches printed before the rest are only counted. */
+
+/*! \brief Field widths every numeric case runs with. */
+static const int8_t WIDTHS[] = { 0, 1, 6, 12, -1, -6, -12 };
+
+static unsigned long s_Checks = 0;        /*!< \brief Number of comparisons made. */
+static unsigned long s_Errors = 0;        /*!< \brief Number of mismatches found. */
+
+
+/*!
+ * \brief Compares a formatter output with the expected text.
+ *
+ * \param lpCase Case description for the report.
+ * \param lpResult Formatter output.
+ * \param lpEnd End address the formatter returned.
+ * \param lpExpected Expected text.
+*/
+static void check( const char* lpCase, const char* lpResult, const char* lpEnd, const char* lpExpected )
+{
+  s_Checks++;
+  if ((strcmp( lpResult, lpExpected ) == 0) && (lpEnd == lpResult + strlen( lpResult )))
+    return;
+
+  if (++s_Errors <= MAX_REPORTED_ERRORS)
+    printf( "FAIL %s: got \"%s\" (end +%d), expected \"%s\"\n", lpCase, lpResult, (int)(lpEnd - lpResult), lpExpected );
+}
+
+
+/*!
+ * \brief Integer formatting, every value in +/-200000 with each width and padding.
+*/
+static void testInt()
+{
+  char Result[ 64 ];
+  char Expected[ 160 ];
+  char Case[ 64 ];
+
+  for (long Value = -200000; Value <= 200000; Value++)
+  {
+    for (size_t Index = 0; Index < sizeof(WIDTHS); Index++)
+    {
+      int8_t Width = WIDTHS[ Index ];
+
+      snprintf( Case, sizeof(Case), "formatInt(%ld, %d, ' ')", Value, Width );
+      snprintf( Expected, sizeof(Expected), "%*ld", Width, Value );
+      check( Case, Result, formatInt( Result, Value, Width ), Expected );
+
+      snprintf( Case, sizeof(Case), "formatInt(%ld, %d, '0')", Value, Width );
+      snprintf( Expected, sizeof(Expected), "%0*ld", Width, Value );
+      check( Case, Result, formatInt( Result, Value, Width, '0' ), Expected );
+    }
+  }
+
+  check( "formatInt(LONG_MIN)", Result, formatInt( Result, -2147483647L - 1, 0 ), "-2147483648" );
+  check( "formatInt(LONG_MAX)", Result, formatInt( Result, 2147483647L, 0 ), "2147483647" );
+}
+
+
+/*!
+ * \brief Fixed point formatting, every value in +/-100000 for scales 0 to 3 and 0 to 4 decimals.
+ * The expected text is built from integers with printf, rounding half away from zero like the formatter.
+*/
+static void testFixed()
+{
+  static const unsigned long POWERS[] = { 1, 10, 100, 1000, 10000 };
+  char Result[ 64 ];
+  char Number[ 64 ];
+  char Expected[ 160 ];
+  char Case[ 80 ];
+
+  for (uint8_t Scale = 0; Scale <= 3; Scale++)
+  {
+    for (uint8_t Decimals = 0; Decimals <= 4; Decimals++)
+    {
+      for (long Value = -100000; Value <= 100000; Value++)
+      {
+        unsigned long Magnitude = (Value < 0) ? -Value : Value;
+        unsigned long Rounded;
+        unsigned long Fraction;
+
+        if (Decimals >= Scale)
+          Rounded = Magnitude * POWERS[ Decimals - Scale ];
+        else
+          Rounded = (Magnitude + POWERS[ Scale - Decimals ] / 2) / POWERS[ Scale - Decimals ];
+        Fraction = Rounded % POWERS[ Decimals ];
+
+        if (Decimals > 0)
+          snprintf( Number, sizeof(Number), "%s%lu.%0*lu", ((Value < 0) && (Rounded != 0)) ? "-" : "",
+                    Rounded / POWERS[ Decimals ], (int)Decimals, Fraction );
+        else
+          snprintf( Number, sizeof(Number), "%s%lu", ((Value < 0) && (Rounded != 0)) ? "-" : "", Rounded );
+
+        for (size_t Index = 0; Index < sizeof(WIDTHS); Index++)
+        {
+          int8_t Width = WIDTHS[ Index ];
+
+          snprintf( Case, sizeof(Case), "formatFixed(%ld, %u, %u, %d)", Value, Scale, Decimals, Width );
+          snprintf( Expected, sizeof(Expected), "%*s", Width, Number );
+          check( Case, Result, formatFixed( Result, Value, Scale, Decimals, Width ), Expected );
+        }
+
+        snprintf( Case, sizeof(Case), "formatFixed(%ld, %u, %u, 12, \"C\")", Value, Scale, Decimals );
+        snprintf( Expected, sizeof(Expected), "%11s%s", Number, "C" );
+        check( Case, Result, formatFixed( Result, Value, Scale, Decimals, 12, "C" ), Expected );
+      }
+    }
+  }
+}
+
+
+/*!
+ * \brief SI prefix formatting, representative cases including the carries into the next prefix.
+*/
+static void testSI()
+{
+  static const struct
+  {
+    long Value;
+    int8_t Exponent;
+    uint8_t Decimals;
+    int8_t Width;
+    const char* lpUnit;
+    const char* lpExpected;
+  } CASES[] = {
+    { 0, 0, 1, 0, "Wh", "0.0Wh" },
+    { 1, 0, 1, 0, "Wh", "1.0Wh" },
+    { 999, 0, 1, 0, "Wh", "999.0Wh" },
+    { 1000, 0, 1, 0, "Wh", "1.0kWh" },
+    { 1500, 0, 1, 0, "Wh", "1.5kWh" },
+    { -2500, 0, 1, 0, "Wh", "-2.5kWh" },
+    { 999500, 0, 1, 0, "Wh", "999.5kWh" },
+    { 999950, 0, 1, 0, "Wh", "1.0MWh" },
+    { 123456789, 0, 1, 0, "Wh", "123.5MWh" },
+    { 1500, -3, 2, 8, "A", "   1.50A" },
+    { 42, -9, 0, -6, "F", "42nF  " },
+    { 5, 9, 1, 0, "W", "5.0GW" },
+  };
+  char Result[ 64 ];
+  char Case[ 64 ];
+
+  for (size_t Index = 0; Index < sizeof(CASES) / sizeof(CASES[0]); Index++)
+  {
+    snprintf( Case, sizeof(Case), "formatSI(%ld, %d, %u, %d)", CASES[Index].Value, CASES[Index].Exponent,
+              CASES[Index].Decimals, CASES[Index].Width );
+    check( Case, Result, formatSI( Result, CASES[Index].Value, CASES[Index].Exponent, CASES[Index].Decimals,
+                                   CASES[Index].Width, CASES[Index].lpUnit ), CASES[Index].lpExpected );
+  }
+}
+
+
+/*!
+ * \brief Text field formatting, cut and padded in both alignments.
+*/
+static void testText()
+{
+  static const char* const TEXTS[] = { "", "a", "abc", "abcdef", "abcdefghijkl" };
+  char Result[ 64 ];
+  char Expected[ 160 ];
+  char Case[ 64 ];
+
+  for (size_t Text = 0; Text < sizeof(TEXTS) / sizeof(TEXTS[0]); Text++)
+  {
+    for (size_t Index = 0; Index < sizeof(WIDTHS); Index++)
+    {
+      int8_t Width = WIDTHS[ Index ];
+      int Length = abs( Width );
+
+      snprintf( Case, sizeof(Case), "formatText(\"%s\", %d)", TEXTS[Text], Width );
+      if (Width == 0)
+        snprintf( Expected, sizeof(Expected), "%s", TEXTS[Text] );
+      else
+        snprintf( Expected, sizeof(Expected), "%*.*s", Width, Length, TEXTS[Text] );
+      check( Case, Result, formatText( Result, TEXTS[Text], Width ), Expected );
+    }
+  }
+
+  check( "formatText(NULL, 3)", Result, formatText( Result, NULL, 3 ), "   " );
+}
+
+
+/*!
+ * \brief Hexadecimal formatting and parsing, every 16 bits value with up to 9 digits.
+*/
+static void testHex()
+{
+  char Result[ 64 ];
+  char Expected[ 160 ];
+  char Case[ 64 ];
+  uint8_t Data[ 8 ];
+
+  for (unsigned long Value = 0; Value <= 0xFFFF; Value++)
+  {
+    for (uint8_t Digits = 0; Digits <= 9; Digits++)
+    {
+      snprintf( Case, sizeof(Case), "formatHex(0x%lX, %u)", Value, Digits );
+      snprintf( Expected, sizeof(Expected), "%0*lX", (int)Digits, Value );
+      check( Case, Result, formatHex( Result, Value, Digits ), Expected );
+    }
+
+    formatHex( Result, Value, 4 );
+    s_Checks++;
+    if ((parseHex( Result, Data, sizeof(Data) ) != 2) || (Data[ 0 ] != (Value >> 8)) || (Data[ 1 ] != (Value & 0xFF)))
+      if (++s_Errors <= MAX_REPORTED_ERRORS)
+        printf( "FAIL parseHex(\"%s\")\n", Result );
+  }
+
+  check( "formatHex(0xFFFFFFFF, 8)", Result, formatHex( Result, 0xFFFFFFFFUL, 8 ), "FFFFFFFF" );
+
+  s_Checks += 4;
+  if ((parseHex( "0aFf", Data, sizeof(Data) ) != 2) || (Data[ 0 ] != 0x0A) || (Data[ 1 ] != 0xFF) ||
+      (parseHex( "abc", Data, sizeof(Data) ) != -1) ||
+      (parseHex( "0g", Data, sizeof(Data) ) != -1) ||
+      (parseHex( "000102", Data, 2 ) != -1))
+  {
+    s_Errors++;
+    printf( "FAIL parseHex() error cases\n" );
+  }
+}
+
+
+int main()
+{
+  testInt();
+  testFixed();
+  testSI();
+  testText();
+  testHex();
+
+  printf( "%lu checks, %lu failures\n", s_Checks, s_Errors );
+  return (s_Errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -16,69 +16,302 @@
  *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include <stdio.h>
 #include <string.h>
 #include "utils.h"
 
 
-static const char* UNITNAMES[] = {
-  "",
-  "m",
-  "u",
-  "n"
+/*! \brief SI prefixes from 10^-9 to 10^9, a blank for none. */
+static const char SIPREFIXES[] = "num kMG";
+
+/*! \brief Hexadecimal digits. */
+static const char HEXDIGITS[] = "0123456789ABCDEF";
+
+/*! \brief Powers of ten fitting in an unsigned long. */
+static const unsigned long POWERSOF10[] = {
+  1UL,
+  10UL,
+  100UL,
+  1000UL,
+  10000UL,
+  100000UL,
+  1000000UL,
+  10000000UL,
+  100000000UL,
+  1000000000UL
 };
 
 
 /*!
- * \brief Float value to string conversion.
- * This functions implements conversion from float to string.
- * 
+ * \brief Write the padded field.
+ *
  * \param lpBuffer Address for the destination buffer.
- * \param MaxLength Destination buffer size in bytes.
- * \param Value Value to convert to string.
- * \param Length Minimum length of the resulting string.
- * \param Decimals Number of digits after the decimal point.
- * \param MagnitudeName Commodity string containing the magnitude name for the value to convert to string.
+ * \param lpText Field text.
+ * \param Length Field text length.
+ * \param lpUnit Text following the field text, \c NULL for none.
+ * \param Width Field width, positive to align to the right, negative to align to the left.
+ * \param Pad Padding character for right alignment.
+ * \return Returns the address of the terminating zero.
 */
-void formatFloat( char* lpBuffer, int MaxLength, float Value, int Length, int Decimals, char* MagnitudeName )
+static char* placeField( char* lpBuffer, const char* lpText, uint8_t Length, const char* lpUnit, int8_t Width, char Pad )
 {
-  char* Sign;
-  int  Count;
-  char* lpFormat = "%s%d.%03d%s%s";
+  uint8_t UnitLength = (lpUnit != NULL) ? strlen( lpUnit ) : 0;
+  uint8_t Field = (Width < 0) ? -Width : Width;
+  uint8_t Fill = (Field > Length + UnitLength) ? Field - Length - UnitLength : 0;
 
-  if (Value >= 0)
-    Sign = "+";
-  else
+  if (Width > 0)
+  {
+    memset( lpBuffer, Pad, Fill );
+    lpBuffer += Fill;
+    Fill = 0;
+  }
+  memmove( lpBuffer, lpText, Length );
+  lpBuffer += Length;
+  memcpy( lpBuffer, lpUnit, UnitLength );
+  lpBuffer += UnitLength;
+  memset( lpBuffer, ' ', Fill );
+  lpBuffer += Fill;
+  *lpBuffer = '\0';
+  return lpBuffer;
+}
+
+
+/*!
+ * \brief Write decimal digits backwards.
+ *
+ * \param lpEnd Address following the last digit.
+ * \param Value Value to write.
+ * \param Digits Minimum number of digits, the value is padded with leading zeros.
+ * \return Returns the address of the first digit.
+*/
+static char* writeDigits( char* lpEnd, unsigned long Value, uint8_t Digits )
+{
+  uint8_t Count = 0;
+
+  do
   {
-    Sign = "-";
-    Value = -Value;
+    *--lpEnd = '0' + (char)(Value % 10);
+    Value /= 10;
+    Count++;
   }
+  while ((Value != 0) || (Count < Digits));
+
+  return lpEnd;
+}
+
+
+/*!
+ * \brief Write a fixed point number backwards.
+ *
+ * \param lpEnd Address following the last character.
+ * \param Units Value magnitude in 1/10^Decimals units.
+ * \param Negative The value is negative, ignored when it rounded to zero.
+ * \param Decimals Number of decimals in \a Units.
+ * \param Zeros Number of zeros to write after the decimals.
+ * \return Returns the address of the first character.
+*/
+static char* writeFixed( char* lpEnd, unsigned long Units, bool Negative, uint8_t Decimals, uint8_t Zeros )
+{
+  char* lpText = lpEnd - Zeros;
+  bool Zero = (Units == 0);
 
-  for (Count = 0; (Count < 3) && (Value < 1.0); Count++)
+  memset( lpText, '0', Zeros );
+  if (Decimals > 0)
   {
-    Value *= 1000.0;
+    lpText = writeDigits( lpText, Units % POWERSOF10[ Decimals ], Decimals );
+    Units /= POWERSOF10[ Decimals ];
   }
+  if (Decimals + Zeros > 0)
+    *--lpText = '.';
+  lpText = writeDigits( lpText, Units, 1 );
+
+  if (Negative && !Zero)
+    *--lpText = '-';
+  return lpText;
+}
+
+
+/*!
+ * \brief Change the number of decimals of a magnitude, rounding half away from zero.
+ *
+ * \param Magnitude Magnitude in 1/10^Scale units.
+ * \param Scale Number of decimals in \a Magnitude.
+ * \param Decimals Number of decimals wanted, the result must fit when it is larger than \a Scale.
+ * \return Returns the magnitude in 1/10^Decimals units.
+*/
+static unsigned long rescale( unsigned long Magnitude, uint8_t Scale, uint8_t Decimals )
+{
+  unsigned long Divisor;
 
-  int Dec = 1;
+  if (Decimals >= Scale)
+    return Magnitude * POWERSOF10[ Decimals - Scale ];
+
+  Divisor = POWERSOF10[ Scale - Decimals ];
+  return Magnitude / Divisor + (((Magnitude % Divisor) >= (Divisor + 1) / 2) ? 1 : 0);
+}
 
-  lpFormat[7] = '0' + Decimals;
 
-  while (Decimals-- > 0)
+char* formatText( char* lpBuffer, const char* lpText, int8_t Width )
+{
+  size_t Length = (lpText != NULL) ? strlen( lpText ) : 0;
+
+  if (Width == 0)
   {
-    Dec *= 10;
+    memmove( lpBuffer, lpText, Length );
+    lpBuffer[ Length ] = '\0';
+    return lpBuffer + Length;
   }
+  if (Length > (size_t)((Width < 0) ? -Width : Width))
+    Length = (Width < 0) ? -Width : Width;
+  return placeField( lpBuffer, lpText, Length, NULL, Width, ' ' );
+}
 
-  int Remainder = ((int)(Value * (float)Dec)) % Dec;
-  if (Remainder < 0)
-    Remainder = 0;
 
-  snprintf( lpBuffer, MaxLength, lpFormat, Sign, (int)Value, Remainder, UNITNAMES[Count], MagnitudeName );
-  Count = strlen( lpBuffer );
-  while ((Count < Length) && (Count < MaxLength))
+char* formatInt( char* lpBuffer, long Value, int8_t Width, char Pad )
+{
+  char Number[ FORMAT_NUMBER_LENGTH ];
+  char* lpEnd = Number + sizeof(Number);
+  char* lpText;
+
+  lpText = writeDigits( lpEnd, (Value < 0) ? 0UL - (unsigned long)Value : (unsigned long)Value, 1 );
+
+  // Zero padding goes between the sign and the digits.
+  if (Value < 0)
   {
-    lpBuffer[Count++] = ' ';
+    if ((Pad == '0') && (Width > 0))
+    {
+      *lpBuffer++ = '-';
+      Width--;
+    }
+    else
+      *--lpText = '-';
   }
-  lpBuffer[Count] = '\0';
+  return placeField( lpBuffer, lpText, lpEnd - lpText, NULL, Width, Pad );
 }
 
 
+char* formatFixed( char* lpBuffer, long Value, uint8_t Scale, uint8_t Decimals, int8_t Width, const char* lpUnit )
+{
+  char Number[ FORMAT_NUMBER_LENGTH ];
+  char* lpEnd = Number + sizeof(Number);
+  char* lpText;
+  unsigned long Magnitude = (Value < 0) ? 0UL - (unsigned long)Value : (unsigned long)Value;
+  uint8_t Zeros = 0;
+
+  if (Scale > 9)
+    Scale = 9;
+  if (Decimals > 9)
+    Decimals = 9;
+
+  // Decimals the value does not hold are zeros, nothing to compute.
+  if (Decimals > Scale)
+  {
+    Zeros = Decimals - Scale;
+    Decimals = Scale;
+  }
+  else
+    Magnitude = rescale( Magnitude, Scale, Decimals );
+
+  lpText = writeFixed( lpEnd, Magnitude, Value < 0, Decimals, Zeros );
+  return placeField( lpBuffer, lpText, lpEnd - lpText, lpUnit, Width, ' ' );
+}
+
+
+char* formatSI( char* lpBuffer, long Value, int8_t Exponent, uint8_t Decimals, int8_t Width, const char* lpUnit )
+{
+  char Number[ FORMAT_NUMBER_LENGTH ];
+  char* lpEnd = Number + sizeof(Number) - 1;
+  char* lpText;
+  unsigned long Magnitude = (Value < 0) ? 0UL - (unsigned long)Value : (unsigned long)Value;
+  unsigned long Units;
+  unsigned long Remaining;
+  int8_t Magnitude10 = Exponent;
+  int8_t Prefix;
+  int8_t Scale;
+
+  if (Decimals > 6)
+    Decimals = 6;
+
+  // Power of ten of the leading digit, rounded down to a prefix.
+  for (Remaining = Magnitude; Remaining >= 10; Remaining /= 10)
+    Magnitude10++;
+  if (Magnitude == 0)
+    Prefix = 0;
+  else if (Magnitude10 >= 0)
+    Prefix = Magnitude10 / 3 * 3;
+  else
+    Prefix = -((2 - Magnitude10) / 3 * 3);
+  if (Prefix < -9)
+    Prefix = -9;
+
+  // Rounding can carry into the next prefix, 999.96 becomes 1.0k rather than 1000.0.
+  for (;;)
+  {
+    if (Prefix > 9)
+      Prefix = 9;
+    Scale = Prefix - Exponent;
+    if (Scale < 0)
+      Units = Magnitude * POWERSOF10[ -Scale ] * POWERSOF10[ Decimals ];
+    else
+      Units = rescale( Magnitude, Scale, Decimals );
+    if ((Units < 1000UL * POWERSOF10[ Decimals ]) || (Prefix == 9))
+      break;
+    Prefix += 3;
+  }
+
+  if (Prefix != 0)
+    *lpEnd++ = SIPREFIXES[ Prefix / 3 + 3 ];
+  lpText = writeFixed( Number + sizeof(Number) - 1, Units, Value < 0, Decimals, 0 );
+  return placeField( lpBuffer, lpText, lpEnd - lpText, lpUnit, Width, ' ' );
+}
+
+
+char* formatHex( char* lpBuffer, unsigned long Value, uint8_t Digits )
+{
+  char Number[ 2 * sizeof(Value) ];
+  char* lpEnd = Number + sizeof(Number);
+  char* lpText = lpEnd;
+
+  if (Digits > sizeof(Number))
+    Digits = sizeof(Number);
+  do
+  {
+    *--lpText = HEXDIGITS[ Value & 0x0F ];
+    Value >>= 4;
+  }
+  while ((Value != 0) || (lpEnd - lpText < Digits));
+
+  return placeField( lpBuffer, lpText, lpEnd - lpText, NULL, 0, ' ' );
+}
+
+
+/*!
+ * \brief Hexadecimal digit value.
+ * \return Returns the digit value, \c -1 for a character other than a hexadecimal digit.
+*/
+static int8_t hexDigit( char Digit )
+{
+  if ((Digit >= '0') && (Digit <= '9'))
+    return Digit - '0';
+  Digit |= 0x20;
+  if ((Digit >= 'a') && (Digit <= 'f'))
+    return Digit - 'a' + 10;
+  return -1;
+}
+
+
+int parseHex( const char* lpText, uint8_t* lpData, int MaxLength )
+{
+  int Count = 0;
+
+  while (*lpText != '\0')
+  {
+    int8_t High = hexDigit( lpText[ 0 ] );
+    int8_t Low = (High >= 0) ? hexDigit( lpText[ 1 ] ) : -1;
+
+    if ((Low < 0) || (Count >= MaxLength))
+      return -1;
+    lpData[ Count++ ] = (uint8_t)((High << 4) | Low);
+    lpText += 2;
+  }
+  return Count;
+}
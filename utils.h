@@ -18,19 +18,87 @@
 #ifndef  _utils_h_
 #define  _utils_h_
 
+#include <stddef.h>
+#include <inttypes.h>
+
+
+#define FORMAT_NUMBER_LENGTH    (24)      /*!< \brief Longest number text the formatters produce, without padding and unit. */
+
+
+/*!
+ * \brief Text field formatting.
+ * Copies a text into a fixed width field, padded with blanks. The text is cut when longer than the field.
+ *
+ * \param lpBuffer Address for the destination buffer, it must hold the field and the terminating zero.
+ * \param lpText Text to copy, \c NULL for an empty field.
+ * \param Width Field width, positive to align the text to the right, negative to align it to the left,
+ *        \c 0 to copy the whole text without padding.
+ * \return Returns the address of the terminating zero, where further text can be appended.
+*/
+extern char* formatText( char* lpBuffer, const char* lpText, int8_t Width );
+
+/*!
+ * \brief Integer value formatting.
+ * Writes an integer in decimal into a field, never cut when longer than the field.
+ *
+ * \param lpBuffer Address for the destination buffer.
+ * \param Value Value to write.
+ * \param Width Field width, positive to align the number to the right, negative to align it to the left.
+ * \param Pad Padding character for right alignment, a \c '0' goes after the sign.
+ * \return Returns the address of the terminating zero, where further text can be appended.
+*/
+extern char* formatInt( char* lpBuffer, long Value, int8_t Width, char Pad = ' ' );
+
+/*!
+ * \brief Fixed point value formatting.
+ * Writes a fixed point integer as a decimal number, rounded half away from zero to the requested
+ * number of decimals, followed by an optional unit counted in the field width.
+ *
+ * \param lpBuffer Address for the destination buffer.
+ * \param Value Value to write, in 1/10^Scale units.
+ * \param Scale Number of decimals \a Value holds, up to 9.
+ * \param Decimals Number of digits to write after the decimal point, up to 9.
+ * \param Width Field width, positive to align to the right, negative to align to the left.
+ * \param lpUnit Unit appended to the number, \c NULL for none.
+ * \return Returns the address of the terminating zero, where further text can be appended.
+*/
+extern char* formatFixed( char* lpBuffer, long Value, uint8_t Scale, uint8_t Decimals, int8_t Width, const char* lpUnit = NULL );
+
+/*!
+ * \brief Value formatting with a SI prefix.
+ * Writes \a Value * 10^Exponent with the prefix from \c n to \c G that leaves between 1 and 999 units
+ * before the decimal point, e.g. 1500 with exponent 0 and unit "Wh" gives "1.5kWh".
+ *
+ * \param lpBuffer Address for the destination buffer.
+ * \param Value Value mantissa.
+ * \param Exponent Power of ten \a Value is expressed in, from -9 to 9.
+ * \param Decimals Number of digits to write after the decimal point.
+ * \param Width Field width, positive to align to the right, negative to align to the left.
+ * \param lpUnit Unit written after the prefix, \c NULL for none.
+ * \return Returns the address of the terminating zero, where further text can be appended.
+*/
+extern char* formatSI( char* lpBuffer, long Value, int8_t Exponent, uint8_t Decimals, int8_t Width, const char* lpUnit = NULL );
 
 /*!
- * \brief Float value to string conversion.
- * This functions implements conversion from float to string.
- * 
+ * \brief Hexadecimal value formatting.
+ * Writes an unsigned value with upper case hexadecimal digits.
+ *
  * \param lpBuffer Address for the destination buffer.
+ * \param Value Value to write.
+ * \param Digits Minimum number of digits, the value is padded with leading zeros.
+ * \return Returns the address of the terminating zero, where further text can be appended.
+*/
+extern char* formatHex( char* lpBuffer, unsigned long Value, uint8_t Digits );
+
+/*!
+ * \brief Hexadecimal text to binary conversion.
+ *
+ * \param lpText Text holding two hexadecimal digits per byte, upper or lower case.
+ * \param lpData Address for the destination buffer.
  * \param MaxLength Destination buffer size in bytes.
- * \param Value Value to convert to string.
- * \param Length Minimum length of the resulting string.
- * \param Decimals Number of digits after the decimal point.
- * \param MagnitudeName Commodity string containing the magnitude name for the value to convert to string.
+ * \return Returns the number of bytes converted, \c -1 when the text has an odd length, a character other than
+ *         a hexadecimal digit or does not fit the buffer.
 */
-extern void formatFloat( char* lpBuffer, int MaxLength, float Value, int Length, int Decimals, char* MagnitudeName );
+extern int parseHex( const char* lpText, uint8_t* lpData, int MaxLength );
 
 #endif  /* _utils_h_ */
-